@@ -0,0 +1,273 @@
+/**
+ * @file alu_table.c
+ * @brief Table-driven ALU for GameBoy Emulator
+ *
+ * @date 2020
+ */
+#include "alu_table.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define NB_VALUES 256
+#define NB_DIRS   2 // LEFT, RIGHT
+#define NB_CARRY  2
+
+// 8 bit arithmetic, indexed by [carry][x][y]
+static alu_table_entry_t add8_table[NB_CARRY][NB_VALUES][NB_VALUES];
+static alu_table_entry_t sub8_table[NB_CARRY][NB_VALUES][NB_VALUES];
+
+// single operand operations, indexed by [x] (and direction/carry when needed)
+static alu_table_entry_t inc8_table[NB_VALUES];
+static alu_table_entry_t dec8_table[NB_VALUES];
+static alu_table_entry_t shift_table[NB_DIRS][NB_VALUES];
+static alu_table_entry_t shiftR_A_table[NB_VALUES];
+static alu_table_entry_t rotate_table[NB_DIRS][NB_VALUES];
+static alu_table_entry_t carry_rotate_table[NB_DIRS][NB_CARRY][NB_VALUES];
+static alu_table_entry_t swap4_table[NB_VALUES];
+
+// DAA, indexed by [N,H,C][A]
+static alu_table_entry_t daa_table[ALU_TABLE_DAA_FLAGS][NB_VALUES];
+
+// generated once, by whichever thread (a CPU being initialised) comes first
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+static int tables_error = ERR_NONE;
+static atomic_int tables_ready = 0; // set (release) once all the tables are stored
+
+/**
+ * @brief Generates the tables on first use, so that a lookup never reads an empty table
+ */
+#define M_REQUIRE_TABLES() \
+    do { \
+        if (!atomic_load_explicit(&tables_ready, memory_order_acquire)) { \
+            M_EXIT_IF_ERR(alu_table_init()); \
+        } \
+    } while(0)
+
+/**
+ * @brief Stores a reference ALU result into a table entry
+ */
+#define store_entry(entry, output) \
+    do { \
+        (entry).value = lsb8((output).value); \
+        (entry).flags = (output).flags; \
+    } while(0)
+
+/**
+ * @brief Writes a table entry into an ALU result.
+ *        accumulate_entry keeps the flags already in result (like the reference
+ *        functions that only set flags), assign_entry replaces them.
+ *        The entry is read once, as its index may depend on result.
+ */
+#define accumulate_entry(result, entry) \
+    do { \
+        const alu_table_entry_t entry_ = (entry); \
+        (result)->value = entry_.value; \
+        (result)->flags |= entry_.flags; \
+    } while(0)
+
+#define assign_entry(result, entry) \
+    do { \
+        const alu_table_entry_t entry_ = (entry); \
+        (result)->value = entry_.value; \
+        (result)->flags = entry_.flags; \
+    } while(0)
+
+#define IS_VALID_DIR(dir) ((dir) == LEFT || (dir) == RIGHT)
+
+// ======================================================================
+/**
+ * @brief Generates all the ALU tables (run once, see alu_table_init())
+ */
+static int generate_tables(void)
+{
+    for (int x = 0; x < NB_VALUES; ++x) {
+        alu_output_t out = {0, 0};
+
+        for (int c = 0; c < NB_CARRY; ++c) {
+            for (int y = 0; y < NB_VALUES; ++y) {
+                out.flags = 0;
+                M_EXIT_IF_ERR(alu_add8(&out, (uint8_t) x, (uint8_t) y, (bit_t) c));
+                store_entry(add8_table[c][x][y], out);
+
+                out.flags = 0;
+                M_EXIT_IF_ERR(alu_sub8(&out, (uint8_t) x, (uint8_t) y, (bit_t) c));
+                store_entry(sub8_table[c][x][y], out);
+            }
+        }
+
+        inc8_table[x] = add8_table[0][x][1];
+        dec8_table[x] = sub8_table[0][x][1];
+
+        for (rot_dir_t dir = LEFT; dir <= RIGHT; ++dir) {
+            out.flags = 0;
+            M_EXIT_IF_ERR(alu_shift(&out, (uint8_t) x, dir));
+            store_entry(shift_table[dir][x], out);
+
+            out.flags = 0;
+            M_EXIT_IF_ERR(alu_rotate(&out, (uint8_t) x, dir));
+            store_entry(rotate_table[dir][x], out);
+
+            for (int c = 0; c < NB_CARRY; ++c) {
+                M_EXIT_IF_ERR(alu_carry_rotate(&out, (uint8_t) x, dir, c ? FLAG_C : 0));
+                store_entry(carry_rotate_table[dir][c][x], out);
+            }
+        }
+
+        M_EXIT_IF_ERR(alu_shiftR_A(&out, (uint8_t) x));
+        store_entry(shiftR_A_table[x], out);
+
+        M_EXIT_IF_ERR(alu_swap4(&out, (uint8_t) x));
+        store_entry(swap4_table[x], out);
+
+        for (int f = 0; f < ALU_TABLE_DAA_FLAGS; ++f) {
+            out.value = (uint16_t) x;
+            out.flags = (flags_t) ((f & 4 ? FLAG_N : 0) | (f & 2 ? FLAG_H : 0) | (f & 1 ? FLAG_C : 0));
+            M_EXIT_IF_ERR(alu_bcd_adjust(&out));
+            store_entry(daa_table[f][x], out);
+        }
+    }
+
+    return ERR_NONE;
+}
+
+/**
+ * @brief Generates the tables, and publishes them if all went well
+ */
+static void init_once(void)
+{
+    tables_error = generate_tables();
+    if (tables_error == ERR_NONE) {
+        atomic_store_explicit(&tables_ready, 1, memory_order_release);
+    }
+}
+
+// See alu_table.h
+int alu_table_init(void)
+{
+    if (pthread_once(&tables_once, init_once) != 0) {
+        return ERR_MEM;
+    }
+
+    return tables_error;
+}
+
+// See alu_table.h
+int alu_table_ready(void)
+{
+    return atomic_load_explicit(&tables_ready, memory_order_acquire);
+}
+
+// ======================================================================
+// See alu_table.h
+int alu_table_add8(alu_output_t* result, uint8_t x, uint8_t y, bit_t c0)
+{
+    M_REQUIRE_NON_NULL(result);
+    M_REQUIRE_TABLES();
+
+    accumulate_entry(result, add8_table[c0 & 1][x][y]);
+
+    return ERR_NONE;
+}
+
+// See alu_table.h
+int alu_table_sub8(alu_output_t* result, uint8_t x, uint8_t y, bit_t b0)
+{
+    M_REQUIRE_NON_NULL(result);
+    M_REQUIRE_TABLES();
+
+    accumulate_entry(result, sub8_table[b0 & 1][x][y]);
+
+    return ERR_NONE;
+}
+
+// See alu_table.h
+int alu_table_inc8(alu_output_t* result, uint8_t x)
+{
+    M_REQUIRE_NON_NULL(result);
+    M_REQUIRE_TABLES();
+
+    accumulate_entry(result, inc8_table[x]);
+
+    return ERR_NONE;
+}
+
+// See alu_table.h
+int alu_table_dec8(alu_output_t* result, uint8_t x)
+{
+    M_REQUIRE_NON_NULL(result);
+    M_REQUIRE_TABLES();
+
+    accumulate_entry(result, dec8_table[x]);
+
+    return ERR_NONE;
+}
+
+// See alu_table.h
+int alu_table_shift(alu_output_t* result, uint8_t x, rot_dir_t dir)
+{
+    M_REQUIRE_NON_NULL(result);
+    M_REQUIRE(IS_VALID_DIR(dir), ERR_BAD_PARAMETER, "invalid direction %d", dir);
+    M_REQUIRE_TABLES();
+
+    accumulate_entry(result, shift_table[dir][x]);
+
+    return ERR_NONE;
+}
+
+// See alu_table.h
+int alu_table_shiftR_A(alu_output_t* result, uint8_t x)
+{
+    M_REQUIRE_NON_NULL(result);
+    M_REQUIRE_TABLES();
+
+    assign_entry(result, shiftR_A_table[x]);
+
+    return ERR_NONE;
+}
+
+// See alu_table.h
+int alu_table_rotate(alu_output_t* result, uint8_t x, rot_dir_t dir)
+{
+    M_REQUIRE_NON_NULL(result);
+    M_REQUIRE(IS_VALID_DIR(dir), ERR_BAD_PARAMETER, "invalid direction %d", dir);
+    M_REQUIRE_TABLES();
+
+    accumulate_entry(result, rotate_table[dir][x]);
+
+    return ERR_NONE;
+}
+
+// See alu_table.h
+int alu_table_carry_rotate(alu_output_t* result, uint8_t x, rot_dir_t dir, flags_t flags)
+{
+    M_REQUIRE_NON_NULL(result);
+    M_REQUIRE(IS_VALID_DIR(dir), ERR_BAD_PARAMETER, "invalid direction %d", dir);
+    M_REQUIRE_TABLES();
+
+    assign_entry(result, carry_rotate_table[dir][get_C(flags) ? 1 : 0][x]);
+
+    return ERR_NONE;
+}
+
+// See alu_table.h
+int alu_table_swap4(alu_output_t* result, uint8_t x)
+{
+    M_REQUIRE_NON_NULL(result);
+    M_REQUIRE_TABLES();
+
+    assign_entry(result, swap4_table[x]);
+
+    return ERR_NONE;
+}
+
+// See alu_table.h
+int alu_table_bcd_adjust(alu_output_t* result)
+{
+    M_REQUIRE_NON_NULL(result);
+    M_REQUIRE_TABLES();
+
+    assign_entry(result, daa_table[alu_table_daa_index(result->flags)][lsb8(result->value)]);
+
+    return ERR_NONE;
+}
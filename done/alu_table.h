@@ -0,0 +1,156 @@
+#pragma once
+
+/**
+ * @file alu_table.h
+ * @brief Table-driven ALU for GameBoy Emulator (enabled in the CPU with -DALU_TABLE)
+ *
+ * The tables are generated once by alu_table_init() from the reference
+ * implementations of alu.h and alu_ext.h, so every lookup function below
+ * gives exactly the same value and flags as its reference counterpart.
+ *
+ * @date 2020
+ */
+
+#include "alu.h"
+#include "alu_ext.h"
+#include "bit.h"
+#include "error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief one precomputed ALU result: the 8 bit value and the flags it sets
+ */
+typedef struct {
+    uint8_t value;
+    flags_t flags;
+} alu_table_entry_t;
+
+/**
+ * @brief number of rows of the DAA table, indexed by the N, H and C flags
+ */
+#define ALU_TABLE_DAA_FLAGS 8
+
+/**
+ * @brief index of the DAA table row for a given set of flags
+ */
+#define alu_table_daa_index(flags) \
+    ((get_N(flags) ? 4 : 0) | (get_H(flags) ? 2 : 0) | (get_C(flags) ? 1 : 0))
+
+/**
+ * @brief Generates all the ALU tables (does nothing if already done; may be
+ *        called from several threads at once, the tables being generated once)
+ *
+ * @return error code
+ */
+int alu_table_init(void);
+
+/**
+ * @brief Tells if the ALU tables have been generated
+ *
+ * @return 1 if alu_table_init() already ran successfully, 0 otherwise
+ */
+int alu_table_ready(void);
+
+/**
+ * @brief table version of alu_add8() (x, y and carry in indexed)
+ *
+ * @param result alu_output_t pointer to write into
+ * @param x value to sum
+ * @param y value to sum
+ * @param c0 carry in (only its lowest bit is used)
+ * @return error code
+ */
+int alu_table_add8(alu_output_t* result, uint8_t x, uint8_t y, bit_t c0);
+
+/**
+ * @brief table version of alu_sub8() (x, y and borrow in indexed)
+ *
+ * @param result alu_output_t pointer to write into
+ * @param x value to subtract from
+ * @param y value to subtract
+ * @param b0 initial borrow bit (only its lowest bit is used)
+ * @return error code
+ */
+int alu_table_sub8(alu_output_t* result, uint8_t x, uint8_t y, bit_t b0);
+
+/**
+ * @brief table version of alu_add8(result, x, 1, 0), used by INC
+ *
+ * @param result alu_output_t pointer to write into
+ * @param x value to increment
+ * @return error code
+ */
+int alu_table_inc8(alu_output_t* result, uint8_t x);
+
+/**
+ * @brief table version of alu_sub8(result, x, 1, 0), used by DEC
+ *
+ * @param result alu_output_t pointer to write into
+ * @param x value to decrement
+ * @return error code
+ */
+int alu_table_dec8(alu_output_t* result, uint8_t x);
+
+/**
+ * @brief table version of alu_shift()
+ *
+ * @param result alu_output_t pointer to write into
+ * @param x value to shift
+ * @param dir shift direction
+ * @return error code
+ */
+int alu_table_shift(alu_output_t* result, uint8_t x, rot_dir_t dir);
+
+/**
+ * @brief table version of alu_shiftR_A()
+ *
+ * @param result alu_output_t pointer to write into
+ * @param x value to shift
+ * @return error code
+ */
+int alu_table_shiftR_A(alu_output_t* result, uint8_t x);
+
+/**
+ * @brief table version of alu_rotate()
+ *
+ * @param result alu_output_t pointer to write into
+ * @param x value to rotate
+ * @param dir rotation direction
+ * @return error code
+ */
+int alu_table_rotate(alu_output_t* result, uint8_t x, rot_dir_t dir);
+
+/**
+ * @brief table version of alu_carry_rotate()
+ *
+ * @param result alu_output_t pointer to write into
+ * @param x value to rotate
+ * @param dir rotation direction
+ * @param flags carry flag
+ * @return error code
+ */
+int alu_table_carry_rotate(alu_output_t* result, uint8_t x, rot_dir_t dir, flags_t flags);
+
+/**
+ * @brief table version of alu_swap4()
+ *
+ * @param result alu_output_t pointer to write into
+ * @param x value to swap the bits from
+ * @return error code
+ */
+int alu_table_swap4(alu_output_t* result, uint8_t x);
+
+/**
+ * @brief table version of alu_bcd_adjust() (indexed by A, N, H and C)
+ *
+ * @param result alu_output_t pointer use the value and flags from and to write into
+ * @return error code
+ */
+int alu_table_bcd_adjust(alu_output_t* result);
+
+#ifdef __cplusplus
+}
+#endif
@@ -151,7 +151,7 @@ bit_vector_t* bit_vector_extract_wrap_ext(const bit_vector_t* pbv, int64_t index
 bit_vector_t* bit_vector_shift(const bit_vector_t* pbv, int64_t shift)
 {
 
-    if(shift != 0) {
+    if(pbv != NULL && shift != 0) {
         return bit_vector_extract_zero_ext(pbv, -shift, pbv->size);
     }
 
@@ -241,62 +241,128 @@ bit_vector_t* bit_vector_extract(bit_t type, const bit_vector_t* pbv, int64_t in
         return NULL;
     }
 
-    bit_vector_t* res = bit_vector_create(size, 0);
+    const bit_vector_view_t view = bit_vector_view(type, pbv, index, size);
+    return bit_vector_view_cpy(&view);
+}
 
-    if(pbv != NULL) {
+// ======================================================================
+/**
+ * @brief Word k of the (infinite) zero or wrap extension of the base of a view
+ *        (the size of the base being a multiple of 32 for wrap extension)
+ */
+static uint32_t base_word(const bit_vector_view_t* view, int64_t k)
+{
 
-        uint8_t base = 0;
+    const int64_t n = CLAMP32(view->base->size) / IMAGE_LINE_WORD_BITS;
 
-        // get extract byte, 0 if it is 0-extract and appropriate byte otherwise
-        uint8_t alternative = (type == 0) ? 0 : ((*(pbv->content + ((index % pbv->size)/IMAGE_LINE_WORD_BITS)) >> (((index % pbv->size/BYTE_SIZE) * BYTE_SIZE)) & GENERATE_FF(BYTE_SIZE)));
+    if(view->wrap) {
+        k %= n;
+        return *(view->base->content + (k < 0 ? k + n : k));
+    }
 
-        // get either byte at direct index or appropriate extract byte
-        uint8_t other = (index >= 0 && index < pbv->allocated) ? (((*(pbv->content + (index/IMAGE_LINE_WORD_BITS))) >> ((index/BYTE_SIZE)*BYTE_SIZE)) & GENERATE_FF(BYTE_SIZE)) : alternative;
+    if(k < 0 || k >= n) {
+        return 0;
+    }
 
+    uint32_t word = *(view->base->content + k);
+    if(k == n - 1 && view->base->size % IMAGE_LINE_WORD_BITS != 0) { // ignore the bits beyond the size
+        word &= GENERATE_FF(view->base->size % IMAGE_LINE_WORD_BITS);
+    }
+    return word;
+}
+
+// See bit_vector.h
+bit_vector_view_t bit_vector_view(bit_t type, const bit_vector_t* pbv, int64_t index, size_t size)
+{
 
-        for (int i = 0; i <= size; ++i) {
+    bit_vector_view_t view = { pbv, index, size, type };
+    return view;
+}
 
-            if(i % BYTE_SIZE == 0 || (i == size && size < IMAGE_LINE_WORD_BITS)) { // if base byte is filled
+// See bit_vector.h
+uint32_t bit_vector_view_word(const bit_vector_view_t* view, size_t i)
+{
 
-                uint32_t base32 = (size > BYTE_SIZE) ? base << ((i % IMAGE_LINE_WORD_BITS) - BYTE_SIZE) : base; // change to 32-bit word and shift to appropriate location
+    if(view == NULL || view->base == NULL || view->base->size == 0 || i * IMAGE_LINE_WORD_BITS >= view->size) {
+        return 0;
+    }
 
-                int ind = (i % IMAGE_LINE_WORD_BITS == 0 && i != 0) ? (i/IMAGE_LINE_WORD_BITS) - 1 : (i/IMAGE_LINE_WORD_BITS); // get index of word to store
-                *(res->content + ind) = *(res->content + ind) | base32; // adjust vector content
-                base = 0; // reset base
-            }
+    const size_t remaining = view->size - i * IMAGE_LINE_WORD_BITS;
+    const int64_t start = view->index + (int64_t)(i * IMAGE_LINE_WORD_BITS);
+    uint32_t word = 0;
 
-            int ind = index;
+    if(view->wrap && view->base->size % IMAGE_LINE_WORD_BITS != 0) { // words of the base not aligned: bit by bit
+        const int64_t n = (int64_t) view->base->size;
+        for(size_t b = 0; b < IMAGE_LINE_WORD_BITS && b < remaining; ++b) {
+            int64_t j = (start + (int64_t) b) % n;
+            j = j < 0 ? j + n : j;
+            word |= ((*(view->base->content + j / IMAGE_LINE_WORD_BITS) >> (j % IMAGE_LINE_WORD_BITS)) & 1u) << b;
+        }
+        return word;
+    }
 
-            if(type == 1 && (index < 0 || index >= pbv->size)) {
-                ind = index % pbv->size; // in case of extract wrap, get index to extract from
-            }
+    // start = 32 * k + r, with 0 <= r < 32
+    const int64_t k = start >= 0 ? start / IMAGE_LINE_WORD_BITS : -((-start + IMAGE_LINE_WORD_BITS - 1) / IMAGE_LINE_WORD_BITS);
+    const int r = (int)(start - k * IMAGE_LINE_WORD_BITS);
 
+    word = base_word(view, k);
+    if(r != 0) {
+        word = (word >> r) | (base_word(view, k + 1) << (IMAGE_LINE_WORD_BITS - r));
+    }
 
-            if((index % BYTE_SIZE == 0 || index % pbv->size == 0) && i < size) { // if the reference byte needs to be changed
+    if(remaining < IMAGE_LINE_WORD_BITS) {
+        word &= GENERATE_FF(remaining);
+    }
+    return word;
+}
 
-                if(type == 0) { // update reference byte if 0-extraction
-                    other = (index >= 0 && index < pbv->allocated) ? ((*(pbv->content + (index/IMAGE_LINE_WORD_BITS)) >> (index % IMAGE_LINE_WORD_BITS)) & GENERATE_FF(BYTE_SIZE)) : 0;
-                }
+// See bit_vector.h
+bit_vector_t* bit_vector_view_cpy(const bit_vector_view_t* view)
+{
 
-                else { // update reference byte if wrap-extraction
-                    int div = (pbv->size >= IMAGE_LINE_WORD_BITS) ? IMAGE_LINE_WORD_BITS : pbv->size;
-                    other = (index % pbv->size == 0) ? ((*(pbv->content + (ind/div))) & 0x00FF) : ((*(pbv->content + (ind/div)) >> (ind % div)) & GENERATE_FF(BYTE_SIZE));
-                }
-            }
+    if(view == NULL) {
+        return NULL;
+    }
 
-            if(i < size && other != 0) {
-                bit_t at_index = bit_get(other, (ind % BYTE_SIZE)); // get bit at index from reference byte
-                if(at_index == 1) {
-                    bit_set( &base, (i % BYTE_SIZE));    // set bit in base byte
-                }
-            }
+    bit_vector_t* res = bit_vector_create(view->size, 0);
 
-            ++index; // increment index
+    if(res != NULL) {
+        for(size_t i = 0; i < CLAMP32(view->size)/IMAGE_LINE_WORD_BITS; ++i) {
+            *(res->content + i) = bit_vector_view_word(view, i);
         }
     }
 
     return res;
+}
 
+// See bit_vector.h
+bit_vector_t* bit_vector_and_view(bit_vector_t* pbv1, const bit_vector_view_t* view)
+{
+
+    if(pbv1 != NULL && view != NULL) {
+        if(pbv1->size != view->size) {
+            return NULL;
+        }
+
+        for(size_t i = 0; i < CLAMP32(pbv1->size)/IMAGE_LINE_WORD_BITS; ++i) {
+            *(pbv1->content + i) &= bit_vector_view_word(view, i);
+        }
+    }
+    return pbv1;
 }
 
+// See bit_vector.h
+bit_vector_t* bit_vector_or_view(bit_vector_t* pbv1, const bit_vector_view_t* view)
+{
 
+    if(pbv1 != NULL && view != NULL) {
+        if(pbv1->size != view->size) {
+            return NULL;
+        }
+
+        for(size_t i = 0; i < CLAMP32(pbv1->size)/IMAGE_LINE_WORD_BITS; ++i) {
+            *(pbv1->content + i) |= bit_vector_view_word(view, i);
+        }
+    }
+    return pbv1;
+}
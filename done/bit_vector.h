@@ -47,6 +47,20 @@ typedef struct {
     size_t size;
 } bit_vector_t;
 
+//=========================================================================
+/**
+ * @brief Type to represent (without copying) the bits of a bit vector
+ *        from a given index, zero or wrap extended
+ *
+ * A view does not own anything: it is valid as long as its base is.
+ */
+typedef struct {
+    const bit_vector_t* base;
+    int64_t index; // index in base of the first bit of the view
+    size_t size;
+    bit_t wrap;    // 0 for zero extension, 1 for wrap extension
+} bit_vector_view_t;
+
 //=========================================================================
 /**
  * @brief Create a bit vector of a given size and fill it with bit value
@@ -171,6 +185,52 @@ int bit_vector_println(const char* prefix, const bit_vector_t* pbv);
  */
 void bit_vector_free(bit_vector_t** pbv);
 
+//=========================================================================
+/**
+ * @brief Make a view of a bit vector (nothing is copied)
+ * @param type indicated type of extraction (0 for zero, 1 for wrap)
+ * @param pbv pointer to bit vector (may be NULL for zero extension)
+ * @param index index from where the view starts
+ * @param size size in bit of the view
+ * @return the view
+ */
+bit_vector_view_t bit_vector_view(bit_t type, const bit_vector_t* pbv, int64_t index, size_t size);
+
+//=========================================================================
+/**
+ * @brief Get a word of a view, computed from the words of its base
+ * @param view pointer to the view
+ * @param i index of the word (bit 0 of word i is bit 32 * i of the view)
+ * @return the word (its bits beyond the size of the view are 0)
+ */
+uint32_t bit_vector_view_word(const bit_vector_view_t* view, size_t i);
+
+//=========================================================================
+/**
+ * @brief Create a new bit vector from a view (materialize it)
+ * @param view pointer to the view
+ * @return pointer to new bit vector
+ */
+bit_vector_t* bit_vector_view_cpy(const bit_vector_view_t* view);
+
+//=========================================================================
+/**
+ * @brief Compute logical AND of a bit vector and a view
+ * @param pbv1 pointer to bit vector
+ * @param view pointer to the view (of the same size)
+ * @return pointer to the bit vector
+ */
+bit_vector_t* bit_vector_and_view(bit_vector_t* pbv1, const bit_vector_view_t* view);
+
+//=========================================================================
+/**
+ * @brief Compute logical OR of a bit vector and a view
+ * @param pbv1 pointer to bit vector
+ * @param view pointer to the view (of the same size)
+ * @return pointer to the bit vector
+ */
+bit_vector_t* bit_vector_or_view(bit_vector_t* pbv1, const bit_vector_view_t* view);
+
 /**
  * @brief Create a new bit vector extracted from another bit vector (wrap or zero extended)
  * @param type indicated type of extraction (0 for zero, 1 for wrap)
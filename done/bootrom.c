@@ -1,4 +1,49 @@
 #include "bootrom.h"
+#include "cpu-storage.h"
+#include "cpu-registers.h"
+
+// what running the boot ROM (see GAMEBOY_BOOT_ROM_CONTENT) does:
+#define BOOT_CYCLES 2172511        // cycles until it is unplugged
+#define BOOT_LCDC_ON_CYCLE 66885   // cycle at which it switches the screen on
+
+#define BOOT_LOGO_START 0x0104     // logo in the cartridge header...
+#define BOOT_LOGO_END   0x0133
+#define BOOT_LOGO_TILES 0x8010     // ...drawn from tile 1 on
+#define BOOT_R_TILE_CONTENT 0xB1   // (R) mark in the boot ROM, drawn after the logo
+#define BOOT_R_TILE 0x19
+#define BOOT_MAP_LINE_1 0x9904     // the 2 lines of 12 tiles of the logo
+#define BOOT_MAP_LINE_2 0x9924
+#define BOOT_MAP_R      0x9910
+#define BOOT_MAP_LINE_SIZE 12
+#define BOOT_STACK 0xFFF8          // lowest byte it leaves on its stack
+#define BOOT_HEADER_CHECKSUM 0x014D // checked last, by adding it to A
+
+/**
+ * @brief A nibble with each of its bits doubled (as the boot ROM enlarges
+ *        the logo)
+ */
+static data_t double_bits(data_t nibble)
+{
+    data_t d = 0;
+    for(int i = 3; i >= 0; --i) {
+        d = (data_t)(d << 2 | (bit_get(nibble, i) ? 0x3 : 0x0));
+    }
+    return d;
+}
+
+/**
+ * @brief Writes the bootrom content to the memory of a created component
+ */
+static int fill(component_t* c)
+{
+    data_t bootrom[MEM_SIZE(BOOT_ROM)] = GAMEBOY_BOOT_ROM_CONTENT;
+
+    for(int i = 0; i < c->mem->size; ++i) {
+        *(c->mem->memory + i)=bootrom[i]; // assign bootrom content to allocated bootrom component memory
+    }
+
+    return ERR_NONE;
+}
 
 //See bootrom.h
 int bootrom_init(component_t* c)
@@ -11,13 +56,17 @@ int bootrom_init(component_t* c)
         return errcode;
     }
 
-    data_t bootrom[MEM_SIZE(BOOT_ROM)] = GAMEBOY_BOOT_ROM_CONTENT;
+    return fill(c);
+}
 
-    for(int i = 0; i < c->mem->size; ++i) {
-        *(c->mem->memory + i)=bootrom[i]; // assign bootrom content to allocated bootrom component memory
-    }
+//See bootrom.h
+int bootrom_init_in(component_t* c, memory_t* mem, data_t* memory)
+{
+    M_REQUIRE_NON_NULL(c);
 
-    return ERR_NONE;
+    M_EXIT_IF_ERR(component_create_in(c, mem, memory, MEM_SIZE(BOOT_ROM)));
+
+    return fill(c);
 }
 
 //See bootrom.h
@@ -27,11 +76,95 @@ int bootrom_bus_listener(gameboy_t* gameboy, addr_t addr)
     M_REQUIRE_NON_NULL(gameboy);
 
     if(gameboy->boot && addr==REG_BOOT_ROM_DISABLE) { // if in boot and at the end of the bootrom
-        bus_unplug(gameboy->bus, &(gameboy->bootrom));
-        bootrom_free(&(gameboy->bootrom));
+        bus_unplug(gameboy->bus, &(gameboy->bootrom)); // kept for gameboy_reset()
         cartridge_plug(&(gameboy->cartridge), gameboy->bus);
+#ifdef PREDECODE
+        predecode_invalidate(gameboy->cpu.predecode); // bank switch
+#endif
         gameboy->boot=0;
     }
 
     return ERR_NONE;
 }
+
+//See bootrom.h
+int bootrom_fast_boot(gameboy_t* gameboy)
+{
+    M_REQUIRE_NON_NULL(gameboy);
+    M_REQUIRE(gameboy->boot && gameboy->cycles == 0, ERR_BAD_PARAMETER,
+              "%s", "gameboy not at the start of its boot");
+
+    cpu_t* const cpu = &(gameboy->cpu);
+    M_EXIT_IF_ERR(timer_catch_up(&(gameboy->timer), BOOT_CYCLES));
+
+    // the logo, each pixel of the cartridge one being 2x2 pixels on the screen
+    addr_t tiles = BOOT_LOGO_TILES;
+    for(addr_t a = BOOT_LOGO_START; a <= BOOT_LOGO_END; ++a) {
+        const data_t b = cpu_read_at_idx(cpu, a);
+        const data_t rows[2] = { double_bits(msb4(b)), double_bits(lsb4(b)) };
+        for(int r = 0; r < 2; ++r, tiles = (addr_t)(tiles + 4)) {
+            M_EXIT_IF_ERR(cpu_write_at_idx(cpu, tiles, rows[r]));
+            M_EXIT_IF_ERR(cpu_write_at_idx(cpu, (addr_t)(tiles + 2), rows[r]));
+        }
+    }
+    const data_t content[MEM_SIZE(BOOT_ROM)] = GAMEBOY_BOOT_ROM_CONTENT;
+    for(addr_t i = 0; i < TILE_SIZE / 2; ++i) {
+        M_EXIT_IF_ERR(cpu_write_at_idx(cpu, (addr_t)(tiles + 2 * i), content[BOOT_R_TILE_CONTENT + i]));
+    }
+    for(data_t t = 0; t < BOOT_MAP_LINE_SIZE; ++t) {
+        M_EXIT_IF_ERR(cpu_write_at_idx(cpu, (addr_t)(BOOT_MAP_LINE_1 + t), (data_t)(1 + t)));
+        M_EXIT_IF_ERR(cpu_write_at_idx(cpu, (addr_t)(BOOT_MAP_LINE_2 + t),
+                                       (data_t)(1 + BOOT_MAP_LINE_SIZE + t)));
+    }
+    M_EXIT_IF_ERR(cpu_write_at_idx(cpu, BOOT_MAP_R, BOOT_R_TILE));
+
+    // what is left on its stack
+    static const data_t stack[] = { 0x03, 0x99, 0xA6, 0x00, 0xB0, 0x01 };
+    for(addr_t i = 0; i < sizeof(stack); ++i) {
+        M_EXIT_IF_ERR(cpu_write_at_idx(cpu, (addr_t)(BOOT_STACK + i), stack[i]));
+    }
+
+    // sound and screen registers
+    static const struct {
+        addr_t addr;
+        data_t value;
+    } regs[] = {
+        { 0xFF26, 0x80 }, { 0xFF11, 0x80 }, { 0xFF12, 0xF3 }, { 0xFF25, 0xF3 },
+        { 0xFF24, 0x77 }, { 0xFF13, 0xC1 }, { 0xFF14, 0x87 },
+        { REG_BGP, 0xFC }, { REG_LCDC, 0x91 }
+    };
+    for(size_t i = 0; i < sizeof(regs) / sizeof(regs[0]); ++i) {
+        M_EXIT_IF_ERR(cpu_write_at_idx(cpu, regs[i].addr, regs[i].value));
+    }
+    M_EXIT_IF_ERR(lcdc_bus_listener(&(gameboy->screen), REG_LCDC, gameboy->cycles));
+
+    // the screen switched on long ago: only its last frame is to be drawn
+    lcdc_t* const lcd = &(gameboy->screen);
+    lcd->on_cycle = BOOT_LCDC_ON_CYCLE;
+    lcd->next_cycle = BOOT_LCDC_ON_CYCLE
+                      + (BOOT_CYCLES - BOOT_LCDC_ON_CYCLE) / FRAME_TOTAL_CYCLES * FRAME_TOTAL_CYCLES;
+    M_EXIT_IF_ERR(lcdc_run_until(lcd, lcd->next_cycle, BOOT_CYCLES));
+    gameboy->cycles = BOOT_CYCLES;
+
+    // its last instructions; the flags are the ones of the addition of the
+    // header checksum, which the cartridge passed: A + checksum == 0x100 or 0
+    const data_t checksum = cpu_read_at_idx(cpu, BOOT_HEADER_CHECKSUM);
+    flags_t flags = 0;
+    set_Z(&flags);
+    if(lsb4(checksum) != 0) {
+        set_H(&flags);
+    }
+    if(checksum != 0) {
+        set_C(&flags);
+    }
+    cpu_AF_set(cpu, merge8(flags, 0x01));
+    cpu_BC_set(cpu, 0x0013);
+    cpu_DE_set(cpu, 0x00D8);
+    cpu_HL_set(cpu, 0x014D);
+    cpu->SP = 0xFFFE;
+    cpu->PC = 0x0100;
+    cpu->idle_time = 2; // of the write to REG_BOOT_ROM_DISABLE
+    M_EXIT_IF_ERR(cpu_write_at_idx(cpu, REG_BOOT_ROM_DISABLE, cpu->A));
+
+    return bootrom_bus_listener(gameboy, REG_BOOT_ROM_DISABLE);
+}
@@ -67,6 +67,18 @@ extern "C" {
 int bootrom_init(component_t* c);
 
 
+/**
+ * @brief Writes bootrom content to a component created on memory it does
+ *        not own (see component_create_in())
+ *
+ * @param c component to write the bootrom content to
+ * @param mem memory structure to use
+ * @param memory where to write the bootrom content (MEM_SIZE(BOOT_ROM) bytes)
+ * @return error code
+ */
+int bootrom_init_in(component_t* c, memory_t* mem, data_t* memory);
+
+
 /**
  * @brief Macro to plug bootrom onto the bus
  */
@@ -83,6 +95,24 @@ int bootrom_init(component_t* c);
 #define bootrom_free(c) component_free(c);
 
 
+/**
+ * @brief Leaves a gameboy just created (thus at cycle 0, in boot mode) in the
+ *        exact state its boot ROM leaves it in when run, without running it:
+ *        registers, video RAM (logo of the cartridge), displayed frame, and
+ *        the cartridge plugged in place of the boot ROM
+ *
+ * The boot ROM is run in about 2 millions cycles (mostly waiting for the
+ * frames of its animation), which are thus skipped.
+ *
+ * The flags are left as by the boot ROM of the real Game Boy, which checks
+ * the header checksum last (H and C set unless its low nibble, or it, is 0);
+ * the boot ROM here does not check it, and always leaves F at 0xB0.
+ *
+ * @param gameboy gameboy to boot
+ * @return error code
+ */
+int bootrom_fast_boot(gameboy_t* gameboy);
+
 /**
  * @brief Bootrom bus listening handler
  *
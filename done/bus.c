@@ -145,3 +145,29 @@ int bus_write16(bus_t bus, addr_t address, addr_t data16)
     return ERR_NONE;
 }
 
+// See bus.h
+int bus_io_set_reader(bus_io_t io, addr_t address, bus_io_reader_t read, void* owner)
+{
+    M_REQUIRE_NON_NULL(io);
+    M_REQUIRE(bus_io_has(address), ERR_ADDRESS, "0x%04X out of the I/O page", address);
+
+    io[address - BUS_IO_START].read = read;
+    io[address - BUS_IO_START].owner = read == NULL ? NULL : owner;
+
+    return ERR_NONE;
+}
+
+// See bus.h
+int bus_io_read(const bus_t bus, const bus_io_t io, addr_t address, data_t* data)
+{
+    M_REQUIRE_NON_NULL(io);
+    M_REQUIRE(bus_io_has(address), ERR_ADDRESS, "0x%04X out of the I/O page", address);
+
+    const bus_io_handler_t* const handler = &(io[address - BUS_IO_START]);
+    if(handler->read == NULL) {
+        return bus_read(bus, address, data);
+    }
+    M_REQUIRE_NON_NULL(data);
+
+    return handler->read(handler->owner, address, data);
+}
@@ -22,6 +22,42 @@ extern "C" {
  */
 typedef data_t* bus_t[BUS_SIZE];
 
+/**
+ * @brief I/O page of the bus, the only addresses which may be computed when
+ *        read (see bus_io_t)
+ */
+#define BUS_IO_START 0xFF00
+#define BUS_IO_END   0xFF7F
+#define BUS_IO_SIZE  ((BUS_IO_END - BUS_IO_START) + 1)
+
+#define bus_io_has(address) ((address) >= BUS_IO_START && (address) <= BUS_IO_END)
+
+/**
+ * @brief Computes the value of a register when it is read
+ *
+ * @param owner component owning the register
+ * @param address address read
+ * @param data pointer to write read data to
+ * @return error code
+ */
+typedef int (*bus_io_reader_t)(void* owner, addr_t address, data_t* data);
+
+/**
+ * @brief Read handler of an address of the I/O page (read NULL if none)
+ */
+typedef struct {
+    bus_io_reader_t read;
+    void* owner;
+} bus_io_handler_t;
+
+/**
+ * @brief Read handlers of the I/O page: a register with a handler is
+ *        computed by its owner when read (see bus_io_read()), rather than
+ *        written into the bus each time it changes; its byte on the bus is
+ *        then not kept up to date. The other addresses are read from the bus.
+ */
+typedef bus_io_handler_t bus_io_t[BUS_IO_SIZE];
+
 
 /**
  * @brief Plug a component into the bus
@@ -111,6 +147,30 @@ int bus_read16(const bus_t bus, addr_t address, addr_t* data16);
  */
 int bus_write16(bus_t bus, addr_t address, addr_t data16);
 
+/**
+ * @brief Sets (or removes, given a NULL read) the read handler of an
+ *        address of the I/O page
+ *
+ * @param io read handlers to modify
+ * @param address address of the I/O page
+ * @param read function computing its value
+ * @param owner first parameter given to read
+ * @return error code (ERR_ADDRESS out of the I/O page)
+ */
+int bus_io_set_reader(bus_io_t io, addr_t address, bus_io_reader_t read, void* owner);
+
+/**
+ * @brief Reads an address of the I/O page, through its handler if any,
+ *        from the bus otherwise
+ *
+ * @param bus bus to read from
+ * @param io read handlers of the I/O page
+ * @param address address of the I/O page to read at
+ * @param data pointer to write read data to
+ * @return error code
+ */
+int bus_io_read(const bus_t bus, const bus_io_t io, addr_t address, data_t* data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,7 @@
 #include "cartridge.h"
 
+#include <stdlib.h> // for malloc, free
+
 // See cartridge.h
 int cartridge_init_from_file(component_t* c, const char* filename)
 {
@@ -36,6 +38,7 @@ int cartridge_init(cartridge_t* ct, const char* filename)
     M_REQUIRE_NON_NULL(ct);
     M_REQUIRE_NON_NULL(filename);
 
+    ct->users = NULL;
     int create = component_create(&(ct->c), BANK_ROM_SIZE);
     if(create != ERR_NONE) {
         return ERR_BAD_PARAMETER;
@@ -46,9 +49,33 @@ int cartridge_init(cartridge_t* ct, const char* filename)
     if(err_code == ERR_BAD_PARAMETER) {
         mem_free(ct->c.mem);
     }
+    if(err_code != ERR_NONE) {
+        return err_code;
+    }
+
+    ct->users = malloc(sizeof(atomic_uint));
+    if(ct->users == NULL) {
+        component_free(&(ct->c));
+        return ERR_MEM;
+    }
+    atomic_init(ct->users, 1);
+
+    return ERR_NONE;
+}
 
+// See cartridge.h
+int cartridge_init_shared(cartridge_t* ct, const cartridge_t* model)
+{
+    M_REQUIRE_NON_NULL(ct);
+    M_REQUIRE_NON_NULL(model);
+    M_REQUIRE_NON_NULL(model->c.mem);
+    M_REQUIRE_NON_NULL(model->users);
 
-    return err_code;
+    ct->c = model->c;
+    ct->users = model->users;
+    atomic_fetch_add(ct->users, 1);
+
+    return ERR_NONE;
 }
 
 // See cartridge.h
@@ -63,6 +90,11 @@ int cartridge_plug(cartridge_t* ct, bus_t bus)
 void cartridge_free(cartridge_t* ct)
 {
     if(ct != NULL) {
-        component_free(&(ct->c));
+        if(ct->users == NULL || atomic_fetch_sub(ct->users, 1) == 1) { // last user
+            component_free(&(ct->c));
+            free(ct->users);
+        }
+        ct->c.mem = NULL;
+        ct->users = NULL;
     }
 }
@@ -8,6 +8,7 @@
  * @date 2019
  */
 #include <stdio.h> // for FILE
+#include <stdatomic.h>
 
 #include "component.h"
 #include "bus.h"
@@ -33,9 +34,14 @@ extern "C" {
 
 /**
  * @brief Cartridge type
+ *
+ * The ROM is only read (the CPU of a gameboy drops its writes to it, see
+ * cpu_t): it may be shared by several cartridges (see
+ * cartridge_init_shared()), the last one freed freeing it.
  */
 typedef struct {
     component_t c;
+    atomic_uint* users; // number of cartridges sharing the ROM
 } cartridge_t;
 
 /**
@@ -58,6 +64,16 @@ int cartridge_init_from_file(component_t* c, const char* filename);
 int cartridge_init(cartridge_t* ct, const char* filename);
 
 
+/**
+ * @brief Initiates a cartridge sharing the ROM of another one
+ *        (without reading its file again nor copying it)
+ *
+ * @param ct cartridge to initiate
+ * @param model cartridge to share the ROM of
+ * @return error code
+ */
+int cartridge_init_shared(cartridge_t* ct, const cartridge_t* model);
+
 /**
  * @brief Plugs a cartridge to the bus
  *
@@ -69,7 +85,7 @@ int cartridge_plug(cartridge_t* ct, bus_t bus);
 
 
 /**
- * @brief Frees a cartridge
+ * @brief Frees a cartridge (its ROM, if no other cartridge shares it)
  *
  * @param ct cartridge to free
  */
@@ -23,6 +23,23 @@ int component_create(component_t* c, size_t mem_size)
     }
 }
 
+// See component.h
+int component_create_in(component_t* c, memory_t* mem, data_t* memory, size_t mem_size)
+{
+    M_REQUIRE_NON_NULL(c);
+    M_REQUIRE_NON_NULL(mem);
+    M_REQUIRE_NON_NULL(memory);
+    M_REQUIRE(mem_size > 0, ERR_BAD_PARAMETER, "%s", "empty memory");
+
+    c->start=0;
+    c->end=0;
+    mem->memory=memory;
+    mem->size=mem_size;
+    c->mem=mem;
+
+    return ERR_NONE;
+}
+
 // See component.h
 void component_free(component_t* c)
 {
@@ -35,6 +52,14 @@ void component_free(component_t* c)
     }
 }
 
+// See component.h
+void component_release(component_t* c)
+{
+    if(c != NULL) {
+        c->mem=NULL; // its start and end are kept, to be unplugged
+    }
+}
+
 // See component.h
 int component_shared(component_t* c, component_t* c_old)
 {
@@ -37,6 +37,19 @@ typedef struct component_t {
  */
 int component_create(component_t* c, size_t mem_size);
 
+/**
+ * @brief Creates a component on memory it does not own (e.g. part of an
+ *        arena), to be given to component_release() rather than to
+ *        component_free()
+ *
+ * @param c component pointer to initialize
+ * @param mem memory structure to use (shall outlive the component)
+ * @param memory memory content (shall outlive the component)
+ * @param mem_size size of the memory of the component
+ * @return error code
+ */
+int component_create_in(component_t* c, memory_t* mem, data_t* memory, size_t mem_size);
+
 /**
  * @brief Shares memory between two components
  *
@@ -53,6 +66,14 @@ int component_shared(component_t* c, component_t* c_old);
  */
 void component_free(component_t* c);
 
+/**
+ * @brief Forgets the memory of a component created by component_create_in(),
+ *        without freeing it (the component may still be unplugged)
+ *
+ * @param c component pointer to release
+ */
+void component_release(component_t* c);
+
 #ifdef __cplusplus
 }
 #endif
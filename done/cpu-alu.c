@@ -5,10 +5,36 @@
  * @date 2019
  */
 #include "cpu-alu.h"
+#include "opcode-decode.h"
+
+#ifdef ALU_TABLE
+#include "alu_table.h"
+#endif
 
 // external provided library
 extern int cpu_dispatch_alu_ext(const instruction_t* lu, cpu_t* cpu);
 
+// ======================================================================
+/**
+* @brief ALU operations used by the dispatch below: precomputed tables
+*        when compiled with -DALU_TABLE, reference functions otherwise
+*/
+#ifdef ALU_TABLE
+#define ALU_ADD8         alu_table_add8
+#define ALU_SUB8         alu_table_sub8
+#define ALU_SHIFT        alu_table_shift
+#define ALU_CARRY_ROTATE alu_table_carry_rotate
+#define ALU_INC8(result, x) alu_table_inc8(result, x)
+#define ALU_DEC8(result, x) alu_table_dec8(result, x)
+#else
+#define ALU_ADD8         alu_add8
+#define ALU_SUB8         alu_sub8
+#define ALU_SHIFT        alu_shift
+#define ALU_CARRY_ROTATE alu_carry_rotate
+#define ALU_INC8(result, x) alu_add8(result, x, 1, 0)
+#define ALU_DEC8(result, x) alu_sub8(result, x, 1, 0)
+#endif
+
 // ======================================================================
 /**
 * @brief Checks if x is a valid flag source
@@ -72,6 +98,38 @@ static void do_set_or_res(const instruction_t* lu, data_t* data)
 }
 // ======================================================================
 
+/**
+ * @brief Combines CPU and ALU flags according to the given sources
+ *
+ * @param cpu_f flags from cpu
+ * @param alu_f flags from alu
+ * @param Z flag source for Z flag bit
+ * @param N flat source for N flag bit
+ * @param H flag source for H flag bit
+ * @param C flag source for C flag bit
+ *
+ * @return resulting flags
+ */
+static flags_t combine_flags(flags_t cpu_f, flags_t alu_f,
+                             flag_src_t Z, flag_src_t N, flag_src_t H, flag_src_t C)
+{
+    flags_t res_f = 0;
+
+    if (flags_src_value(Z, get_Z(cpu_f), get_Z(alu_f)))
+        set_Z(&res_f);
+
+    if (flags_src_value(N, get_N(cpu_f), get_N(alu_f)))
+        set_N(&res_f);
+
+    if (flags_src_value(H, get_H(cpu_f), get_H(alu_f)))
+        set_H(&res_f);
+
+    if (flags_src_value(C, get_C(cpu_f), get_C(alu_f)))
+        set_C(&res_f);
+
+    return res_f;
+}
+
 // See cpu-alu.h
 int cpu_combine_alu_flags(cpu_t* cpu,
                           flag_src_t Z, flag_src_t N, flag_src_t H, flag_src_t C)
@@ -82,104 +140,213 @@ int cpu_combine_alu_flags(cpu_t* cpu,
     CHECK_FLAG_SRC(H);
     CHECK_FLAG_SRC(C);
 
-    flags_t res_f = 0;
+#ifdef LAZY_FLAGS
+    if (Z == CPU || N == CPU || H == CPU || C == CPU) {
+        M_EXIT_IF_ERR(cpu_flags_sync(cpu)); // some of the current flags are kept
+    } else {
+        cpu->lazy_flags.op = LAZY_NONE; // pending flags are all overwritten
+    }
+#endif
 
-    if (flags_src_value(Z, get_Z(cpu->F), get_Z(cpu->alu.flags)))
-        set_Z(&res_f);
+    cpu->F = combine_flags(cpu->F, cpu->alu.flags, Z, N, H, C);
 
-    if (flags_src_value(N, get_N(cpu->F), get_N(cpu->alu.flags)))
-        set_N(&res_f);
+    return ERR_NONE;
+}
 
-    if (flags_src_value(H, get_H(cpu->F), get_H(cpu->alu.flags)))
-        set_H(&res_f);
+// See cpu.h
+int cpu_flags_sync(cpu_t* cpu)
+{
+    M_REQUIRE_NON_NULL(cpu);
 
-    if (flags_src_value(C, get_C(cpu->F), get_C(cpu->alu.flags)))
-        set_C(&res_f);
+#ifdef LAZY_FLAGS
+    const lazy_flags_t pending = cpu->lazy_flags;
+    alu_output_t out = {0, 0};
+
+    switch (pending.op) {
+    case LAZY_ADD:
+        M_EXIT_IF_ERR(ALU_ADD8(&out, pending.x, pending.y, pending.carry));
+        cpu->F = combine_flags(cpu->F, out.flags, ADD_FLAGS_SRC);
+        break;
+
+    case LAZY_SUB:
+        M_EXIT_IF_ERR(ALU_SUB8(&out, pending.x, pending.y, pending.carry));
+        cpu->F = combine_flags(cpu->F, out.flags, SUB_FLAGS_SRC);
+        break;
+
+    case LAZY_INC:
+        M_EXIT_IF_ERR(ALU_INC8(&out, pending.x));
+        cpu->F = combine_flags(cpu->F, out.flags, INC_FLAGS_SRC);
+        break;
+
+    case LAZY_DEC:
+        M_EXIT_IF_ERR(ALU_DEC8(&out, pending.x));
+        cpu->F = combine_flags(cpu->F, out.flags, DEC_FLAGS_SRC);
+        break;
+
+    default:
+        break;
+    }
 
-    cpu->F = res_f;
+    cpu->lazy_flags.op = LAZY_NONE;
+#endif
 
     return ERR_NONE;
 }
 
+#ifdef LAZY_FLAGS
+/**
+ * @brief Computes the 8 bit result of an ALU operation into cpu->alu.value
+ *        and records its operands, leaving its flags for cpu_flags_sync()
+ *
+ * @param cpu cpu to update
+ * @param op lazy operation
+ * @param x first operand
+ * @param y second operand (1 for INC and DEC)
+ * @param carry carry or borrow in
+ *
+ * @return error code
+ */
+static int lazy_record(cpu_t* cpu, lazy_op_t op, uint8_t x, uint8_t y, bit_t carry)
+{
+    if (op == LAZY_INC || op == LAZY_DEC) {
+        M_EXIT_IF_ERR(cpu_flags_sync(cpu)); // C is kept from F
+    }
+
+    cpu->lazy_flags.op = op;
+    cpu->lazy_flags.x = x;
+    cpu->lazy_flags.y = y;
+    cpu->lazy_flags.carry = carry;
+
+    if (op == LAZY_ADD || op == LAZY_INC) {
+        cpu->alu.value = lsb8(x + y + carry);
+    } else {
+        cpu->alu.value = lsb8(x - y - carry);
+    }
+
+    return ERR_NONE;
+}
+
+/**
+* @brief Lazy version of do_cpu_arithm (ADC and SBC read C, so F has to be up to date)
+*/
+#define do_lazy_arithm(cpu, op, arg) \
+    do { \
+        if (bit_get(lu->opcode, OPCODE_CARRY_IDX)) { \
+            M_EXIT_IF_ERR(cpu_flags_sync(cpu)); \
+        } \
+        M_EXIT_IF_ERR(lazy_record(cpu, op, cpu->A, (arg), extract_carry(cpu, lu->opcode))); \
+        cpu->A = lsb8(cpu->alu.value); \
+    } while(0)
+#endif
+
+// ======================================================================
+/**
+* @brief 8 bit arithmetic of the dispatch below, setting cpu->alu.value
+*        and either F or, with -DLAZY_FLAGS, the pending flags
+*/
+#ifdef LAZY_FLAGS
+#define do_add8(cpu, arg) do_lazy_arithm(cpu, LAZY_ADD, arg)
+#define do_sub8(cpu, arg) do_lazy_arithm(cpu, LAZY_SUB, arg)
+#define do_cp8(cpu, arg)  M_EXIT_IF_ERR(lazy_record(cpu, LAZY_SUB, cpu->A, (arg), 0))
+#define do_inc8(cpu, arg) M_EXIT_IF_ERR(lazy_record(cpu, LAZY_INC, (arg), 1, 0))
+#define do_dec8(cpu, arg) M_EXIT_IF_ERR(lazy_record(cpu, LAZY_DEC, (arg), 1, 0))
+#else
+#define do_add8(cpu, arg) do_cpu_arithm(cpu, ALU_ADD8, arg, ADD_FLAGS_SRC)
+#define do_sub8(cpu, arg) do_cpu_arithm(cpu, ALU_SUB8, arg, SUB_FLAGS_SRC)
+#define do_cp8(cpu, arg) \
+    do { \
+        ALU_SUB8(&cpu->alu, cpu_reg_get(cpu, REG_A_CODE), (arg), 0); \
+        cpu_combine_alu_flags(cpu, SUB_FLAGS_SRC); \
+    } while(0)
+#define do_inc8(cpu, arg) \
+    do { \
+        ALU_INC8(&cpu->alu, (arg)); \
+        cpu_combine_alu_flags(cpu, INC_FLAGS_SRC); \
+    } while(0)
+#define do_dec8(cpu, arg) \
+    do { \
+        ALU_DEC8(&cpu->alu, (arg)); \
+        cpu_combine_alu_flags(cpu, DEC_FLAGS_SRC); \
+    } while(0)
+#endif
+
 // See cpu-alu.h
 int cpu_dispatch_alu(const instruction_t* lu, cpu_t* cpu)
 {
     M_REQUIRE_NON_NULL(cpu);
 
+    const decoded_instr_t* d = decoded_of(lu); // operands
+
     switch (lu->family) {
 
     // ADD
     case ADD_A_HLR: {
-        do_cpu_arithm(cpu, alu_add8, cpu_read_at_HL(cpu), ADD_FLAGS_SRC);
+        do_add8(cpu, cpu_read_at_HL(cpu));
     } break;
 
     case ADD_A_N8: {
-        do_cpu_arithm(cpu, alu_add8, cpu_read_data_after_opcode(cpu), ADD_FLAGS_SRC);
+        do_add8(cpu, cpu_read_data_after_opcode(cpu));
     } break;
 
     case ADD_A_R8: {
-        do_cpu_arithm(cpu, alu_add8, cpu_reg_get(cpu, extract_reg(lu->opcode, 0)), ADD_FLAGS_SRC);
+        do_add8(cpu, cpu_reg_get(cpu, d->r_src));
     } break;
 
     case INC_HLR: {
-        alu_add8(&cpu->alu, cpu_read_at_HL(cpu), 1, 0);
-        cpu_combine_alu_flags(cpu, INC_FLAGS_SRC);
+        do_inc8(cpu, cpu_read_at_HL(cpu));
         cpu_write_at_HL(cpu, cpu->alu.value);
     } break;
 
     case INC_R8: {
-        alu_add8(&cpu->alu, cpu_reg_get(cpu, extract_reg(lu->opcode, 3)), 1, 0);
-        cpu_combine_alu_flags(cpu, INC_FLAGS_SRC);
-        cpu_reg_set_from_alu8(cpu, extract_reg(lu->opcode, 3));
+        do_inc8(cpu, cpu_reg_get(cpu, d->r_dst));
+        cpu_reg_set_from_alu8(cpu, d->r_dst);
     } break;
 
     case DEC_R8: {
-        alu_sub8(&cpu->alu, cpu_reg_get(cpu, extract_reg(lu->opcode, 3)), 1, 0);
-        cpu_combine_alu_flags(cpu, DEC_FLAGS_SRC);
-        cpu_reg_set_from_alu8(cpu, extract_reg(lu->opcode, 3));
+        do_dec8(cpu, cpu_reg_get(cpu, d->r_dst));
+        cpu_reg_set_from_alu8(cpu, d->r_dst);
     } break;
 
     case ADD_HL_R16SP: {
-        alu_add16_high(&cpu->alu, cpu_HL_get(cpu), cpu_reg_pair_SP_get(cpu, extract_reg_pair(lu->opcode)));
+        alu_add16_high(&cpu->alu, cpu_HL_get(cpu), cpu_reg_pair_SP_get(cpu, d->pair));
         cpu_combine_alu_flags(cpu, CPU, CLEAR, ALU, ALU);
         cpu_HL_set(cpu, cpu->alu.value);
     } break;
 
     case INC_R16SP: {
-        alu_add16_high(&cpu->alu, cpu_reg_pair_SP_get(cpu, extract_reg_pair(lu->opcode)), 1);
-        cpu_reg_pair_SP_set(cpu, extract_reg_pair(lu->opcode), cpu->alu.value);
+        alu_add16_high(&cpu->alu, cpu_reg_pair_SP_get(cpu, d->pair), 1);
+        cpu_reg_pair_SP_set(cpu, d->pair, cpu->alu.value);
     } break;
 
 
     // COMPARISONS
     case CP_A_R8: {
-        alu_sub8(&cpu->alu, cpu_reg_get(cpu, REG_A_CODE), cpu_reg_get(cpu, extract_reg(lu->opcode, 0)), 0);
-        cpu_combine_alu_flags(cpu, SUB_FLAGS_SRC);
+        do_cp8(cpu, cpu_reg_get(cpu, d->r_src));
     } break;
 
     case CP_A_N8: {
-        alu_sub8(&cpu->alu, cpu_reg_get(cpu, REG_A_CODE), cpu_read_data_after_opcode(cpu), 0);
-        cpu_combine_alu_flags(cpu, SUB_FLAGS_SRC);
+        do_cp8(cpu, cpu_read_data_after_opcode(cpu));
     } break;
 
 
     // BIT MOVE (rotate, shift)
     case SLA_R8: {
-        alu_shift(&cpu->alu, cpu_reg_get(cpu, extract_reg(lu->opcode, 0)), LEFT);
-        cpu_reg_set(cpu, extract_reg(lu->opcode, 0), cpu->alu.value);
+        ALU_SHIFT(&cpu->alu, cpu_reg_get(cpu, d->r_src), LEFT);
+        cpu_reg_set(cpu, d->r_src, cpu->alu.value);
         cpu_combine_alu_flags(cpu, SHIFT_FLAGS_SRC);
     } break;
 
     case ROT_R8: {
-        alu_carry_rotate(&cpu->alu, cpu_reg_get(cpu, extract_reg(lu->opcode, 0)), extract_rot_dir(lu->opcode), get_C(cpu->F));
-        cpu_reg_set(cpu, extract_reg(lu->opcode, 0), cpu->alu.value);
+        sync_F(cpu);
+        ALU_CARRY_ROTATE(&cpu->alu, cpu_reg_get(cpu, d->r_src), extract_rot_dir(lu->opcode), get_C(cpu->F));
+        cpu_reg_set(cpu, d->r_src, cpu->alu.value);
         cpu_combine_alu_flags(cpu, SHIFT_FLAGS_SRC);
     } break;
 
 
     // BIT TESTS (and set)
     case BIT_U3_R8: {
-        if (bit_get(cpu_reg_get(cpu, extract_reg(lu->opcode, 0)), extract_n3(lu->opcode)) == 0) {
+        if (bit_get(cpu_reg_get(cpu, d->r_src), d->r_dst) == 0) {
             cpu_combine_alu_flags(cpu, SET, CLEAR, SET, CPU);
         } else {
             cpu_combine_alu_flags(cpu, CLEAR, CLEAR, SET, CPU);
@@ -187,14 +354,73 @@ int cpu_dispatch_alu(const instruction_t* lu, cpu_t* cpu)
     } break;
 
     case CHG_U3_R8: {
-        data_t data = cpu_reg_get(cpu, extract_reg(lu->opcode, 0));
+        data_t data = cpu_reg_get(cpu, d->r_src);
         do_set_or_res(lu, &data);
-        cpu_reg_set(cpu, extract_reg(lu->opcode, 0), data);
+        cpu_reg_set(cpu, d->r_src, data);
+    } break;
+
+#if defined(ALU_TABLE) || defined(LAZY_FLAGS)
+    // ---------------------------------------------------------
+    // Handled by the provided library unless the ALU tables
+    // or the lazy flags are used
+
+    // SUB
+    case SUB_A_HLR: {
+        do_sub8(cpu, cpu_read_at_HL(cpu));
+    } break;
+
+    case SUB_A_N8: {
+        do_sub8(cpu, cpu_read_data_after_opcode(cpu));
+    } break;
+
+    case SUB_A_R8: {
+        do_sub8(cpu, cpu_reg_get(cpu, d->r_src));
+    } break;
+
+    case DEC_HLR: {
+        do_dec8(cpu, cpu_read_at_HL(cpu));
+        cpu_write_at_HL(cpu, cpu->alu.value);
+    } break;
+
+    case CP_A_HLR: {
+        do_cp8(cpu, cpu_read_at_HL(cpu));
+    } break;
+#endif
+
+#ifdef ALU_TABLE
+    // BIT MOVE (shift, swap)
+    case SRA_R8: {
+        alu_table_shiftR_A(&cpu->alu, cpu_reg_get(cpu, d->r_src));
+        cpu_reg_set(cpu, d->r_src, cpu->alu.value);
+        cpu_combine_alu_flags(cpu, SHIFT_FLAGS_SRC);
+    } break;
+
+    case SRL_R8: {
+        alu_table_shift(&cpu->alu, cpu_reg_get(cpu, d->r_src), RIGHT);
+        cpu_reg_set(cpu, d->r_src, cpu->alu.value);
+        cpu_combine_alu_flags(cpu, SHIFT_FLAGS_SRC);
+    } break;
+
+    case SWAP_R8: {
+        alu_table_swap4(&cpu->alu, cpu_reg_get(cpu, d->r_src));
+        cpu_reg_set(cpu, d->r_src, cpu->alu.value);
+        cpu_combine_alu_flags(cpu, SHIFT_FLAGS_SRC);
+    } break;
+
+    // MISC.
+    case DAA: {
+        sync_F(cpu);
+        cpu->alu.value = cpu->A;
+        cpu->alu.flags = cpu->F;
+        M_EXIT_IF_ERR(alu_table_bcd_adjust(&cpu->alu));
+        combine_flags_set_A(cpu, DAA_FLAGS_SRC);
     } break;
+#endif
 
     // ---------------------------------------------------------
     // All the others are handled elsewhere by provided library
     default:
+        sync_F(cpu); // the library reads F directly
         M_EXIT_IF_ERR(cpu_dispatch_alu_ext(lu, cpu));
         break;
     } // switch
@@ -5,16 +5,34 @@
  * @date 2019
  */
 #include "cpu-storage.h"
+#include "opcode-decode.h"
 
 // See cpu-storage.h
 data_t cpu_read_at_idx(const cpu_t* cpu, addr_t addr)
+{
+    if(cpu == NULL) {
+        return -1;
+    }
+    if(cpu->dma_lockout && addr < REGISTERS_START) {
+        return 0xFF; // the DMA has the bus
+    }
+
+    return cpu_peek_at_idx(cpu, addr);
+}
+
+// See cpu-storage.h
+data_t cpu_peek_at_idx(const cpu_t* cpu, addr_t addr)
 {
     if(cpu == NULL) {
         return -1;
     }
 
     data_t data = 0;
-    bus_read(*(cpu->bus),addr,&data);
+    if(cpu->io != NULL && bus_io_has(addr)) { // may be computed
+        bus_io_read(*(cpu->bus), *(cpu->io), addr, &data);
+    } else {
+        bus_read(*(cpu->bus),addr,&data);
+    }
 
     return data;
 }
@@ -25,6 +43,10 @@ addr_t cpu_read16_at_idx(const cpu_t* cpu, addr_t addr)
     if(cpu == NULL) {
         return -1;
     }
+    if((cpu->io != NULL && (bus_io_has(addr) || bus_io_has((addr_t)(addr + 1)))) // may be computed
+       || (cpu->dma_lockout && addr < REGISTERS_START)) { // or not reachable
+        return merge8(cpu_read_at_idx(cpu, addr), cpu_read_at_idx(cpu, (addr_t)(addr + 1)));
+    }
     addr_t data16 = 0;
     bus_read16(*(cpu->bus),addr,&data16);
 
@@ -37,7 +59,16 @@ int cpu_write_at_idx(cpu_t* cpu, addr_t addr, data_t data)
     if(cpu==NULL || cpu->bus==NULL) {
         return ERR_BAD_PARAMETER;
     }
+    if(cpu->dma_lockout && addr < REGISTERS_START) {
+        return ERR_NONE; // the DMA has the bus: nothing written, nothing to listen to
+    }
     cpu->write_listener=addr; // for the listeners
+    if(cpu->rom_read_only && addr < BANK_ROM_SIZE) {
+        return ERR_NONE; // the ROM (possibly shared) stays as read
+    }
+#ifdef PREDECODE
+    predecode_invalidate_addr(cpu->predecode, addr);
+#endif
     return bus_write(*(cpu->bus),addr,data);
 }
 
@@ -47,7 +78,21 @@ int cpu_write16_at_idx(cpu_t* cpu, addr_t addr, addr_t data16)
     if(cpu==NULL || cpu->bus==NULL) {
         return ERR_BAD_PARAMETER;
     }
+    if(cpu->dma_lockout && addr < REGISTERS_START) {
+        // its low byte dropped, its high one too unless from 0xFF00 on
+        return cpu_write_at_idx(cpu, (addr_t)(addr + 1), msb8(data16));
+    }
+    if(cpu->rom_read_only && addr < BANK_ROM_SIZE) {
+        // its low byte dropped, its high one too unless past the ROM
+        M_EXIT_IF_ERR(cpu_write_at_idx(cpu, (addr_t)(addr + 1), msb8(data16)));
+        cpu->write_listener=addr; // for the listeners
+        return ERR_NONE;
+    }
     cpu->write_listener=addr; // for the listeners
+#ifdef PREDECODE
+    predecode_invalidate_addr(cpu->predecode, addr);
+    predecode_invalidate_addr(cpu->predecode, (addr_t)(addr + 1));
+#endif
     return bus_write16(*(cpu->bus),addr,data16);
 }
 
@@ -81,6 +126,8 @@ int cpu_dispatch_storage(const instruction_t* lu, cpu_t* cpu)
 {
     M_REQUIRE_NON_NULL(cpu);
 
+    const decoded_instr_t* d = decoded_of(lu); // operands
+
     switch (lu->family) {
     case LD_A_BCR:
         cpu_reg_set(cpu, REG_A_CODE, cpu_read_at_idx(cpu, cpu_BC_get(cpu)));
@@ -129,7 +176,7 @@ int cpu_dispatch_storage(const instruction_t* lu, cpu_t* cpu)
         break;
 
     case LD_HLR_R8:
-        cpu_write_at_HL(cpu, cpu_reg_get(cpu, extract_reg(lu->opcode,0)));
+        cpu_write_at_HL(cpu, cpu_reg_get(cpu, d->r_src));
         break;
 
     case LD_N16R_A:
@@ -145,19 +192,19 @@ int cpu_dispatch_storage(const instruction_t* lu, cpu_t* cpu)
         break;
 
     case LD_R16SP_N16:
-        cpu_reg_pair_SP_set(cpu, extract_reg_pair(lu->opcode), cpu_read_addr_after_opcode(cpu)); // Does for other registers if not AF code
+        cpu_reg_pair_SP_set(cpu, d->pair, cpu_read_addr_after_opcode(cpu)); // Does for other registers if not AF code
         break;
 
     case LD_R8_HLR:
-        cpu_reg_set(cpu, extract_reg(lu->opcode,3), cpu_read_at_HL(cpu));
+        cpu_reg_set(cpu, d->r_dst, cpu_read_at_HL(cpu));
         break;
 
     case LD_R8_N8:
-        cpu_reg_set(cpu, extract_reg(lu->opcode,3), cpu_read_data_after_opcode(cpu));
+        cpu_reg_set(cpu, d->r_dst, cpu_read_data_after_opcode(cpu));
         break;
 
     case LD_R8_R8:
-        cpu_reg_set(cpu, extract_reg(lu->opcode,3), cpu_reg_get(cpu, extract_reg(lu->opcode,0)));
+        cpu_reg_set(cpu, d->r_dst, cpu_reg_get(cpu, d->r_src));
         break;
 
     case LD_SP_HL:
@@ -165,11 +212,11 @@ int cpu_dispatch_storage(const instruction_t* lu, cpu_t* cpu)
         break;
 
     case POP_R16:
-        cpu_reg_pair_set(cpu, extract_reg_pair(lu->opcode), cpu_SP_pop(cpu));
+        cpu_reg_pair_set(cpu, d->pair, cpu_SP_pop(cpu));
         break;
 
     case PUSH_R16:
-        cpu_SP_push(cpu, cpu_reg_pair_get(cpu, extract_reg_pair(lu->opcode)));
+        cpu_SP_push(cpu, cpu_reg_pair_get(cpu, d->pair));
         break;
 
     default:
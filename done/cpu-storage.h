@@ -26,6 +26,8 @@ extern "C" {
 
 /**
  * @brief Reads data from the bus at a given adress
+ *        (through the read handlers of the cpu, if any, see bus_io_t);
+ *        0xFF under 0xFF00 during the lockout of an OAM DMA (see cpu_t)
  *
  * @param cpu cpu to read from
  * @param addr address to read at
@@ -34,6 +36,17 @@ extern "C" {
  */
 data_t cpu_read_at_idx(const cpu_t* cpu, addr_t addr);
 
+/**
+ * @brief Reads data from the bus at a given adress as cpu_read_at_idx(), but
+ *        even during the lockout of an OAM DMA (for the hardware around the CPU)
+ *
+ * @param cpu cpu to read from
+ * @param addr address to read at
+ *
+ * @return data read
+ */
+data_t cpu_peek_at_idx(const cpu_t* cpu, addr_t addr);
+
 /**
  * @brief Reads data at HL address from bus
  */
@@ -42,9 +55,16 @@ data_t cpu_read_at_idx(const cpu_t* cpu, addr_t addr);
 
 /**
  * @brief Reads data after opcode from bus
+ *        (or from the instruction cache, see predecode.h)
  */
+#ifdef PREDECODE
+#define cpu_read_data_after_opcode(cpu)\
+    ((cpu)->fetched.instr != NULL ? (cpu)->fetched.imm8 : \
+     cpu_read_at_idx(cpu,(addr_t)((cpu)->PC + 1)))
+#else
 #define cpu_read_data_after_opcode(cpu)\
     cpu_read_at_idx(cpu,(addr_t)((cpu)->PC + 1))
+#endif
 
 /**
  * @brief Reads 16bit data from the bus at a given adress
@@ -59,11 +79,18 @@ addr_t cpu_read16_at_idx(const cpu_t* cpu, addr_t addr);
 /**
  * @brief Reads 16bit data after opcode from bus
  */
+#ifdef PREDECODE
+#define cpu_read_addr_after_opcode(cpu) \
+    FROM_GameBoy_16((cpu)->fetched.instr != NULL ? (cpu)->fetched.imm16 : \
+                    cpu_read16_at_idx(cpu, (addr_t)((cpu)->PC + 1)))
+#else
 #define cpu_read_addr_after_opcode(cpu) \
     FROM_GameBoy_16(cpu_read16_at_idx(cpu, (addr_t)((cpu)->PC + 1)))
+#endif
 
 /**
  * @brief Write data to the bus at a given adress
+ *        (dropped under 0xFF00 during the lockout of an OAM DMA, see cpu_t)
  *
  * @param cpu cpu to write to
  * @param addr address to write at
@@ -78,6 +105,7 @@ int cpu_write_at_idx(cpu_t* cpu, addr_t addr, data_t data);
 
 /**
  * @brief Write 16bit data to the bus at a given adress
+ *        (each byte dropped under 0xFF00 during the lockout of an OAM DMA)
  *
  * @param cpu cpu to write to
  * @param addr address to write at
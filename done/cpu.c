@@ -10,20 +10,18 @@
 #include "cpu-alu.h"
 #include "cpu-registers.h"
 #include "cpu-storage.h"
+#include "opcode-decode.h"
+
+#ifdef ALU_TABLE
+#include "alu_table.h"
+#endif
 
 // ======================================================================
-// See cpu.h
-int cpu_init(cpu_t* cpu)
+/**
+ * @brief Sets all the registers and the ALU at zero
+ */
+static void registers_init(cpu_t* cpu)
 {
-    M_REQUIRE_NON_NULL(cpu);
-
-    int err = component_create(&(cpu->high_ram), HIGH_RAM_SIZE);
-
-    if(err != ERR_NONE) {
-        return err;
-    }
-
-    // Initialize internal registers and ALU
     cpu_AF_set(cpu, 0);
     cpu_BC_set(cpu, 0);
     cpu_DE_set(cpu, 0);
@@ -44,6 +42,98 @@ int cpu_init(cpu_t* cpu)
     cpu->HALT=0;
 
     cpu->write_listener=0;
+    cpu->dma_lockout=0;
+
+#ifdef LAZY_FLAGS
+    cpu->lazy_flags.op = LAZY_NONE;
+#endif
+
+#ifdef PREDECODE
+    cpu->fetched.instr = NULL;
+#endif
+}
+
+/**
+ * @brief Starts a cpu, the high RAM of which is created
+ */
+static int start(cpu_t* cpu)
+{
+#ifdef ALU_TABLE
+    M_EXIT_IF_ERR(alu_table_init()); // generated only once, shared by all CPUs
+#endif
+
+    cpu->io = NULL; // plain bus unless given handlers (see gameboy_create())
+    cpu->rom_read_only = 0; // writes anywhere unless told (see gameboy_create())
+#ifdef PREDECODE
+    cpu->predecode = NULL; // no cache unless given one (see gameboy_create())
+#endif
+    registers_init(cpu);
+
+    return ERR_NONE;
+}
+
+// See cpu.h
+int cpu_init(cpu_t* cpu)
+{
+    M_REQUIRE_NON_NULL(cpu);
+
+    int err = component_create(&(cpu->high_ram), HIGH_RAM_SIZE);
+
+    if(err != ERR_NONE) {
+        return err;
+    }
+
+    return start(cpu);
+}
+
+// See cpu.h
+int cpu_init_in(cpu_t* cpu, memory_t* mem, data_t* high_ram)
+{
+    M_REQUIRE_NON_NULL(cpu);
+
+    M_EXIT_IF_ERR(component_create_in(&(cpu->high_ram), mem, high_ram, HIGH_RAM_SIZE));
+
+    return start(cpu);
+}
+
+// See cpu.h
+int cpu_reset(cpu_t* cpu)
+{
+    M_REQUIRE_NON_NULL(cpu);
+    M_REQUIRE_NON_NULL(cpu->high_ram.mem);
+
+    memset(cpu->high_ram.mem->memory, 0, cpu->high_ram.mem->size);
+    registers_init(cpu);
+
+    return ERR_NONE;
+}
+
+// See cpu.h
+int cpu_copy(cpu_t* dst, const cpu_t* src)
+{
+    M_REQUIRE_NON_NULL(dst);
+    M_REQUIRE_NON_NULL(src);
+    M_REQUIRE_NON_NULL(dst->high_ram.mem);
+    M_REQUIRE_NON_NULL(src->high_ram.mem);
+
+    bus_t* const bus = dst->bus;
+    bus_io_t* const io = dst->io;
+    const uint8_t rom_read_only = dst->rom_read_only;
+    const component_t high_ram = dst->high_ram;
+#ifdef PREDECODE
+    predecode_t* const predecode = dst->predecode;
+#endif
+
+    *dst = *src;
+
+    dst->bus = bus;
+    dst->io = io;
+    dst->rom_read_only = rom_read_only;
+    dst->high_ram = high_ram;
+#ifdef PREDECODE
+    dst->predecode = predecode;
+#endif
+    memcpy(high_ram.mem->memory, src->high_ram.mem->memory, high_ram.mem->size);
 
     return ERR_NONE;
 }
@@ -69,7 +159,9 @@ int cpu_plug(cpu_t* cpu, bus_t* bus)
 void cpu_free(cpu_t* cpu)
 {
     if(cpu != NULL) {
-        bus_unplug(*(cpu->bus), &(cpu->high_ram));
+        if(cpu->bus != NULL) { // plugged
+            bus_unplug(*(cpu->bus), &(cpu->high_ram));
+        }
         component_free(&(cpu->high_ram));
         cpu->bus=NULL; // remove cpu from bus
     }
@@ -82,13 +174,16 @@ void cpu_free(cpu_t* cpu)
  * @param cpu, the CPU which shall execute
  * @return error code
  *
- * See opcode.h and cpu.h
+ * See opcode.h, opcode-decode.h and cpu.h
  */
 static int cpu_dispatch(const instruction_t* lu, cpu_t* cpu)
 {
     M_REQUIRE_NON_NULL(lu);
     M_REQUIRE_NON_NULL(cpu);
 
+    // operands and timings, already extracted from the opcode
+    const decoded_instr_t* d = decoded_of(lu);
+
     // Reset ALU values
     cpu->alu.value=0;
     cpu->alu.flags=0;
@@ -167,31 +262,37 @@ static int cpu_dispatch(const instruction_t* lu, cpu_t* cpu)
     case LD_R8_N8:
     case LD_R8_R8:
     case LD_SP_HL:
+        M_EXIT_IF_ERR(cpu_dispatch_storage(lu, cpu));
+        break;
+
     case POP_R16:
     case PUSH_R16:
+        sync_F(cpu); // AF may be read or written
         M_EXIT_IF_ERR(cpu_dispatch_storage(lu, cpu));
         break;
 
     // JUMP
     case JP_CC_N16:
-        if(test_cc(extract_cc(lu->opcode), cpu->F)) {
-            cpu->PC = cpu_read_addr_after_opcode(cpu) - lu->bytes;
-            cpu->idle_time+=lu->xtra_cycles;
+        sync_F(cpu);
+        if(test_cc(d->cc, cpu->F)) {
+            cpu->PC = cpu_read_addr_after_opcode(cpu) - d->bytes;
+            cpu->idle_time+=d->xtra_cycles;
         }
         break;
 
     case JP_HL:
-        cpu->PC = cpu_HL_get(cpu) - lu->bytes;
+        cpu->PC = cpu_HL_get(cpu) - d->bytes;
         break;
 
     case JP_N16:
-        cpu->PC = cpu_read_addr_after_opcode(cpu) - lu->bytes;
+        cpu->PC = cpu_read_addr_after_opcode(cpu) - d->bytes;
         break;
 
     case JR_CC_E8:
-        if(test_cc(extract_cc(lu->opcode), cpu->F)) {
+        sync_F(cpu);
+        if(test_cc(d->cc, cpu->F)) {
             cpu->PC += ((int8_t)cpu_read_data_after_opcode(cpu));
-            cpu->idle_time+=lu->xtra_cycles;
+            cpu->idle_time+=d->xtra_cycles;
         }
         break;
 
@@ -202,34 +303,36 @@ static int cpu_dispatch(const instruction_t* lu, cpu_t* cpu)
 
     // CALLS
     case CALL_CC_N16:
-        if(test_cc(extract_cc(lu->opcode), cpu->F)) {
-            cpu_SP_push(cpu, cpu->PC + lu->bytes);
-            cpu->PC = cpu_read_addr_after_opcode(cpu) - lu->bytes;
-            cpu->idle_time+=lu->xtra_cycles;
+        sync_F(cpu);
+        if(test_cc(d->cc, cpu->F)) {
+            cpu_SP_push(cpu, cpu->PC + d->bytes);
+            cpu->PC = cpu_read_addr_after_opcode(cpu) - d->bytes;
+            cpu->idle_time+=d->xtra_cycles;
         }
         break;
 
     case CALL_N16:
-        cpu_SP_push(cpu, cpu->PC + lu->bytes);
-        cpu->PC = cpu_read_addr_after_opcode(cpu) - lu->bytes;
+        cpu_SP_push(cpu, cpu->PC + d->bytes);
+        cpu->PC = cpu_read_addr_after_opcode(cpu) - d->bytes;
         break;
 
 
     // RETURN (from call)
     case RET:
-        cpu->PC = cpu_SP_pop(cpu) - lu->bytes;
+        cpu->PC = cpu_SP_pop(cpu) - d->bytes;
         break;
 
     case RET_CC:
-        if(test_cc(extract_cc(lu->opcode), cpu->F)) {
-            cpu->PC = cpu_SP_pop(cpu) - lu->bytes;
-            cpu->idle_time+=lu->xtra_cycles;
+        sync_F(cpu);
+        if(test_cc(d->cc, cpu->F)) {
+            cpu->PC = cpu_SP_pop(cpu) - d->bytes;
+            cpu->idle_time+=d->xtra_cycles;
         }
         break;
 
     case RST_U3:
-        cpu_SP_push(cpu, cpu->PC + lu->bytes);
-        cpu->PC = extract_n3(lu->opcode)*8 - lu->bytes;
+        cpu_SP_push(cpu, cpu->PC + d->bytes);
+        cpu->PC = d->r_dst*8 - d->bytes;
         break;
 
 
@@ -240,7 +343,7 @@ static int cpu_dispatch(const instruction_t* lu, cpu_t* cpu)
 
     case RETI:
         cpu->IME = 1; // because always activated
-        cpu->PC = cpu_SP_pop(cpu) - lu->bytes;
+        cpu->PC = cpu_SP_pop(cpu) - d->bytes;
         break;
 
     case HALT:
@@ -259,8 +362,8 @@ static int cpu_dispatch(const instruction_t* lu, cpu_t* cpu)
 
     } // switch
 
-    cpu->PC+=lu->bytes; // adjust program counter for next instruction
-    cpu->idle_time+=lu->cycles-1; // adjust cpu cycles until next instruction
+    cpu->PC+=d->bytes; // adjust program counter for next instruction
+    cpu->idle_time+=d->cycles-1; // adjust cpu cycles until next instruction
 
     return ERR_NONE;
 }
@@ -297,6 +400,16 @@ static int cpu_do_cycle(cpu_t* cpu)
         cpu->PC=INTERRUPTION_START+8*i; // set program counter to treat interruption
         cpu->idle_time+=INTERRUPTION_CYCLES; // give time to treat interruption
     } else {
+#ifdef PREDECODE
+        const predecode_entry_t* cached = cpu->dma_lockout ? NULL // the ROM not reachable
+                                          : predecode_fetch(cpu->predecode, *(cpu->bus), cpu->PC);
+        if(cached != NULL) { // decoded from ROM, operands included
+            cpu->fetched = *cached;
+            cpu_dispatch(cpu->fetched.instr, cpu);
+            cpu->fetched.instr = NULL;
+            return ERR_NONE;
+        }
+#endif
         opcode_t next_opcode = cpu_read_at_idx(cpu,cpu->PC); // read next opcode
 
         if(next_opcode==PREFIXED) { // check if prefixed or direct instruction
@@ -19,6 +19,10 @@ extern "C" {
 #include "error.h"
 #include "opcode.h"
 
+#ifdef PREDECODE
+#include "predecode.h"
+#endif
+
 //=========================================================================
 /**
  * @brief Type to represent CPU interupts
@@ -48,6 +52,29 @@ typedef enum {
  */
 #define INTERRUPTION_CYCLES 5
 
+#ifdef LAZY_FLAGS
+//=========================================================================
+/**
+ * @brief ALU operations whose flags can be computed later (lazy flags mode)
+ */
+typedef enum {
+    LAZY_NONE, LAZY_ADD, LAZY_SUB, LAZY_INC, LAZY_DEC
+} lazy_op_t;
+
+/**
+ * @brief Last flag-setting ALU operation and its operands, kept instead of
+ *        its flags until F is actually read (see cpu_flags_sync()).
+ *        Only bytes, so that it fits in the padding at the end of cpu_t,
+ *        without making it any larger.
+ */
+typedef struct {
+    uint8_t op; // lazy_op_t
+    uint8_t x;
+    uint8_t y;
+    bit_t carry;
+} lazy_flags_t;
+#endif
+
 //=========================================================================
 /**
  * @brief Type to represent CPU
@@ -108,6 +135,27 @@ typedef struct cpu_t {
 
     uint8_t idle_time;
 
+    // read handlers of the I/O registers (NULL if none)
+    bus_io_t* io;
+
+    // whether its writes to the ROM (under BANK_ROM_SIZE) are dropped
+    uint8_t rom_read_only;
+
+    // during an OAM DMA: only 0xFF00-0xFFFF reachable (see lcdc_t.DMA_end)
+    uint8_t dma_lockout;
+
+#ifdef LAZY_FLAGS
+    // flags not yet written into F
+    lazy_flags_t lazy_flags;
+#endif
+
+#ifdef PREDECODE
+    // cache of the instructions decoded from ROM (NULL if none)
+    predecode_t* predecode;
+    // current instruction, if it comes from the cache (fetched.instr NULL otherwise)
+    predecode_entry_t fetched;
+#endif
+
 } cpu_t ;
 
 //=========================================================================
@@ -141,6 +189,44 @@ int cpu_plug(cpu_t* cpu, bus_t* bus);
 int cpu_init(cpu_t* cpu);
 
 
+/**
+ * @brief Starts the cpu as cpu_init() does, its high RAM being created on
+ *        memory it does not own (see component_create_in())
+ *
+ * @param cpu cpu to start
+ * @param mem memory structure to use for its high RAM
+ * @param high_ram content of its high RAM (HIGH_RAM_SIZE bytes)
+ *
+ * @return error code
+ */
+int cpu_init_in(cpu_t* cpu, memory_t* mem, data_t* high_ram);
+
+
+/**
+ * @brief Puts back a started cpu in the state cpu_init() leaves it in
+ *        (registers and high RAM at zero), keeping its memory, its bus
+ *        and its cache of instructions
+ *
+ * @param cpu cpu to reset
+ *
+ * @return error code
+ */
+int cpu_reset(cpu_t* cpu);
+
+
+/**
+ * @brief Copies the state of a cpu (registers and high RAM) into another
+ *        started one, which keeps its memory, its bus (read handlers and
+ *        ROM protection included) and its cache of instructions
+ *
+ * @param dst cpu to write to
+ * @param src cpu to copy
+ *
+ * @return error code
+ */
+int cpu_copy(cpu_t* dst, const cpu_t* src);
+
+
 /**
  * @brief Frees a cpu
  *
@@ -163,6 +249,26 @@ void cpu_request_interrupt(cpu_t* cpu, interrupt_t i);
  */
 int IF_IE_compare(cpu_t* cpu);
 
+/**
+ * @brief Writes into F the flags of the last ALU operation if they are still
+ *        pending (with -DLAZY_FLAGS; does nothing otherwise).
+ *        Must be called before reading or writing F from outside of the CPU.
+ *
+ * @param cpu cpu to update
+ *
+ * @return error code
+ */
+int cpu_flags_sync(cpu_t* cpu);
+
+/**
+ * @brief Makes F up to date before it is read (or overwritten) by an instruction
+ */
+#ifdef LAZY_FLAGS
+#define sync_F(cpu) M_EXIT_IF_ERR(cpu_flags_sync(cpu))
+#else
+#define sync_F(cpu) do {} while(0)
+#endif
+
 /**
  * @brief Check flag conditions
  *
@@ -0,0 +1,326 @@
+/**
+ * @file fast_forward.c
+ * @brief Busy-wait fast-forward for GameBoy Emulator
+ *
+ * @date 2020
+ */
+#include "fast_forward.h"
+#include "gameboy.h"
+
+// placed here to prevent an include loop
+#include "cpu-storage.h"
+
+/**
+ * @brief Cycle of the next LCD controller step, which may change LY, STAT,
+ *        IF... (the current cycle if the controller does something now)
+ */
+static uint64_t lcdc_next_event(gameboy_t* gameboy)
+{
+    const lcdc_t* lcdc = &(gameboy->screen);
+
+    if(lcdc->DMA_to <= GRAPH_RAM_END) { // DMA copied at the next cycle
+        return gameboy->cycles;
+    }
+
+    if(lcdc->next_cycle == UINT64_MAX) { // off...
+        if(cpu_read_at_idx(&(gameboy->cpu), REG_LCDC) & LCDC_REG_LCD_STATUS_MASK) {
+            return gameboy->cycles; // ...but switched on at the next cycle
+        }
+    }
+
+    if(lcdc->DMA_end != UINT64_MAX && lcdc->DMA_end - 1 < lcdc->next_cycle) {
+        return lcdc->DMA_end - 1; // end of the CPU bus lockout of a DMA (see lcdc_cycle())
+    }
+
+    return lcdc->next_cycle;
+}
+
+/**
+ * @brief Cycle of the next hardware event: LCD controller step (see
+ *        lcdc_next_event()) or end of a serial transfer
+ */
+static uint64_t next_event(gameboy_t* gameboy)
+{
+    const uint64_t lcdc = lcdc_next_event(gameboy);
+
+    return gameboy->serial.end < lcdc ? gameboy->serial.end : lcdc;
+}
+
+/**
+ * @brief Runs n quiet cycles at once
+ */
+static uint64_t skip(gameboy_t* gameboy, uint64_t n)
+{
+    if(n > 0) {
+        timer_fast_forward(&(gameboy->timer), n);
+        gameboy->cycles += n;
+        gameboy->cpu.write_listener = 0; // as after any cycle without CPU write
+    }
+    return n;
+}
+
+// ======================================================================
+/**
+ * @brief Takes a snapshot of the CPU state
+ */
+static void snapshot_take(cpu_t* cpu, fast_forward_snapshot_t* s)
+{
+#ifdef LAZY_FLAGS
+    cpu_flags_sync(cpu);
+#endif
+    s->AF = cpu->AF;
+    s->BC = cpu->BC;
+    s->DE = cpu->DE;
+    s->HL = cpu->HL;
+    s->SP = cpu->SP;
+    s->IME = cpu->IME;
+    s->IE = cpu->IE;
+    s->IF = cpu->IF;
+}
+
+/**
+ * @brief Tells if two snapshots are identical
+ */
+static int snapshot_equal(const fast_forward_snapshot_t* s1, const fast_forward_snapshot_t* s2)
+{
+    return s1->AF == s2->AF && s1->BC == s2->BC && s1->DE == s2->DE
+           && s1->HL == s2->HL && s1->SP == s2->SP
+           && s1->IME == s2->IME && s1->IE == s2->IE && s1->IF == s2->IF;
+}
+
+// ======================================================================
+/**
+ * @brief Instruction at a given address
+ */
+static const instruction_t* instruction_at(const cpu_t* cpu, addr_t pc)
+{
+    const data_t op = cpu_read_at_idx(cpu, pc);
+    return op == PREFIXED ? &instruction_prefixed[cpu_read_at_idx(cpu, (addr_t)(pc + 1))]
+           : &instruction_direct[op];
+}
+
+/**
+ * @brief Destination of a jump instruction
+ *
+ * @return 1 if lu is a jump (JR or JP to an immediate address), 0 otherwise
+ */
+static int jump_target(const cpu_t* cpu, addr_t pc, const instruction_t* lu, addr_t* target)
+{
+    switch(lu->family) {
+    case JR_E8:
+    case JR_CC_E8:
+        *target = (addr_t)(pc + lu->bytes + (int8_t) cpu_read_at_idx(cpu, (addr_t)(pc + 1)));
+        return 1;
+
+    case JP_N16:
+    case JP_CC_N16:
+        *target = FROM_GameBoy_16(cpu_read16_at_idx(cpu, (addr_t)(pc + 1)));
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Checks that the loop from head to its closing jump only reads memory
+ *        and changes registers (and leaves only through forward conditional
+ *        jumps), and sets its period and whether it may read DIV
+ *
+ * @return 1 if so, 0 otherwise
+ */
+static int analyse_loop(fast_forward_t* ff, const cpu_t* cpu, addr_t head, addr_t jump)
+{
+    // not too long, and neither in OAM nor in IO registers, which the hardware changes
+    if(jump < head || jump - head >= FAST_FORWARD_MAX_BODY
+       || (jump >= GRAPH_RAM_START && head <= REGISTERS_END)) {
+        return 0;
+    }
+
+    ff->period = 0;
+    ff->reads_div = 0;
+
+    for(unsigned int pc = head; pc <= jump; ) {
+        const instruction_t* lu = instruction_at(cpu, (addr_t) pc);
+
+        switch(lu->family) {
+        // registers only
+        case NOP:
+        case LD_R8_R8:
+        case LD_R8_N8:
+        case ADD_A_N8:
+        case ADD_A_R8:
+        case INC_R8:
+        case INC_R16SP:
+        case CP_A_N8:
+        case CP_A_R8:
+        case DEC_R8:
+        case DEC_R16SP:
+        case SUB_A_N8:
+        case SUB_A_R8:
+        case AND_A_N8:
+        case AND_A_R8:
+        case OR_A_N8:
+        case OR_A_R8:
+        case XOR_A_N8:
+        case XOR_A_R8:
+        case ROTA:
+        case ROTCA:
+        case ROTC_R8:
+        case ROT_R8:
+        case SWAP_R8:
+        case SLA_R8:
+        case SRA_R8:
+        case SRL_R8:
+        case BIT_U3_R8:
+        case CHG_U3_R8:
+        case CPL:
+        case SCCF:
+            break;
+
+        // memory reads at an address from registers
+        case LD_A_BCR:
+        case LD_A_CR:
+        case LD_A_DER:
+        case LD_R8_HLR:
+        case ADD_A_HLR:
+        case CP_A_HLR:
+        case SUB_A_HLR:
+        case AND_A_HLR:
+        case OR_A_HLR:
+        case XOR_A_HLR:
+        case BIT_U3_HLR:
+            ff->reads_div = 1; // may be
+            break;
+
+        // memory reads at a fixed address
+        case LD_A_N8R:
+            ff->reads_div |= (REGISTERS_START + cpu_read_at_idx(cpu, (addr_t)(pc + 1)) == REG_DIV);
+            break;
+
+        case LD_A_N16R:
+            ff->reads_div |= (FROM_GameBoy_16(cpu_read16_at_idx(cpu, (addr_t)(pc + 1))) == REG_DIV);
+            break;
+
+        case JR_E8:
+        case JR_CC_E8:
+        case JP_N16:
+        case JP_CC_N16: {
+            addr_t target = 0;
+            jump_target(cpu, (addr_t) pc, lu, &target);
+            if(pc == jump) {
+                if(target != head) {
+                    return 0;
+                }
+                ff->period += lu->xtra_cycles; // taken
+            } else if((target >= head && target <= jump) || lu->family == JR_E8 || lu->family == JP_N16) {
+                return 0; // not a loop exit
+            }
+        }
+        break;
+
+        default:
+            return 0;
+        }
+
+        ff->period += lu->cycles;
+        if(pc == jump) {
+            return 1;
+        }
+        pc += lu->bytes;
+    }
+
+    return 0; // the closing jump is not on an instruction boundary
+}
+
+/**
+ * @brief Starts observing one iteration of the loop
+ */
+static void arm(fast_forward_t* ff, gameboy_t* gameboy)
+{
+    ff->start = gameboy->cycles;
+    ff->event = next_event(gameboy);
+    ff->quiet_until = gameboy->cycles
+                      + timer_quiet_cycles(&(gameboy->timer), ff->reads_div, UINT64_MAX - gameboy->cycles);
+    snapshot_take(&(gameboy->cpu), &(ff->snapshot));
+    ff->armed = 1;
+}
+
+// ======================================================================
+// See fast_forward.h
+int fast_forward_init(fast_forward_t* ff)
+{
+    M_REQUIRE_NON_NULL(ff);
+
+    memset(ff, 0, sizeof(*ff));
+
+    return ERR_NONE;
+}
+
+// See fast_forward.h
+uint64_t fast_forward(fast_forward_t* ff, gameboy_t* gameboy, uint64_t max)
+{
+    if(ff == NULL || gameboy == NULL) {
+        return 0;
+    }
+
+    cpu_t* cpu = &(gameboy->cpu);
+    if(cpu->idle_time != 0) { // in the middle of an instruction
+        return 0;
+    }
+
+    // halted: nothing happens until an interrupt is requested
+    if(cpu->HALT) {
+        ff->armed = 0;
+        if(IF_IE_compare(cpu) != -1) {
+            return 0;
+        }
+        uint64_t n = next_event(gameboy) - gameboy->cycles;
+        n = timer_quiet_cycles(&(gameboy->timer), 0, n < max ? n : max);
+        return skip(gameboy, n);
+    }
+
+    const addr_t pc = cpu->PC;
+    const addr_t last_pc = ff->last_pc;
+    ff->last_pc = pc;
+
+    if(ff->armed) {
+        if(pc == ff->head) { // one iteration done
+            uint64_t skipped = 0;
+            fast_forward_snapshot_t now;
+            snapshot_take(cpu, &now);
+
+            if(gameboy->cycles - ff->start == ff->period   // the expected path
+               && snapshot_equal(&now, &(ff->snapshot))   // left the CPU unchanged
+               && next_event(gameboy) == ff->event // without any hardware event
+               && gameboy->cycles <= ff->quiet_until) {
+                // so will the next ones, up to the next event
+                uint64_t end = ff->event < ff->quiet_until ? ff->event : ff->quiet_until;
+                uint64_t n = end - gameboy->cycles;
+                if(n > max) {
+                    n = max;
+                }
+                skipped = skip(gameboy, n - n % ff->period);
+            }
+
+            arm(ff, gameboy);
+            return skipped;
+        }
+
+        if(pc > ff->head && pc <= ff->jump) { // still in the loop
+            return 0;
+        }
+        ff->armed = 0;
+    }
+
+    // backward jump just taken
+    addr_t target = 0;
+    if(pc <= last_pc && jump_target(cpu, last_pc, instruction_at(cpu, last_pc), &target)
+       && target == pc && analyse_loop(ff, cpu, pc, last_pc)) {
+        ff->head = pc;
+        ff->jump = last_pc;
+        arm(ff, gameboy);
+    }
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/**
+ * @file fast_forward.h
+ * @brief Busy-wait fast-forward for GameBoy Emulator
+ *        (used by gameboy_run_until() with -DFAST_FORWARD)
+ *
+ * Skips, at once, the cycles during which the CPU can only wait for the
+ * hardware:
+ *  - while it is halted and no interrupt is pending;
+ *  - while it runs a short polling loop: a backward JR/JP whose body only
+ *    reads memory and changes registers, and a whole iteration of which
+ *    was seen leaving the CPU exactly as it found it.
+ *
+ * Nothing the CPU may look at can change before the next hardware event:
+ * the next LCD controller step (lcdc_t.next_cycle), the end of a serial
+ * transfer (serial_t.end) or the next change of TIMA (or of DIV, if the
+ * loop may read it). So only whole loop iterations
+ * ending before that event are skipped, and the result is cycle-identical
+ * to running them.
+ *
+ * @date 2020
+ */
+
+#include <stdint.h>
+
+#include "cpu.h"
+#include "error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct gameboy_ gameboy_t;
+
+/**
+ * @brief maximal size of a polling loop body (in bytes, closing jump included)
+ */
+#define FAST_FORWARD_MAX_BODY 16
+
+//=========================================================================
+/**
+ * @brief CPU state compared between two iterations of a loop
+ */
+typedef struct {
+    uint16_t AF;
+    uint16_t BC;
+    uint16_t DE;
+    uint16_t HL;
+    uint16_t SP;
+    uint8_t IME;
+    uint8_t IE;
+    uint8_t IF;
+} fast_forward_snapshot_t;
+
+/**
+ * @brief loop detector state
+ */
+typedef struct {
+    addr_t last_pc;       // PC of the last instruction started
+    bit_t armed;          // a loop iteration is being observed
+    addr_t head;          // first instruction of the loop
+    addr_t jump;          // closing jump of the loop
+    uint64_t period;      // cycles of one iteration
+    bit_t reads_div;      // whether the loop may read DIV
+    uint64_t start;       // cycle at which the observed iteration started
+    uint64_t event;       // next hardware event seen at start
+    uint64_t quiet_until; // first cycle at which the timer may change something
+    fast_forward_snapshot_t snapshot; // CPU state at start
+} fast_forward_t;
+
+//=========================================================================
+/**
+ * @brief Initializes a loop detector
+ *
+ * @param ff detector to initialize
+ * @return error code
+ */
+int fast_forward_init(fast_forward_t* ff);
+
+/**
+ * @brief To be called before each Game Boy cycle: skips as many cycles as
+ *        possible from there (running the timer and counting the cycles)
+ *
+ * @param ff loop detector of the Game Boy
+ * @param gameboy Game Boy about to run a cycle
+ * @param max maximum number of cycles to skip
+ * @return number of cycles skipped (0 if the cycle has to be run)
+ */
+uint64_t fast_forward(fast_forward_t* ff, gameboy_t* gameboy, uint64_t max);
+
+#ifdef __cplusplus
+}
+#endif
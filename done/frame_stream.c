@@ -0,0 +1,293 @@
+/**
+ * @file frame_stream.c
+ * @brief Streaming of Game Boy frames to a file or a pipe, for GameBoy Emulator
+ *
+ * @date 2020
+ */
+#include <stdlib.h> // for calloc
+#include <string.h> // for strcmp, strchr
+#include <ctype.h> // for isdigit
+
+#include "frame_stream.h"
+#include "gameboy.h" // for GB_CYCLES_PER_S
+
+/**
+ * @brief grey level of each Game Boy color (as displayed by gbsimulator)
+ */
+#define GREY(color) ((uint8_t)(255 - 85 * (color)))
+
+/**
+ * @brief widest frame number of a file name pattern
+ */
+#define MAX_PATTERN_WIDTH 20
+
+static const char* const format_names[NB_FRAME_FORMATS] = { "raw", "pgm", "y4m" };
+
+// ======================================================================
+/**
+ * @brief Encodes and writes one frame
+ */
+static int write_frame(frame_stream_t* stream, const uint8_t* frame)
+{
+    uint8_t buffer[FRAME_PIXELS];
+    size_t size = FRAME_PIXELS;
+
+    if(stream->format == FRAME_RAW) {
+        size = FRAME_PIXELS / 4;
+        for(size_t i = 0; i < size; ++i) {
+            buffer[i] = (uint8_t)(frame[4 * i] << 6 | frame[4 * i + 1] << 4
+                                  | frame[4 * i + 2] << 2 | frame[4 * i + 3]);
+        }
+    } else {
+        for(size_t i = 0; i < size; ++i) {
+            buffer[i] = GREY(frame[i]);
+        }
+    }
+
+    FILE* out = stream->out;
+    if(out == NULL) { // one file per frame
+        char filename[FILENAME_MAX];
+        // the pattern itself is never used as a format
+        snprintf(filename, sizeof(filename), stream->zero_pad ? "%.*s%0*lu%s" : "%.*s%*lu%s",
+                 stream->prefix_length, stream->pattern, stream->width,
+                 (unsigned long) stream->written, stream->suffix);
+        out = fopen(filename, "wb");
+        if(out == NULL) {
+            return ERR_IO;
+        }
+    }
+
+    int err = ERR_NONE;
+    if(stream->format == FRAME_PGM
+       && fprintf(out, "P5\n%d %d\n255\n", LCD_WIDTH, LCD_HEIGHT) < 0) {
+        err = ERR_IO;
+    }
+    if(stream->format == FRAME_Y4M && fputs("FRAME\n", out) == EOF) {
+        err = ERR_IO;
+    }
+    if(err == ERR_NONE && fwrite(buffer, 1, size, out) != size) {
+        err = ERR_IO;
+    }
+
+    if(out != stream->out && fclose(out) != 0) {
+        err = ERR_IO;
+    }
+    return err;
+}
+
+// ======================================================================
+/**
+ * @brief Writer thread: writes the queued frames until the stream is closed
+ */
+static void* writer_main(void* arg)
+{
+    frame_stream_t* stream = arg;
+
+    pthread_mutex_lock(&stream->lock);
+    for(;;) {
+        while(stream->count == 0 && !stream->closing) {
+            pthread_cond_wait(&stream->not_empty, &stream->lock);
+        }
+        if(stream->count == 0) { // closing, and nothing left
+            break;
+        }
+
+        // the slot stays queued (hence not reused) while being written
+        const uint8_t* frame = stream->frames[stream->first];
+        pthread_mutex_unlock(&stream->lock);
+        const int err = stream->error == ERR_NONE ? write_frame(stream, frame) : ERR_NONE;
+        pthread_mutex_lock(&stream->lock);
+
+        if(err != ERR_NONE) {
+            stream->error = err;
+        }
+        ++(stream->written);
+        stream->first = (stream->first + 1) % FRAME_STREAM_QUEUE;
+        --(stream->count);
+        pthread_cond_signal(&stream->not_full);
+    }
+    pthread_mutex_unlock(&stream->lock);
+
+    return NULL;
+}
+
+// ======================================================================
+/**
+ * @brief Splits the pattern of the names of one file per frame around its
+ *        conversion of the frame number (see frame_stream.h)
+ */
+static int parse_pattern(frame_stream_t* stream, const char* pattern)
+{
+    const char* p = strchr(pattern, '%');
+    M_REQUIRE_NON_NULL(p);
+    stream->pattern = pattern;
+    stream->prefix_length = (int)(p - pattern);
+
+    ++p;
+    stream->zero_pad = *p == '0';
+    stream->width = 0;
+    for(; isdigit((unsigned char) *p); ++p) {
+        stream->width = stream->width * 10 + (*p - '0');
+        M_REQUIRE(stream->width <= MAX_PATTERN_WIDTH, ERR_BAD_PARAMETER,
+                  "frame number wider than %d in \"%s\"", MAX_PATTERN_WIDTH, pattern);
+    }
+    if(*p == 'l') {
+        ++p;
+    }
+    M_REQUIRE(*p == 'u' || *p == 'd' || *p == 'i', ERR_BAD_PARAMETER,
+              "no frame number conversion in \"%s\"", pattern);
+    stream->suffix = p + 1;
+    M_REQUIRE(strchr(stream->suffix, '%') == NULL, ERR_BAD_PARAMETER,
+              "more than one conversion in \"%s\"", pattern);
+
+    return ERR_NONE;
+}
+
+// ======================================================================
+// See frame_stream.h
+int frame_format_parse(const char* name, frame_format_t* format)
+{
+    M_REQUIRE_NON_NULL(name);
+    M_REQUIRE_NON_NULL(format);
+
+    for(int f = 0; f < NB_FRAME_FORMATS; ++f) {
+        if(strcmp(name, format_names[f]) == 0) {
+            *format = (frame_format_t) f;
+            return ERR_NONE;
+        }
+    }
+
+    return ERR_BAD_PARAMETER;
+}
+
+// ======================================================================
+// See frame_stream.h
+int frame_stream_open(frame_stream_t* stream, const char* filename, frame_format_t format)
+{
+    M_REQUIRE_NON_NULL(stream);
+    M_REQUIRE_NON_NULL(filename);
+    M_REQUIRE(format < NB_FRAME_FORMATS, ERR_BAD_PARAMETER, "unknown format %d", format);
+
+    memset(stream, 0, sizeof(*stream));
+    stream->format = format;
+
+    if(format == FRAME_PGM && strchr(filename, '%') != NULL) {
+        M_EXIT_IF_ERR(parse_pattern(stream, filename));
+    } else if(strcmp(filename, "-") == 0) {
+        stream->out = stdout;
+    } else {
+        stream->out = fopen(filename, "wb");
+        M_REQUIRE_NON_NULL_CUSTOM_ERR(stream->out, ERR_IO);
+    }
+
+    if(format == FRAME_Y4M
+       && fprintf(stream->out, "YUV4MPEG2 W%d H%d F%lu:%d Ip A1:1 Cmono\n", LCD_WIDTH, LCD_HEIGHT,
+                  (unsigned long) GB_CYCLES_PER_S, FRAME_TOTAL_CYCLES) < 0) {
+        if(stream->out != stdout) {
+            fclose(stream->out);
+        }
+        return ERR_IO;
+    }
+
+    stream->frames = calloc(FRAME_STREAM_QUEUE, sizeof(*stream->frames));
+    if(stream->frames == NULL) {
+        if(stream->out != NULL && stream->out != stdout) {
+            fclose(stream->out);
+        }
+        return ERR_MEM;
+    }
+
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->not_empty, NULL);
+    pthread_cond_init(&stream->not_full, NULL);
+    if(pthread_create(&stream->writer, NULL, writer_main, stream) != 0) {
+        pthread_mutex_destroy(&stream->lock);
+        pthread_cond_destroy(&stream->not_empty);
+        pthread_cond_destroy(&stream->not_full);
+        free(stream->frames);
+        stream->frames = NULL;
+        if(stream->out != NULL && stream->out != stdout) {
+            fclose(stream->out);
+        }
+        return ERR_MEM;
+    }
+
+    return ERR_NONE;
+}
+
+// ======================================================================
+// See frame_stream.h
+int frame_stream_push(frame_stream_t* stream, image_t* display)
+{
+    M_REQUIRE_NON_NULL(stream);
+    M_REQUIRE_NON_NULL(stream->frames);
+    M_REQUIRE_NON_NULL(display);
+    M_REQUIRE_NON_NULL(display->slab);
+    M_REQUIRE(display->width == LCD_WIDTH && display->height == LCD_HEIGHT, ERR_BAD_PARAMETER,
+              "display is not %d x %d", LCD_WIDTH, LCD_HEIGHT);
+
+    pthread_mutex_lock(&stream->lock);
+    while(stream->count == FRAME_STREAM_QUEUE) { // writer too late
+        pthread_cond_wait(&stream->not_full, &stream->lock);
+    }
+    const int err = stream->error;
+    uint8_t* frame = stream->frames[(stream->first + stream->count) % FRAME_STREAM_QUEUE];
+    pthread_mutex_unlock(&stream->lock);
+
+    if(err != ERR_NONE) {
+        return err;
+    }
+
+    // the slot is free: filled without holding the lock, by one scan of
+    // the msb and lsb planes of display
+    const uint32_t* msb = display->content[0].msb->content;
+    const uint32_t* lsb = display->content[0].lsb->content;
+    for(size_t y = 0; y < LCD_HEIGHT; ++y) {
+        for(size_t x = 0; x < LCD_WIDTH; ++x) {
+            const size_t w = x / IMAGE_LINE_WORD_BITS;
+            const size_t b = x % IMAGE_LINE_WORD_BITS;
+            frame[y * LCD_WIDTH + x] = (uint8_t)(((msb[w] >> b) & 1) << 1 | ((lsb[w] >> b) & 1));
+        }
+        msb += display->line_words;
+        lsb += display->line_words;
+    }
+
+    pthread_mutex_lock(&stream->lock);
+    ++(stream->count);
+    pthread_cond_signal(&stream->not_empty);
+    pthread_mutex_unlock(&stream->lock);
+
+    return ERR_NONE;
+}
+
+// ======================================================================
+// See frame_stream.h
+int frame_stream_close(frame_stream_t* stream)
+{
+    M_REQUIRE_NON_NULL(stream);
+    M_REQUIRE_NON_NULL(stream->frames);
+
+    pthread_mutex_lock(&stream->lock);
+    stream->closing = 1;
+    pthread_cond_signal(&stream->not_empty);
+    pthread_mutex_unlock(&stream->lock);
+    pthread_join(stream->writer, NULL);
+
+    pthread_mutex_destroy(&stream->lock);
+    pthread_cond_destroy(&stream->not_empty);
+    pthread_cond_destroy(&stream->not_full);
+    free(stream->frames);
+    stream->frames = NULL;
+
+    if(stream->out != NULL) {
+        if(fflush(stream->out) != 0 && stream->error == ERR_NONE) {
+            stream->error = ERR_IO;
+        }
+        if(stream->out != stdout && fclose(stream->out) != 0 && stream->error == ERR_NONE) {
+            stream->error = ERR_IO;
+        }
+        stream->out = NULL;
+    }
+
+    return stream->error;
+}
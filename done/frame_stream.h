@@ -0,0 +1,121 @@
+#pragma once
+
+/**
+ * @file frame_stream.h
+ * @brief Streaming of Game Boy frames to a file or a pipe, for GameBoy Emulator
+ *        (used by the headless mode of gbsimulator)
+ *
+ * Frames are copied into a queue by the emulation thread; encoding and
+ * writing happen on a background thread. The emulation only waits when the
+ * writer is FRAME_STREAM_QUEUE frames late (no frame is ever dropped).
+ *
+ * Formats:
+ *  - raw: 2 bits per pixel (the Game Boy colors 0 to 3), 4 pixels per byte,
+ *         leftmost pixel in the most significant bits, no header;
+ *  - pgm: binary greymap (P5) per frame; one file per frame if the output
+ *         name holds a conversion of the frame number, the only '%' it may
+ *         hold ("%lu", or e.g. "%05lu" in "frame%05lu.pgm", "d", "i" and
+ *         "u" with or without "l"), concatenated frames otherwise
+ *         (ffmpeg -f image2pipe);
+ *  - y4m: YUV4MPEG2 monochrome stream at the Game Boy framerate
+ *         (e.g. ffmpeg -i - out.mp4).
+ *
+ * @date 2020
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "image.h"
+#include "lcdc.h"
+#include "error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief number of frames waiting to be written before the emulation waits
+ */
+#define FRAME_STREAM_QUEUE 64
+
+/**
+ * @brief number of pixels of one frame
+ */
+#define FRAME_PIXELS (LCD_WIDTH * LCD_HEIGHT)
+
+/**
+ * @brief output formats
+ */
+typedef enum {
+    FRAME_RAW,
+    FRAME_PGM,
+    FRAME_Y4M,
+    NB_FRAME_FORMATS
+} frame_format_t;
+
+/**
+ * @brief frame stream: queue of frames and its writer thread
+ */
+typedef struct {
+    frame_format_t format;
+    FILE* out;              // NULL when writing one file per frame
+    const char* pattern;    // name of the files, one per frame, up to the conversion
+    int prefix_length;      // length of pattern before its conversion
+    int width;              // minimum number of characters of the frame number
+    int zero_pad;           // whether the frame number is padded with zeros
+    const char* suffix;     // rest of pattern, after its conversion
+    uint8_t (*frames)[FRAME_PIXELS]; // queue of frames (Game Boy colors 0 to 3)
+    size_t first;           // index of the oldest queued frame
+    size_t count;           // number of queued frames
+    uint64_t written;       // number of frames written
+    int error;              // first write error (ERR_NONE if none)
+    int closing;            // no more frames will be pushed
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} frame_stream_t;
+
+//=========================================================================
+/**
+ * @brief Gives the format of a given name ("raw", "pgm" or "y4m")
+ *
+ * @param name name of the format
+ * @param format (modified) the format
+ * @return error code
+ */
+int frame_format_parse(const char* name, frame_format_t* format);
+
+/**
+ * @brief Opens a stream and starts its writer thread
+ *
+ * @param stream stream to open
+ * @param filename output file name ("-" for standard output), or pattern of
+ *        the names of one file per frame (pgm only, see above)
+ * @param format output format
+ * @return error code (ERR_BAD_PARAMETER for a pattern holding another '%')
+ */
+int frame_stream_open(frame_stream_t* stream, const char* filename, frame_format_t format);
+
+/**
+ * @brief Queues a copy of a frame for writing
+ *
+ * @param stream stream to write to
+ * @param display frame to write (LCD_WIDTH x LCD_HEIGHT)
+ * @return error code (including the last write error, if any)
+ */
+int frame_stream_push(frame_stream_t* stream, image_t* display);
+
+/**
+ * @brief Writes all the queued frames, stops the writer thread and closes the output
+ *
+ * @param stream stream to close
+ * @return error code (first write error, if any)
+ */
+int frame_stream_close(frame_stream_t* stream);
+
+#ifdef __cplusplus
+}
+#endif
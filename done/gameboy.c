@@ -3,20 +3,30 @@
 // placed here to prevent an include loop
 #include "bootrom.h"
 #include "timer.h"
+#include "cpu-storage.h" // for cpu_read_at_idx
 
-#ifdef BLARGG
-#include <stdio.h>
-#endif
+#include <stdlib.h> // for aligned_alloc, free
+#include <string.h> // for strcmp, strlen, memcmp
 
-// See gameboy.h
-int gameboy_create(gameboy_t* gameboy, const char* filename)
+static const char* const timing_names[NB_GB_TIMINGS] = { "exact", "line" };
+
+/**
+ * @brief Creates a gameboy, with the cartridge read from filename
+ *        if model is NULL, sharing the ROM of model otherwise
+ */
+static int create(gameboy_t* gameboy, const char* filename, const cartridge_t* model)
 {
 
-    M_REQUIRE_NON_NULL(gameboy);
-    M_REQUIRE_NON_NULL(filename);
+    // Resetting everything, bus and read handlers included: gameboy_free() then
+    // frees only what is set up, whatever gameboy held before
+    memset(gameboy, 0, sizeof(gameboy_t));
 
-    // Resetting bus
-    memset(&(gameboy->bus),0,BUS_SIZE*sizeof(data_t*));
+    // Allocating the memory of all the components but the cartridge at once
+    gameboy->arena = aligned_alloc(GB_ARENA_ALIGNMENT, GB_ARENA_SIZE);
+    if(gameboy->arena == NULL) {
+        return ERR_MEM;
+    }
+    memset(gameboy->arena, 0, GB_ARENA_SIZE);
 
     // Initialising gameboy components and plugging them to the bus
     gameboy->nb_components = 0;
@@ -38,12 +48,27 @@ int gameboy_create(gameboy_t* gameboy, const char* filename)
     M_EXIT_IF_ERR(bus_plug(gameboy->bus, &echo_ram, ECHO_RAM_START, ECHO_RAM_END)); // plug echo ram into bus
 
     // Initialising cpu and plugging it to the bus
-    M_EXIT_IF_ERR(cpu_init(&(gameboy->cpu)));
+    M_EXIT_IF_ERR(cpu_init_in(&(gameboy->cpu), &(gameboy->arena_mems[GB_ARENA_HIGH_RAM_MEM]),
+                              gameboy->arena + GB_ARENA_OFFSET(HIGH_RAM_START)));
+    gameboy->cpu.io = &(gameboy->io);
+    gameboy->cpu.rom_read_only = 1; // the cartridge may be shared (see gameboy_clone())
     M_EXIT_IF_ERR(cpu_plug(&(gameboy->cpu), &(gameboy->bus)));
+#ifdef PREDECODE
+    M_EXIT_IF_ERR(predecode_init(&(gameboy->predecode)));
+    gameboy->cpu.predecode = &(gameboy->predecode); // cache of the instructions read from ROM
+#endif
     gameboy->cycles = 0; // start cycle count
+    gameboy->timing = GB_TIMING_EXACT;
+#ifdef FAST_FORWARD
+    M_EXIT_IF_ERR(fast_forward_init(&(gameboy->ff))); // no loop seen yet
+#endif
 
     // Initialising cartridge and plugging it to the bus
-    M_EXIT_IF_ERR(cartridge_init(&(gameboy->cartridge), filename)); // create cartridge
+    if(model != NULL) {
+        M_EXIT_IF_ERR(cartridge_init_shared(&(gameboy->cartridge), model)); // no file read
+    } else {
+        M_EXIT_IF_ERR(cartridge_init(&(gameboy->cartridge), filename)); // create cartridge
+    }
     M_EXIT_IF_ERR(cartridge_plug(&(gameboy->cartridge), gameboy->bus));// plug cartridge to bus
 
     // Initialising timer
@@ -52,22 +77,166 @@ int gameboy_create(gameboy_t* gameboy, const char* filename)
     // Initialising joypad
     M_EXIT_IF_ERR(joypad_init_and_plug(&(gameboy->pad),&(gameboy->cpu))); // create and plug joypad
 
+    // Initialising serial port (nothing linked)
+    M_EXIT_IF_ERR(serial_init(&(gameboy->serial), &(gameboy->cpu)));
+
     // Initialising screen and plugging it to the bus
     M_EXIT_IF_ERR(lcdc_init(gameboy)); // create screen
     M_EXIT_IF_ERR(lcdc_plug(&(gameboy->screen),gameboy->bus)); // plug screen to bus
 
     //Initialising boot
     gameboy->boot=1; // set in bootmode
-    M_EXIT_IF_ERR(bootrom_init(&(gameboy->bootrom))); // create boot rom
+    M_EXIT_IF_ERR(bootrom_init_in(&(gameboy->bootrom), &(gameboy->arena_mems[GB_ARENA_BOOT_ROM_MEM]),
+                                  gameboy->arena + GB_ARENA_OFFSET(GB_ARENA_BOOT_ROM))); // create boot rom
     M_EXIT_IF_ERR(bootrom_plug(&(gameboy->bootrom), gameboy->bus)); // plug boot rom into bus
 
     return ERR_NONE;
 }
 
+// See gameboy.h
+int gameboy_create(gameboy_t* gameboy, const char* filename)
+{
+
+    M_REQUIRE_NON_NULL(gameboy);
+    M_REQUIRE_NON_NULL(filename);
+
+    return create(gameboy, filename, NULL);
+}
+
+// See gameboy.h
+int gameboy_create_from(gameboy_t* gameboy, const cartridge_t* cartridge)
+{
+    M_REQUIRE_NON_NULL(gameboy);
+    M_REQUIRE_NON_NULL(cartridge);
+
+    return create(gameboy, NULL, cartridge);
+}
+
+// See gameboy.h
+int gameboy_reset(gameboy_t* gameboy)
+{
+    M_REQUIRE_NON_NULL(gameboy);
+
+    // power-on content of the memory (the cartridge is only read)
+    for(int i = 0; i < GB_NB_COMPONENTS; ++i) {
+        memory_t* const mem = gameboy->components[i].mem;
+        M_REQUIRE_NON_NULL(mem);
+        memset(mem->memory, 0, mem->size);
+    }
+
+    M_EXIT_IF_ERR(cpu_reset(&(gameboy->cpu)));
+#ifdef PREDECODE
+    predecode_invalidate(&(gameboy->predecode));
+#endif
+    gameboy->cycles = 0;
+#ifdef FAST_FORWARD
+    M_EXIT_IF_ERR(fast_forward_init(&(gameboy->ff)));
+#endif
+    M_EXIT_IF_ERR(timer_init(&(gameboy->timer), &(gameboy->cpu)));
+    M_EXIT_IF_ERR(joypad_init_and_plug(&(gameboy->pad), &(gameboy->cpu)));
+    M_EXIT_IF_ERR(serial_reset(&(gameboy->serial)));
+    M_EXIT_IF_ERR(lcdc_reset(&(gameboy->screen)));
+
+    if(!gameboy->boot) { // the boot ROM is plugged again over the cartridge
+        gameboy->boot = 1;
+        M_EXIT_IF_ERR(bootrom_plug(&(gameboy->bootrom), gameboy->bus));
+    }
+
+    return ERR_NONE;
+}
+
+/**
+ * @brief Copies the state of a gameboy into another one, created with the same ROM
+ */
+static int copy_state(gameboy_t* dst, const gameboy_t* src)
+{
+    memcpy(dst->arena, src->arena, GB_ARENA_SIZE);
+    if(dst->boot != src->boot) {
+        if(src->boot) { // the boot ROM over the cartridge again
+            M_EXIT_IF_ERR(bootrom_plug(&(dst->bootrom), dst->bus));
+        } else { // the boot ROM already gave way to the cartridge
+            bus_unplug(dst->bus, &(dst->bootrom));
+            M_EXIT_IF_ERR(cartridge_plug(&(dst->cartridge), dst->bus));
+        }
+        dst->boot = src->boot;
+    }
+
+    M_EXIT_IF_ERR(cpu_copy(&(dst->cpu), &(src->cpu)));
+#ifdef PREDECODE
+    dst->predecode = src->predecode; // the decoded instructions are from the shared ROM
+#endif
+#ifdef FAST_FORWARD
+    dst->ff = src->ff;
+#endif
+    dst->cycles = src->cycles;
+    dst->timing = src->timing;
+    dst->timer.counter = src->timer.counter;
+
+    data_t* const p_P1 = dst->pad.p_P1;
+    dst->pad = src->pad;
+    dst->pad.cpu = &(dst->cpu);
+    dst->pad.p_P1 = p_P1;
+
+    serial_sink_t const sink = dst->serial.sink;
+    void* const opaque = dst->serial.opaque;
+    dst->serial = src->serial;
+    dst->serial.cpu = &(dst->cpu);
+    dst->serial.sink = sink;
+    dst->serial.opaque = opaque;
+
+    return lcdc_copy(&(dst->screen), &(src->screen));
+}
+
+// See gameboy.h
+int gameboy_clone(const gameboy_t* src, gameboy_t* dst)
+{
+    M_REQUIRE_NON_NULL(src);
+    M_REQUIRE_NON_NULL(dst);
+    M_REQUIRE(src != dst, ERR_BAD_PARAMETER, "%s", "clone of a gameboy into itself");
+
+    M_REQUIRE_NON_NULL(src->arena);
+
+    // its own memory and bus, sharing the ROM, then the state of src
+    int err = create(dst, NULL, &(src->cartridge));
+    if(err == ERR_NONE) {
+        err = serial_set_sink(&(dst->serial), src->serial.sink, src->serial.opaque); // same sink
+    }
+    if(err == ERR_NONE) {
+        err = copy_state(dst, src);
+    }
+    if(err != ERR_NONE) {
+        gameboy_free(dst);
+        return err;
+    }
+
+    return ERR_NONE;
+}
+
+// See gameboy.h
+int gameboy_copy(gameboy_t* dst, const gameboy_t* src)
+{
+    M_REQUIRE_NON_NULL(dst);
+    M_REQUIRE_NON_NULL(src);
+    M_REQUIRE_NON_NULL(dst->arena);
+    M_REQUIRE_NON_NULL(src->arena);
+    M_REQUIRE(dst->cartridge.c.mem == src->cartridge.c.mem, ERR_BAD_PARAMETER,
+              "%s", "copy between gameboys not sharing their ROM");
+
+    if(dst == src) {
+        return ERR_NONE;
+    }
+    return copy_state(dst, src);
+}
+
 // See gameboy.h
 int add_gameboy_component(int component_number, gameboy_t* gameboy, addr_t start, addr_t end)
 {
-    int errcode = component_create(&gameboy->components[component_number], end - start +1);
+    M_REQUIRE_NON_NULL(gameboy);
+    M_REQUIRE(start >= GB_ARENA_START, ERR_ADDRESS, "component at 0x%04X, out of the arena", start);
+
+    int errcode = component_create_in(&gameboy->components[component_number],
+                                      &gameboy->arena_mems[component_number],
+                                      gameboy->arena + GB_ARENA_OFFSET(start), end - start +1);
     if(errcode!=ERR_NONE) {
         return errcode;
     }
@@ -84,47 +253,302 @@ void gameboy_free(gameboy_t* gameboy)
 {
     for(int i = 0; i < GB_NB_COMPONENTS; ++i) {
         bus_unplug(gameboy->bus, &gameboy->components[i]); // unplug all components from bus
-        component_free(&gameboy->components[i]); // free component memory
+        component_release(&gameboy->components[i]); // memory freed with the arena
     }
     if(gameboy->boot==1) { // if ending before the end of the boot
         bootrom_unplug(&(gameboy->bootrom),gameboy->bus);
-        bootrom_free(&(gameboy->bootrom));
     }
+    component_release(&(gameboy->bootrom));
+    component_release(&(gameboy->cpu.high_ram)); // still unplugged by cpu_free()
     cpu_free(&(gameboy->cpu));
-    component_free(&(gameboy->bootrom));
     cartridge_free(&(gameboy->cartridge));
     lcdc_free(&(gameboy->screen));
+    free(gameboy->arena);
+    gameboy->arena = NULL;
 }
 
-#ifdef BLARGG
-static int blargg_bus_listener(gameboy_t* gameboy, addr_t addr)
+/**
+ * @brief Reports the last CPU write to the components listening to the bus
+ */
+static int bus_listeners(gameboy_t* gameboy)
 {
-    M_REQUIRE_NON_NULL(gameboy);
-    if(addr == BLARGG_REG) {
-        printf("%c", *(gameboy->bus[addr]));
+    M_EXIT_IF_ERR(timer_bus_listener(&(gameboy->timer), gameboy->cpu.write_listener));
+    M_EXIT_IF_ERR(bootrom_bus_listener(gameboy, gameboy->cpu.write_listener));
+    M_EXIT_IF_ERR(joypad_bus_listener(&(gameboy->pad),gameboy->cpu.write_listener));
+    M_EXIT_IF_ERR(lcdc_bus_listener(&(gameboy->screen),gameboy->cpu.write_listener, gameboy->cycles));
+    M_EXIT_IF_ERR(serial_bus_listener(&(gameboy->serial), gameboy->cpu.write_listener, gameboy->cycles));
+    return ERR_NONE;
+}
+
+/**
+ * @brief Progress of gameboy_run_to() towards its conditions
+ */
+typedef struct {
+    const gameboy_until_t* until;
+    uint64_t first;          // cycle the run started at
+    uint64_t frames;         // value of lcdc_t.frames to stop at
+    size_t serial_length;    // number of bytes captured already looked at
+    size_t pattern_length;
+    gameboy_until_flag_t reached;
+} until_state_t;
+
+/**
+ * @brief Whether the CPU is about to run the instruction at the PC to stop at
+ */
+static int until_pc(const gameboy_t* gameboy, const until_state_t* state)
+{
+    return (state->until->conditions & GB_UNTIL_PC)
+           && gameboy->cycles > state->first
+           && gameboy->cpu.PC == state->until->pc
+           && gameboy->cpu.idle_time == 0 && !gameboy->cpu.HALT;
+}
+
+/**
+ * @brief Tells the condition met by the memory, the frames or the serial
+ *        port, 0 if none
+ */
+static gameboy_until_flag_t until_state_check(gameboy_t* gameboy, until_state_t* state)
+{
+    const gameboy_until_t* const until = state->until;
+
+    if((until->conditions & GB_UNTIL_MEMORY)
+       && (cpu_peek_at_idx(&(gameboy->cpu), until->address) & until->mask) == until->value) {
+        return GB_UNTIL_MEMORY;
+    }
+    if((until->conditions & GB_UNTIL_FRAMES) && gameboy->screen.frames >= state->frames) {
+        return GB_UNTIL_FRAMES;
+    }
+    if(until->conditions & GB_UNTIL_SERIAL) {
+        size_t length = 0;
+        const char* output = serial_output(&(gameboy->serial), &length);
+        if(length != state->serial_length) { // new bytes
+            state->serial_length = length;
+            if(length >= state->pattern_length
+               && memcmp(output + length - state->pattern_length, until->serial, state->pattern_length) == 0) {
+                return GB_UNTIL_SERIAL;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Catches the timer up with a CPU write to its registers, in the
+ *        line mode: the cycles before the write are run on TIMA, TMA and
+ *        TAC as they were before it, and only then are the values written
+ *        put back
+ *
+ * @param gameboy gameboy whose CPU just wrote into the timer registers
+ * @param cycles number of cycles the timer is behind, up to the write
+ * @param regs TIMA, TMA and TAC before the write, updated to after it
+ * @return error code
+ */
+static int timer_catch_up_to_write(gameboy_t* gameboy, uint64_t cycles, data_t regs[TIMER_SIZE])
+{
+    cpu_t* const cpu = &(gameboy->cpu);
+    const addr_t written = cpu->write_listener; // not the timer writes
+    data_t values[TIMER_SIZE] = { 0 };
+
+    for(addr_t a = REG_TIMA; a <= REG_TAC; ++a) {
+        values[a - TIMER_START] = cpu_read_at_idx(cpu, a);
+        M_EXIT_IF_ERR(bus_write(*(cpu->bus), a, regs[a - TIMER_START]));
+    }
+    M_EXIT_IF_ERR(timer_catch_up(&(gameboy->timer), cycles));
+    for(addr_t a = REG_TIMA; a <= REG_TAC; ++a) {
+        // the CPU may have written two of them (16-bit write)
+        if(a == written || values[a - TIMER_START] != regs[a - TIMER_START]) {
+            M_EXIT_IF_ERR(bus_write(*(cpu->bus), a, values[a - TIMER_START]));
+        }
+        regs[a - TIMER_START] = cpu_read_at_idx(cpu, a);
     }
+    cpu->write_listener = written;
+
     return ERR_NONE;
 }
-#endif
 
-// See gameboy.h
-int gameboy_run_until(gameboy_t* gameboy, uint64_t cycle)
+/**
+ * @brief Runs until a given cycle, a line at a time (see GB_TIMING_LINE),
+ *        or until a condition of state (if not NULL) is met
+ */
+static int run_lines(gameboy_t* gameboy, uint64_t end, until_state_t* state)
+{
+    cpu_t* const cpu = &(gameboy->cpu);
+
+    while(gameboy->cycles < end) {
+        const uint64_t start = gameboy->cycles;
+        uint64_t slice_end = end - start < LINE_TOTAL_CYCLES ? end : start + LINE_TOTAL_CYCLES;
+        uint64_t timer_at = start; // cycle the timer is at
+        data_t timer_regs[TIMER_SIZE] = { 0 }; // TIMA, TMA and TAC as of timer_at
+        for(addr_t a = REG_TIMA; a <= REG_TAC; ++a) {
+            timer_regs[a - TIMER_START] = cpu_read_at_idx(cpu, a);
+        }
+
+        for(uint64_t c = start; c < slice_end; ) {
+            if(cpu->idle_time > 0) { // in the middle of an instruction
+                const uint64_t idle = cpu->idle_time < slice_end - c ? cpu->idle_time : slice_end - c;
+                cpu->idle_time = (uint8_t)(cpu->idle_time - idle);
+                c += idle;
+                continue;
+            }
+            if(state != NULL) {
+                gameboy->cycles = c;
+                if(until_pc(gameboy, state)) {
+                    state->reached = GB_UNTIL_PC;
+                    slice_end = c;
+                    break;
+                }
+            }
+            if(cpu->HALT && IF_IE_compare(cpu) == -1) { // nothing changes until the end of the slice
+                break;
+            }
+
+            if(cpu->dma_lockout) { // may end within the slice
+                lcdc_dma_unlock(&(gameboy->screen), c);
+            }
+            M_EXIT_IF_ERR(cpu_cycle(cpu));
+            ++c;
+            if(cpu->write_listener == 0) { // nothing written
+                continue;
+            }
+            gameboy->cycles = c;
+            if(cpu->write_listener >= TIMER_START && cpu->write_listener <= TIMER_END) {
+                M_EXIT_IF_ERR(timer_catch_up_to_write(gameboy, c - timer_at, timer_regs));
+                timer_at = c;
+            }
+            M_EXIT_IF_ERR(bus_listeners(gameboy));
+            if(state != NULL && (state->reached = until_state_check(gameboy, state)) != 0) {
+                slice_end = c;
+                break;
+            }
+        }
+
+        cpu->write_listener = 0;
+        M_EXIT_IF_ERR(timer_catch_up(&(gameboy->timer), slice_end - timer_at));
+        M_EXIT_IF_ERR(lcdc_run_until(&(gameboy->screen), start, slice_end));
+        M_EXIT_IF_ERR(serial_cycle(&(gameboy->serial), slice_end));
+        gameboy->cycles = slice_end;
+
+        if(state != NULL && (state->reached != 0
+                             || (state->reached = until_state_check(gameboy, state)) != 0)) {
+            return ERR_NONE;
+        }
+    }
+
+    return ERR_NONE;
+}
+
+/**
+ * @brief Runs until a given cycle, cycle by cycle,
+ *        or until a condition of state (if not NULL) is met
+ *
+ *        (inlined into its callers, so that the conditions are only
+ *        checked by gameboy_run_to())
+ */
+static inline int run_cycles(gameboy_t* gameboy, uint64_t end, until_state_t* state)
 {
-    for(int i=1; i<cycle; ++i) {
+#ifdef FAST_FORWARD
+    // the CPU goes through the loops skipped
+    const int skipping = state == NULL || !(state->until->conditions & (GB_UNTIL_PC | GB_UNTIL_MEMORY));
+#endif
+
+    while(gameboy->cycles < end) {
+#ifdef FAST_FORWARD
+        // cycles during which the CPU only waits for the hardware
+        if(skipping && fast_forward(&(gameboy->ff), gameboy, end - gameboy->cycles) > 0) {
+            continue;
+        }
+#endif
 
         M_EXIT_IF_ERR(timer_cycle(&(gameboy->timer)));
         M_EXIT_IF_ERR(cpu_cycle(&(gameboy->cpu)));
         M_EXIT_IF_ERR(lcdc_cycle(&(gameboy->screen),gameboy->cycles));
+        M_EXIT_IF_ERR(serial_cycle(&(gameboy->serial), gameboy->cycles));
         ++(gameboy->cycles);
 
-        M_EXIT_IF_ERR(timer_bus_listener(&(gameboy->timer), gameboy->cpu.write_listener));
-        M_EXIT_IF_ERR(bootrom_bus_listener(gameboy, gameboy->cpu.write_listener));
-        M_EXIT_IF_ERR(joypad_bus_listener(&(gameboy->pad),gameboy->cpu.write_listener));
-        M_EXIT_IF_ERR(lcdc_bus_listener(&(gameboy->screen),gameboy->cpu.write_listener));
-#ifdef BLARGG
-        M_EXIT_IF_ERR(blargg_bus_listener(gameboy, gameboy->cpu.write_listener));
+        M_EXIT_IF_ERR(bus_listeners(gameboy));
+
+        if(state != NULL) {
+            if(until_pc(gameboy, state)) {
+                state->reached = GB_UNTIL_PC;
+                return ERR_NONE;
+            }
+            if((state->reached = until_state_check(gameboy, state)) != 0) {
+                return ERR_NONE;
+            }
+        }
+    }
+
+    return ERR_NONE;
+}
+
+// See gameboy.h
+int gameboy_run_until(gameboy_t* gameboy, uint64_t cycle)
+{
+    M_REQUIRE_NON_NULL(gameboy);
+
+    if(gameboy->timing == GB_TIMING_LINE) {
+        return run_lines(gameboy, cycle, NULL);
+    }
+    return run_cycles(gameboy, cycle, NULL);
+}
+
+// See gameboy.h
+int gameboy_run_to(gameboy_t* gameboy, const gameboy_until_t* until, gameboy_until_flag_t* reached)
+{
+    M_REQUIRE_NON_NULL(gameboy);
+    M_REQUIRE_NON_NULL(until);
+    M_REQUIRE((until->conditions & ~(unsigned) GB_UNTIL_ALL) == 0, ERR_BAD_PARAMETER,
+              "unknown conditions 0x%X", until->conditions);
+    M_REQUIRE(!(until->conditions & GB_UNTIL_SERIAL) || (until->serial != NULL && until->serial[0] != '\0'),
+              ERR_BAD_PARAMETER, "%s", "no serial output to stop at");
+
+    until_state_t state;
+    state.until = until;
+    state.first = gameboy->cycles;
+    state.frames = gameboy->screen.frames + until->frames;
+    serial_output(&(gameboy->serial), &(state.serial_length)); // only the next bytes
+    state.pattern_length = until->conditions & GB_UNTIL_SERIAL ? strlen(until->serial) : 0;
+    state.reached = 0;
+
+#ifdef FAST_FORWARD
+    if(until->conditions & (GB_UNTIL_PC | GB_UNTIL_MEMORY)) {
+        fast_forward_init(&(gameboy->ff)); // forgets the loop being watched
+    }
 #endif
+
+    const int err = gameboy->timing == GB_TIMING_LINE ? run_lines(gameboy, until->cycle, &state)
+                    : run_cycles(gameboy, until->cycle, &state);
+    if(reached != NULL) {
+        *reached = state.reached != 0 ? state.reached : GB_UNTIL_CYCLE;
     }
 
+    return err;
+}
+
+// See gameboy.h
+int gameboy_set_timing(gameboy_t* gameboy, gameboy_timing_t timing)
+{
+    M_REQUIRE_NON_NULL(gameboy);
+    M_REQUIRE(timing < NB_GB_TIMINGS, ERR_BAD_PARAMETER, "unknown timing mode %d", timing);
+
+    gameboy->timing = timing;
+
     return ERR_NONE;
 }
+
+// See gameboy.h
+int gameboy_timing_parse(const char* name, gameboy_timing_t* timing)
+{
+    M_REQUIRE_NON_NULL(name);
+    M_REQUIRE_NON_NULL(timing);
+
+    for(int t = 0; t < NB_GB_TIMINGS; ++t) {
+        if(strcmp(name, timing_names[t]) == 0) {
+            *timing = (gameboy_timing_t) t;
+            return ERR_NONE;
+        }
+    }
+
+    return ERR_BAD_PARAMETER;
+}
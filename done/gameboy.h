@@ -16,6 +16,11 @@
 #include "error.h"
 #include "lcdc.h"
 #include "joypad.h"
+#include "serial.h"
+
+#ifdef FAST_FORWARD
+#include "fast_forward.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,13 +31,53 @@ extern "C" {
  */
 #define GB_NB_COMPONENTS 6
 
+/**
+ * @brief Arena the memory of a gameboy is carved out of (see gameboy_create()):
+ *        one page-aligned block mirroring the upper half of the address map,
+ *        each region at its address less GB_ARENA_START, the boot ROM in the
+ *        place of echo RAM (which is work RAM again); the cartridge ROM is
+ *        shared (see cartridge_init_shared()), thus not part of it
+ */
+#define GB_ARENA_START     VIDEO_RAM_START
+#define GB_ARENA_SIZE      (BUS_SIZE - GB_ARENA_START)
+#define GB_ARENA_ALIGNMENT 4096 // a page
+#define GB_ARENA_BOOT_ROM  ECHO_RAM_START
+#define GB_ARENA_OFFSET(addr) ((size_t)(addr) - GB_ARENA_START)
+
+// memory structures of the arena: the components, the high RAM, the boot ROM
+#define GB_ARENA_NB_MEMS     (GB_NB_COMPONENTS + 2)
+#define GB_ARENA_HIGH_RAM_MEM GB_NB_COMPONENTS
+#define GB_ARENA_BOOT_ROM_MEM (GB_NB_COMPONENTS + 1)
+
+/**
+ * @brief How gameboy_run_until() interleaves the CPU and the hardware
+ *
+ * GB_TIMING_LINE is an approximate mode for throughput: the CPU runs a
+ * whole slice of LINE_TOTAL_CYCLES cycles (skipping at once its idle
+ * cycles, and the rest of the slice when halted), then the timer and the
+ * LCD controller catch up with it, so their registers and interrupts are
+ * only updated at the slice boundaries (the timer is also caught up before
+ * any write to its registers). -DFAST_FORWARD is not used in this mode.
+ *
+ * The blargg ROMs passing cycle by cycle still pass in this mode (see
+ * tests/run_blargg.sh, given "line"), except instr_timing, which times
+ * the instructions with the timer.
+ */
+typedef enum {
+    GB_TIMING_EXACT, // cycle by cycle (default)
+    GB_TIMING_LINE,  // line by line
+    NB_GB_TIMINGS
+} gameboy_timing_t;
+
 /**
  * @brief Game Boy data structure.
  *        Regroups everything needed to simulate the Game Boy.
  */
 typedef struct gameboy_ {
     bus_t bus;
+    bus_io_t io; // read handlers of the I/O registers (see bus_io_t)
     cpu_t cpu;
+    lcdc_t screen;
     uint64_t cycles;
     gbtimer_t timer;
     cartridge_t cartridge;
@@ -40,8 +85,17 @@ typedef struct gameboy_ {
     uint8_t nb_components;
     component_t bootrom;
     uint8_t boot;
-    lcdc_t screen;
     joypad_t pad;
+    serial_t serial;
+    gameboy_timing_t timing;
+    data_t* arena;                           // see GB_ARENA_SIZE
+    memory_t arena_mems[GB_ARENA_NB_MEMS];   // of the components carved out of it
+#ifdef PREDECODE
+    predecode_t predecode;
+#endif
+#ifdef FAST_FORWARD
+    fast_forward_t ff;
+#endif
 } gameboy_;
 
 
@@ -55,8 +109,59 @@ typedef struct gameboy_ {
  */
 int gameboy_create(gameboy_t* gameboy, const char* filename);
 
+/**
+ * @brief Creates a gameboy sharing the ROM of an already read cartridge
+ *        (e.g. the one of another gameboy)
+ *
+ * @param gameboy pointer to gameboy to create
+ * @param cartridge cartridge to share the ROM of
+ * @return error code
+ */
+int gameboy_create_from(gameboy_t* gameboy, const cartridge_t* cartridge);
+
+/**
+ * @brief Creates a gameboy in the very state of another one, to be run
+ *        (and freed) independently of it
+ *
+ * The ROM is shared (see cartridge_init_shared()); everything the CPU may
+ * write (the arena, see GB_ARENA_SIZE) is copied at once, together with
+ * the display: as every write goes through the raw pointers of the bus,
+ * the clone gets its own memory and bus from the start, rather than sharing
+ * pages until the first write to them.
+ *
+ * With -DDEFERRED_RENDER, the clone waits for the drawing threads of src,
+ * and only starts its own once it has lines to draw (see lcdc_t).
+ *
+ * @param src gameboy to clone
+ * @param dst pointer to gameboy to create (freed if not created)
+ * @return error code
+ */
+int gameboy_clone(const gameboy_t* src, gameboy_t* dst);
+
+/**
+ * @brief Puts a created gameboy in the very state of another one sharing its
+ *        ROM (e.g. a clone of it, see gameboy_clone()), without allocating
+ *        anything: it keeps its own memory, bus and serial sink
+ *
+ * @param dst gameboy to write to
+ * @param src gameboy to copy
+ * @return error code (ERR_BAD_PARAMETER if they do not share their ROM)
+ */
+int gameboy_copy(gameboy_t* dst, const gameboy_t* src);
+
+/**
+ * @brief Puts a created gameboy back in its power-on state (as just
+ *        created, boot ROM plugged), without allocating nor reading
+ *        anything; its timing mode is kept
+ *
+ * @param gameboy pointer to gameboy to reset
+ * @return error code
+ */
+int gameboy_reset(gameboy_t* gameboy);
+
 /**
  * @brief Add a new component to the gameboy components array and plugs it to the bus
+ *        (its memory being carved out of the arena of the gameboy)
  *
  * @param number of the component to add in the array
  * @param gameboy pointer to add components to
@@ -68,7 +173,7 @@ int gameboy_create(gameboy_t* gameboy, const char* filename);
 int add_gameboy_component(int component_number, gameboy_t* gameboy, addr_t start, addr_t end);
 
 /**
- * @brief Destroys a gameboy
+ * @brief Destroys a gameboy (also one its creation failed on)
  *
  * @param gameboy pointer to gameboy to destroy
  * @return error code
@@ -76,14 +181,80 @@ int add_gameboy_component(int component_number, gameboy_t* gameboy, addr_t start
 void gameboy_free(gameboy_t* gameboy);
 
 /**
- * @brief Runs a gamefor for/until a given cycle
+ * @brief Runs a gameboy until a given cycle
  *
  * @param gameboy pointer to run
- * @param cycles to run
+ * @param cycle cycle to run until (nothing is run if already reached)
  * @return error code
  */
 int gameboy_run_until(gameboy_t* gameboy, uint64_t cycle);
 
+/**
+ * @brief Conditions gameboy_run_to() may stop at
+ */
+typedef enum {
+    GB_UNTIL_CYCLE  = 1 << 0, // the last cycle (always checked)
+    GB_UNTIL_PC     = 1 << 1, // the CPU is about to run the instruction at pc
+    GB_UNTIL_MEMORY = 1 << 2, // (byte at address & mask) == value
+    GB_UNTIL_FRAMES = 1 << 3, // frames more frames completed (vertical blanks)
+    GB_UNTIL_SERIAL = 1 << 4  // the bytes sent on the serial port end with serial
+} gameboy_until_flag_t;
+
+#define GB_UNTIL_ALL (GB_UNTIL_CYCLE | GB_UNTIL_PC | GB_UNTIL_MEMORY | GB_UNTIL_FRAMES | GB_UNTIL_SERIAL)
+
+/**
+ * @brief When gameboy_run_to() stops
+ *
+ * The conditions are checked after each cycle run (after each instruction,
+ * and at the end of each slice, in GB_TIMING_LINE mode), so that the
+ * gameboy stops at the first cycle meeting one of them; a call runs at least
+ * one cycle (unless cycle is already reached), so that it may be called again
+ * to go on from a met condition. Only the requested ones are checked.
+ *
+ * The serial port is only watched while it captures the bytes sent (see
+ * SERIAL_OUTPUT_SIZE and serial_output_clear()); with -DFAST_FORWARD, the
+ * busy-wait loops are not skipped when stopping at a PC or memory value.
+ */
+typedef struct {
+    unsigned conditions;  // gameboy_until_flag_t checked (or-ed), besides GB_UNTIL_CYCLE
+    uint64_t cycle;       // last cycle (UINT64_MAX if none)
+    addr_t pc;
+    addr_t address;
+    data_t mask;
+    data_t value;
+    uint64_t frames;
+    const char* serial;   // null terminated, not empty
+} gameboy_until_t;
+
+/**
+ * @brief Runs a gameboy until one of the given conditions is met
+ *
+ * @param gameboy pointer to run
+ * @param until conditions to stop at
+ * @param reached where to write the condition met, GB_UNTIL_CYCLE if
+ *        the last cycle was reached first (may be NULL)
+ * @return error code
+ */
+int gameboy_run_to(gameboy_t* gameboy, const gameboy_until_t* until, gameboy_until_flag_t* reached);
+
+/**
+ * @brief Changes how a gameboy is run (see gameboy_timing_t)
+ *
+ * @param gameboy pointer to gameboy
+ * @param timing the new timing mode
+ * @return error code
+ */
+int gameboy_set_timing(gameboy_t* gameboy, gameboy_timing_t timing);
+
+/**
+ * @brief Parses the name of a timing mode ("exact" or "line")
+ *
+ * @param name name to parse
+ * @param timing where to store the parsed mode
+ * @return error code (ERR_BAD_PARAMETER if unknown)
+ */
+int gameboy_timing_parse(const char* name, gameboy_timing_t* timing);
+
 /**
  * @brief Adresses of the GameBoy
  *
@@ -117,7 +288,6 @@ int gameboy_run_until(gameboy_t* gameboy, uint64_t cycle);
 
 // Memory-mapped "IO" registers
 #define REGS_START      0xFF00
-#define BLARGG_REG      0xFF01
 
 #define REGS_LCDC_START 0xFF40
 #define REGS_LCDC_END   0xFF4C
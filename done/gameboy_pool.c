@@ -0,0 +1,103 @@
+/**
+ * @file gameboy_pool.c
+ * @brief Pool of Game Boys running the same ROM
+ *
+ * @date 2020
+ */
+#include <stdlib.h> // for calloc, free
+
+#include "gameboy_pool.h"
+
+// See gameboy_pool.h
+int gameboy_pool_create(gameboy_pool_t* pool, const char* filename, size_t size)
+{
+    M_REQUIRE_NON_NULL(pool);
+    M_REQUIRE_NON_NULL(filename);
+    M_REQUIRE(size > 0, ERR_BAD_PARAMETER, "%s", "empty pool");
+
+    pool->size = 0;
+    pthread_mutex_init(&(pool->lock), NULL);
+    pool->gameboys = calloc(size, sizeof(gameboy_t));
+    pool->in_use = calloc(size, sizeof(uint8_t));
+    if(pool->gameboys == NULL || pool->in_use == NULL) {
+        gameboy_pool_free(pool);
+        return ERR_MEM;
+    }
+
+    // the first one reads the ROM, the others share it
+    int err = ERR_NONE;
+    for(size_t i = 0; i < size && err == ERR_NONE; ++i) {
+        err = i == 0 ? gameboy_create(&(pool->gameboys[i]), filename)
+              : gameboy_create_from(&(pool->gameboys[i]), &(pool->gameboys[0].cartridge));
+        pool->size = i + 1; // to be freed, even if partially created
+    }
+    if(err != ERR_NONE) {
+        gameboy_pool_free(pool);
+        return err;
+    }
+
+    return ERR_NONE;
+}
+
+// See gameboy_pool.h
+gameboy_t* gameboy_pool_acquire(gameboy_pool_t* pool)
+{
+    if(pool == NULL || pool->gameboys == NULL) {
+        return NULL;
+    }
+
+    gameboy_t* gameboy = NULL;
+    pthread_mutex_lock(&(pool->lock));
+    for(size_t i = 0; i < pool->size && gameboy == NULL; ++i) {
+        if(!pool->in_use[i]) {
+            pool->in_use[i] = 1;
+            gameboy = &(pool->gameboys[i]);
+        }
+    }
+    pthread_mutex_unlock(&(pool->lock));
+
+    return gameboy;
+}
+
+// See gameboy_pool.h
+int gameboy_pool_release(gameboy_pool_t* pool, gameboy_t* gameboy)
+{
+    M_REQUIRE_NON_NULL(pool);
+    M_REQUIRE_NON_NULL(pool->gameboys);
+    M_REQUIRE_NON_NULL(gameboy);
+    M_REQUIRE(gameboy >= pool->gameboys && gameboy < pool->gameboys + pool->size,
+              ERR_BAD_PARAMETER, "%s", "gameboy not from this pool");
+
+    const size_t i = (size_t)(gameboy - pool->gameboys);
+    M_REQUIRE(pool->in_use[i], ERR_BAD_PARAMETER, "gameboy %zu not handed out", i);
+
+    // reset before being available again, out of the lock
+    // (kept out of the pool if it cannot be)
+    M_EXIT_IF_ERR(gameboy_reset(gameboy));
+
+    pthread_mutex_lock(&(pool->lock));
+    pool->in_use[i] = 0;
+    pthread_mutex_unlock(&(pool->lock));
+
+    return ERR_NONE;
+}
+
+// See gameboy_pool.h
+void gameboy_pool_free(gameboy_pool_t* pool)
+{
+    if(pool == NULL) {
+        return;
+    }
+
+    if(pool->gameboys != NULL) {
+        for(size_t i = 0; i < pool->size; ++i) {
+            gameboy_free(&(pool->gameboys[i]));
+        }
+    }
+    pthread_mutex_destroy(&(pool->lock));
+    free(pool->gameboys);
+    free(pool->in_use);
+    pool->gameboys = NULL;
+    pool->in_use = NULL;
+    pool->size = 0;
+}
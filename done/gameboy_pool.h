@@ -0,0 +1,74 @@
+#pragma once
+
+/**
+ * @file gameboy_pool.h
+ * @brief Pool of Game Boys running the same ROM
+ *
+ * All the gameboys of a pool are created at once (the ROM file being read
+ * only once, and shared), and handed out at their power-on state: a released gameboy
+ * is reset (see gameboy_reset()) to be handed out again, without any
+ * allocation nor file read.
+ *
+ * The pool may be used from several threads.
+ *
+ * @date 2020
+ */
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include "gameboy.h"
+#include "error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief the pool itself
+ */
+typedef struct {
+    gameboy_t* gameboys;
+    uint8_t* in_use;     // whether each gameboy is handed out
+    size_t size;
+    pthread_mutex_t lock;
+} gameboy_pool_t;
+
+/**
+ * @brief Creates a pool of gameboys
+ *
+ * @param pool pool to create
+ * @param filename ROM file, read once
+ * @param size number of gameboys (at least 1)
+ * @return error code
+ */
+int gameboy_pool_create(gameboy_pool_t* pool, const char* filename, size_t size);
+
+/**
+ * @brief Hands out a gameboy of the pool, at its power-on state
+ *
+ * @param pool pool to take the gameboy from
+ * @return the gameboy (NULL if the pool is NULL or all its gameboys are handed out)
+ */
+gameboy_t* gameboy_pool_acquire(gameboy_pool_t* pool);
+
+/**
+ * @brief Gives a gameboy back to its pool, putting it back at its power-on state
+ *
+ * @param pool pool the gameboy was taken from
+ * @param gameboy gameboy to give back
+ * @return error code (ERR_BAD_PARAMETER if the gameboy is not handed out by this pool;
+ *         a gameboy failing to reset is not given back, and stays handed out)
+ */
+int gameboy_pool_release(gameboy_pool_t* pool, gameboy_t* gameboy);
+
+/**
+ * @brief Frees a pool and all its gameboys (handed out or not)
+ *
+ * @param pool pool to free
+ */
+void gameboy_pool_free(gameboy_pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,360 @@
+/**
+ * @file gb_vec.c
+ * @brief Many emulators stepped at once, over a pool of threads
+ *
+ * @date 2020
+ */
+#include <stdlib.h> // for calloc, free
+#include <pthread.h>
+
+#include "gb_vec.h"
+#include "gameboy.h" // for LCD_WIDTH, LCD_HEIGHT
+
+// the scales possible: dividing both LCD_WIDTH and LCD_HEIGHT
+#define MAX_SCALE 16
+
+// 2-bit gray levels to 8-bit ones
+static const uint8_t grays[4] = { 255, 170, 85, 0 };
+
+/**
+ * @brief a RAM byte observed
+ */
+typedef struct {
+    gbcore_region_t region;
+    size_t offset;          // in its region
+} ram_byte_t;
+
+/**
+ * @brief the threads, and what they observe
+ */
+struct gb_vec_ {
+    gb_vec_screen_t screen;
+    size_t scale;
+    size_t width;           // downscaled
+    size_t height;
+    size_t line_bytes;      // of the screen observed
+    size_t screen_size;
+    ram_byte_t* ram;
+    size_t ram_size;
+    size_t obs_size;
+
+    pthread_t* threads;
+    size_t nb_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t work;    // a call is given, or the threads are stopping
+    pthread_cond_t done;    // a thread is done with its call
+    uint64_t job;           // number of calls given
+    size_t busy;            // number of threads not done with the call
+    int stopping;
+
+    // the call going on
+    gbcore_t* const* envs;
+    const uint8_t* actions;
+    size_t n;
+    unsigned frames;
+    uint8_t* tensor;
+    size_t next;            // first emulator not handed out yet
+    size_t chunk;           // number of emulators handed out at once
+    int error;
+};
+
+// ======================================================================
+/**
+ * @brief Writes the screen of an emulator, downscaled
+ */
+static int observe_screen(const gb_vec_t* vec, const gbcore_t* env, uint8_t* out)
+{
+    gbcore_framebuffer_t fb;
+    M_EXIT_IF_ERR(gbcore_framebuffer(env, &fb));
+    M_REQUIRE(fb.width == LCD_WIDTH && fb.height == LCD_HEIGHT, ERR_BAD_PARAMETER,
+              "unexpected screen of %zu x %zu", fb.width, fb.height);
+
+    // one pixel out of scale, a word of each plane at a time
+    const size_t words = LCD_WIDTH / 32;
+    for(size_t y = 0; y < vec->height; ++y) {
+        const uint32_t* const msb = fb.msb + y * vec->scale * fb.line_words;
+        const uint32_t* const lsb = fb.lsb + y * vec->scale * fb.line_words;
+        uint8_t* const line = out + y * vec->line_bytes;
+        size_t x = 0;
+        uint8_t packed = 0;
+        for(size_t w = 0; w < words; ++w) {
+            const uint32_t high = msb[w];
+            const uint32_t low = lsb[w];
+            for(size_t bit = x * vec->scale - 32 * w; bit < 32; bit += vec->scale, ++x) {
+                const uint8_t level = (uint8_t) ((((high >> bit) & 1) << 1) | ((low >> bit) & 1));
+                if(vec->screen == GB_VEC_SCREEN_GRAY8) {
+                    line[x] = grays[level];
+                } else {
+                    packed |= (uint8_t) (level << (2 * (x % 4)));
+                    if(x % 4 == 3) {
+                        line[x / 4] = packed;
+                        packed = 0;
+                    }
+                }
+            }
+        }
+        if(vec->screen == GB_VEC_SCREEN_2BPP && x % 4 != 0) { // last byte, padded
+            line[x / 4] = packed;
+        }
+    }
+
+    return ERR_NONE;
+}
+
+// ======================================================================
+/**
+ * @brief Writes the observation of an emulator
+ */
+static int observe(const gb_vec_t* vec, const gbcore_t* env, uint8_t* out)
+{
+    if(vec->screen != GB_VEC_SCREEN_NONE) {
+        M_EXIT_IF_ERR(observe_screen(vec, env, out));
+    }
+
+    if(vec->ram_size > 0) {
+        gbcore_memory_t memory[GBCORE_NB_REGIONS];
+        for(int r = 0; r < GBCORE_NB_REGIONS; ++r) {
+            M_EXIT_IF_ERR(gbcore_memory(env, (gbcore_region_t) r, &memory[r]));
+        }
+        uint8_t* const ram = out + vec->screen_size;
+        for(size_t i = 0; i < vec->ram_size; ++i) {
+            ram[i] = memory[vec->ram[i].region].data[vec->ram[i].offset];
+        }
+    }
+
+    return ERR_NONE;
+}
+
+// ======================================================================
+/**
+ * @brief Steps emulator i of the call going on, and writes its observation
+ */
+static int step_env(const gb_vec_t* vec, size_t i)
+{
+    gbcore_t* const env = vec->envs[i];
+    M_REQUIRE_NON_NULL(env);
+
+    if(vec->actions != NULL) {
+        M_EXIT_IF_ERR(gbcore_set_input(env, vec->actions[i]));
+    }
+    for(unsigned f = 0; f < vec->frames; ++f) {
+        M_EXIT_IF_ERR(gbcore_step_frame(env));
+    }
+
+    return observe(vec, env, vec->tensor + i * vec->obs_size);
+}
+
+// ======================================================================
+/**
+ * @brief Steps the emulators of the call going on, a chunk at a time,
+ *        until none is left to hand out
+ *
+ * @return error code (of the first emulator failing here, if any)
+ */
+static int step_share(gb_vec_t* vec)
+{
+    int err = ERR_NONE;
+    for(;;) {
+        pthread_mutex_lock(&(vec->lock));
+        const size_t first = vec->next;
+        const size_t end = vec->n - first < vec->chunk ? vec->n : first + vec->chunk;
+        vec->next = end;
+        pthread_mutex_unlock(&(vec->lock));
+        if(first == end) {
+            return err;
+        }
+
+        for(size_t i = first; i < end; ++i) {
+            const int e = step_env(vec, i);
+            err = err == ERR_NONE ? e : err;
+        }
+    }
+}
+
+// ======================================================================
+/**
+ * @brief Stepping thread: takes its share of each call given
+ */
+static void* worker_main(void* arg)
+{
+    gb_vec_t* vec = arg;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&(vec->lock));
+    for(;;) {
+        while(vec->job == seen && !vec->stopping) {
+            pthread_cond_wait(&(vec->work), &(vec->lock));
+        }
+        if(vec->stopping) {
+            break;
+        }
+        seen = vec->job;
+        pthread_mutex_unlock(&(vec->lock));
+
+        const int err = step_share(vec);
+
+        pthread_mutex_lock(&(vec->lock));
+        if(vec->error == ERR_NONE) {
+            vec->error = err;
+        }
+        if(--(vec->busy) == 0) {
+            pthread_cond_signal(&(vec->done));
+        }
+    }
+    pthread_mutex_unlock(&(vec->lock));
+
+    return NULL;
+}
+
+// ======================================================================
+/**
+ * @brief Stops the threads started (the first nb_threads ones)
+ */
+static void workers_stop(gb_vec_t* vec)
+{
+    pthread_mutex_lock(&(vec->lock));
+    vec->stopping = 1;
+    pthread_cond_broadcast(&(vec->work));
+    pthread_mutex_unlock(&(vec->lock));
+    for(size_t k = 0; k < vec->nb_threads; ++k) {
+        pthread_join(vec->threads[k], NULL);
+    }
+    vec->nb_threads = 0;
+}
+
+// ======================================================================
+// See gb_vec.h
+int gb_vec_create(gb_vec_t** vec, const gb_vec_config_t* config)
+{
+    M_REQUIRE_NON_NULL(vec);
+    M_REQUIRE_NON_NULL(config);
+    M_REQUIRE(config->screen < GB_VEC_NB_SCREENS, ERR_BAD_PARAMETER,
+              "unknown screen format %d", config->screen);
+    M_REQUIRE(config->screen == GB_VEC_SCREEN_NONE
+              || (config->scale >= 1 && config->scale <= MAX_SCALE
+                  && LCD_WIDTH % config->scale == 0 && LCD_HEIGHT % config->scale == 0),
+              ERR_BAD_PARAMETER, "bad scale %zu", config->scale);
+    M_REQUIRE(config->ram_size == 0 || config->ram != NULL, ERR_BAD_PARAMETER,
+              "no RAM addresses given for %zu bytes", config->ram_size);
+    for(size_t i = 0; i < config->ram_size; ++i) {
+        M_REQUIRE(gbcore_region_of(config->ram[i], NULL, NULL) == ERR_NONE, ERR_BAD_PARAMETER,
+                  "address 0x%04X not in RAM", config->ram[i]);
+    }
+
+    gb_vec_t* const created = calloc(1, sizeof(gb_vec_t));
+    if(created == NULL) {
+        return ERR_MEM;
+    }
+
+    // the observation of each emulator: its screen, then its RAM bytes
+    created->screen = config->screen;
+    if(config->screen != GB_VEC_SCREEN_NONE) {
+        created->scale = config->scale;
+        created->width = LCD_WIDTH / config->scale;
+        created->height = LCD_HEIGHT / config->scale;
+        created->line_bytes = config->screen == GB_VEC_SCREEN_GRAY8 ? created->width
+                              : (created->width + 3) / 4;
+        created->screen_size = created->height * created->line_bytes;
+    }
+
+    created->ram = calloc(config->ram_size + 1, sizeof(ram_byte_t));
+    if(created->ram == NULL) {
+        free(created);
+        return ERR_MEM;
+    }
+    for(size_t i = 0; i < config->ram_size; ++i) {
+        gbcore_region_of(config->ram[i], &(created->ram[i].region), &(created->ram[i].offset));
+    }
+    created->ram_size = config->ram_size;
+    created->obs_size = created->screen_size + created->ram_size;
+
+    // the threads, waiting for the calls
+    pthread_mutex_init(&(created->lock), NULL);
+    pthread_cond_init(&(created->work), NULL);
+    pthread_cond_init(&(created->done), NULL);
+    created->threads = calloc(config->threads + 1, sizeof(pthread_t));
+    int err = created->threads == NULL ? ERR_MEM : ERR_NONE;
+    for(size_t k = 0; k < config->threads && err == ERR_NONE; ++k) {
+        if(pthread_create(&(created->threads[k]), NULL, worker_main, created) != 0) {
+            err = ERR_MEM;
+        } else {
+            ++(created->nb_threads);
+        }
+    }
+    if(err != ERR_NONE) {
+        gb_vec_free(created);
+        return err;
+    }
+
+    *vec = created;
+    return ERR_NONE;
+}
+
+// ======================================================================
+// See gb_vec.h
+size_t gb_vec_obs_size(const gb_vec_t* vec)
+{
+    return vec == NULL ? 0 : vec->obs_size;
+}
+
+// ======================================================================
+// See gb_vec.h
+int gb_vec_step(gb_vec_t* vec, gbcore_t* const envs[], const uint8_t actions[],
+                size_t n, unsigned frames, uint8_t* tensor)
+{
+    M_REQUIRE_NON_NULL(vec);
+    if(n == 0) {
+        return ERR_NONE;
+    }
+    M_REQUIRE_NON_NULL(envs);
+    M_REQUIRE_NON_NULL(tensor);
+
+    vec->envs = envs;
+    vec->actions = actions;
+    vec->n = n;
+    vec->frames = frames;
+    vec->tensor = tensor;
+    vec->next = 0;
+    vec->error = ERR_NONE;
+    // a few chunks per thread: shared evenly, whatever each emulator takes
+    const size_t shares = 4 * (vec->nb_threads + 1);
+    vec->chunk = n < shares ? 1 : n / shares;
+
+    if(vec->nb_threads == 0 || n == 1) {
+        return step_share(vec);
+    }
+
+    pthread_mutex_lock(&(vec->lock));
+    vec->busy = vec->nb_threads;
+    ++(vec->job);
+    pthread_cond_broadcast(&(vec->work));
+    pthread_mutex_unlock(&(vec->lock));
+
+    const int err = step_share(vec);
+
+    pthread_mutex_lock(&(vec->lock));
+    while(vec->busy > 0) {
+        pthread_cond_wait(&(vec->done), &(vec->lock));
+    }
+    if(vec->error == ERR_NONE) {
+        vec->error = err;
+    }
+    pthread_mutex_unlock(&(vec->lock));
+
+    return vec->error;
+}
+
+// ======================================================================
+// See gb_vec.h
+void gb_vec_free(gb_vec_t* vec)
+{
+    if(vec != NULL) {
+        workers_stop(vec);
+        pthread_cond_destroy(&(vec->work));
+        pthread_cond_destroy(&(vec->done));
+        pthread_mutex_destroy(&(vec->lock));
+        free(vec->threads);
+        free(vec->ram);
+        free(vec);
+    }
+}
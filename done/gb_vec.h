@@ -0,0 +1,106 @@
+#pragma once
+
+/**
+ * @file gb_vec.h
+ * @brief Many emulators stepped at once, over a pool of threads, their
+ *        observations written into one tensor (part of libgbcore)
+ *
+ * Made for training agents: each call of gb_vec_step() gives each
+ * emulator its keys, runs it for some frames, and writes what it shows
+ * into the caller's tensor, one row per emulator:
+ *
+ *     tensor[i * gb_vec_obs_size(vec) + ...] = screen of envs[i], then its RAM bytes
+ *
+ * The screen is downscaled (one pixel out of scale x scale), as 8-bit
+ * gray levels (255: white to 0: black), or as 2-bit ones packed four per byte
+ * (0: white to 3: black, pixel x in the bits 2 * (x % 4) and 2 * (x % 4) + 1
+ * of the byte x / 4 of its line, lines starting on whole bytes); the RAM bytes
+ * are the ones at the addresses chosen, in their order.
+ *
+ * The threads are started once, by gb_vec_create(), and wait between the
+ * calls: a call only hands its emulators out to them, the calling thread
+ * taking its share.
+ *
+ * @date 2020
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gbcore.h"
+#include "error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Screen formats of the observations
+ */
+typedef enum {
+    GB_VEC_SCREEN_NONE,  // RAM bytes only
+    GB_VEC_SCREEN_2BPP,  // 2-bit gray levels, four pixels per byte
+    GB_VEC_SCREEN_GRAY8, // 8-bit gray levels, one pixel per byte
+    GB_VEC_NB_SCREENS
+} gb_vec_screen_t;
+
+/**
+ * @brief What to observe, and with how many threads
+ */
+typedef struct {
+    gb_vec_screen_t screen;
+    size_t scale;           // 1, 2, 4, 8 or 16: width and height divided by it
+    const uint16_t* ram;    // addresses of the RAM bytes (see gbcore_region_of())
+    size_t ram_size;        // their number
+    size_t threads;         // besides the calling one (0: steps them all itself)
+} gb_vec_config_t;
+
+/**
+ * @brief the threads, and what they observe
+ */
+typedef struct gb_vec_ gb_vec_t;
+
+/**
+ * @brief Starts the threads stepping emulators
+ *
+ * @param vec where to write the new gb_vec_t
+ * @param config what to observe (copied)
+ * @return error code
+ */
+int gb_vec_create(gb_vec_t** vec, const gb_vec_config_t* config);
+
+/**
+ * @brief Size of the observation of one emulator, in bytes
+ *
+ * @param vec gb_vec_t
+ * @return the size of a row of the tensor (0 if vec is NULL)
+ */
+size_t gb_vec_obs_size(const gb_vec_t* vec);
+
+/**
+ * @brief Steps emulators, and writes what they show
+ *
+ * Each emulator runs on one thread at a time, but may not be given twice.
+ *
+ * @param vec gb_vec_t
+ * @param envs emulators to step
+ * @param actions gbcore_key_t or-ed of the keys held by each emulator,
+ *        for all the frames (NULL: the keys stay held as they are)
+ * @param n number of emulators
+ * @param frames number of frames to step each of them by (0: observes them only)
+ * @param tensor where to write the observations (n * gb_vec_obs_size(vec) bytes)
+ * @return error code (of one of the emulators failing, if any)
+ */
+int gb_vec_step(gb_vec_t* vec, gbcore_t* const envs[], const uint8_t actions[],
+                size_t n, unsigned frames, uint8_t* tensor);
+
+/**
+ * @brief Stops the threads, and frees a gb_vec_t (not the emulators)
+ *
+ * @param vec gb_vec_t to free (may be NULL)
+ */
+void gb_vec_free(gb_vec_t* vec);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,234 @@
+/**
+ * @file gbcore.c
+ * @brief Game Boy emulator core, to be embedded
+ *
+ * @date 2020
+ */
+#include <assert.h> // for static_assert
+#include <stdlib.h> // for calloc, free
+
+#include "gbcore.h"
+#include "gameboy.h"
+#include "bootrom.h"
+#include "joypad.h"
+#include "util.h" // for zero_init_var()
+
+/**
+ * @brief the emulator
+ */
+struct gbcore_ {
+    gameboy_t gb;
+    uint8_t keys; // held
+};
+
+/**
+ * @brief a saved state: a clone of the emulator saved
+ */
+struct gbcore_state_ {
+    gameboy_t gb;
+    uint8_t keys;
+};
+
+static_assert(GBCORE_RIGHT == 1 << RIGHT_KEY && GBCORE_LEFT == 1 << LEFT_KEY
+              && GBCORE_UP == 1 << UP_KEY && GBCORE_DOWN == 1 << DOWN_KEY
+              && GBCORE_A == 1 << A_KEY && GBCORE_B == 1 << B_KEY
+              && GBCORE_SELECT == 1 << SELECT_KEY && GBCORE_START == 1 << START_KEY,
+              "gbcore_key_t out of step with gb_key_t");
+
+/**
+ * @brief Addresses of the memory regions
+ */
+static const struct {
+    addr_t start;
+    addr_t end;
+} regions[GBCORE_NB_REGIONS] = {
+    [GBCORE_VIDEO_RAM]  = { VIDEO_RAM_START,  VIDEO_RAM_END },
+    [GBCORE_EXTERN_RAM] = { EXTERN_RAM_START, EXTERN_RAM_END },
+    [GBCORE_WORK_RAM]   = { WORK_RAM_START,   WORK_RAM_END },
+    [GBCORE_OAM]        = { GRAPH_RAM_START,  GRAPH_RAM_END },
+    [GBCORE_IO]         = { REGISTERS_START,  REGISTERS_END },
+    [GBCORE_HIGH_RAM]   = { HIGH_RAM_START,   HIGH_RAM_END }
+};
+
+// See gbcore.h
+int gbcore_create(gbcore_t** core, const char* filename)
+{
+    M_REQUIRE_NON_NULL(core);
+    M_REQUIRE_NON_NULL(filename);
+
+    gbcore_t* const created = calloc(1, sizeof(gbcore_t));
+    if(created == NULL) {
+        return ERR_MEM;
+    }
+    const int err = gameboy_create(&(created->gb), filename);
+    if(err != ERR_NONE) {
+        gameboy_free(&(created->gb));
+        free(created);
+        return err;
+    }
+
+    *core = created;
+    return ERR_NONE;
+}
+
+// See gbcore.h
+void gbcore_free(gbcore_t* core)
+{
+    if(core != NULL) {
+        gameboy_free(&(core->gb));
+        free(core);
+    }
+}
+
+// See gbcore.h
+int gbcore_reset(gbcore_t* core, int fast_boot)
+{
+    M_REQUIRE_NON_NULL(core);
+
+    M_EXIT_IF_ERR(gameboy_reset(&(core->gb)));
+    core->keys = 0; // the joypad is reset too
+    if(fast_boot) {
+        M_EXIT_IF_ERR(bootrom_fast_boot(&(core->gb)));
+    }
+
+    return ERR_NONE;
+}
+
+// See gbcore.h
+int gbcore_step_frame(gbcore_t* core)
+{
+    M_REQUIRE_NON_NULL(core);
+
+    gameboy_until_t until;
+    zero_init_var(until);
+    until.conditions = GB_UNTIL_FRAMES;
+    until.frames = 1;
+    until.cycle = core->gb.cycles + FRAME_TOTAL_CYCLES;
+    M_EXIT_IF_ERR(gameboy_run_to(&(core->gb), &until, NULL));
+
+    return lcdc_flush(&(core->gb.screen));
+}
+
+// See gbcore.h
+int gbcore_set_input(gbcore_t* core, uint8_t keys)
+{
+    M_REQUIRE_NON_NULL(core);
+
+    const uint8_t changed = core->keys ^ keys;
+    for(int key = 0; key < NB_GB_KEYS; ++key) {
+        if(changed & (1 << key)) {
+            M_EXIT_IF_ERR(keys & (1 << key) ? joypad_key_pressed(&(core->gb.pad), (gb_key_t) key)
+                          : joypad_key_released(&(core->gb.pad), (gb_key_t) key));
+        }
+    }
+    core->keys = keys;
+
+    return ERR_NONE;
+}
+
+// See gbcore.h
+uint64_t gbcore_cycles(const gbcore_t* core)
+{
+    return core == NULL ? 0 : core->gb.cycles;
+}
+
+// See gbcore.h
+int gbcore_framebuffer(const gbcore_t* core, gbcore_framebuffer_t* framebuffer)
+{
+    M_REQUIRE_NON_NULL(core);
+    M_REQUIRE_NON_NULL(framebuffer);
+
+    const image_t* const display = &(core->gb.screen.display);
+    M_REQUIRE_NON_NULL(display->slab);
+
+    // planes one after the other in the slab (see image_t)
+    const size_t plane_words = display->height * display->line_words;
+    framebuffer->msb = display->slab;
+    framebuffer->lsb = display->slab + plane_words;
+    framebuffer->width = display->width;
+    framebuffer->height = display->height;
+    framebuffer->line_words = display->line_words;
+
+    return ERR_NONE;
+}
+
+// See gbcore.h
+int gbcore_memory(const gbcore_t* core, gbcore_region_t region, gbcore_memory_t* memory)
+{
+    M_REQUIRE_NON_NULL(core);
+    M_REQUIRE_NON_NULL(memory);
+    M_REQUIRE(region < GBCORE_NB_REGIONS, ERR_BAD_PARAMETER, "unknown memory region %d", region);
+    M_REQUIRE_NON_NULL(core->gb.arena);
+
+    // all in the arena, at their address (see GB_ARENA_OFFSET)
+    memory->data = core->gb.arena + GB_ARENA_OFFSET(regions[region].start);
+    memory->start = regions[region].start;
+    memory->size = (size_t) (regions[region].end - regions[region].start + 1);
+
+    return ERR_NONE;
+}
+
+// See gbcore.h
+int gbcore_region_of(uint16_t address, gbcore_region_t* region, size_t* offset)
+{
+    for(int r = 0; r < GBCORE_NB_REGIONS; ++r) {
+        if(address >= regions[r].start && address <= regions[r].end) {
+            if(region != NULL) {
+                *region = (gbcore_region_t) r;
+            }
+            if(offset != NULL) {
+                *offset = (size_t) (address - regions[r].start);
+            }
+            return ERR_NONE;
+        }
+    }
+    return ERR_BAD_PARAMETER;
+}
+
+// See gbcore.h
+int gbcore_save(const gbcore_t* core, gbcore_state_t** state)
+{
+    M_REQUIRE_NON_NULL(core);
+    M_REQUIRE_NON_NULL(state);
+
+    if(*state != NULL) {
+        M_EXIT_IF_ERR(gameboy_copy(&((*state)->gb), &(core->gb)));
+        (*state)->keys = core->keys;
+        return ERR_NONE;
+    }
+
+    gbcore_state_t* const saved = calloc(1, sizeof(gbcore_state_t));
+    if(saved == NULL) {
+        return ERR_MEM;
+    }
+    const int err = gameboy_clone(&(core->gb), &(saved->gb));
+    if(err != ERR_NONE) { // its gameboy already freed
+        free(saved);
+        return err;
+    }
+    saved->keys = core->keys;
+
+    *state = saved;
+    return ERR_NONE;
+}
+
+// See gbcore.h
+int gbcore_load(gbcore_t* core, const gbcore_state_t* state)
+{
+    M_REQUIRE_NON_NULL(core);
+    M_REQUIRE_NON_NULL(state);
+
+    M_EXIT_IF_ERR(gameboy_copy(&(core->gb), &(state->gb)));
+    core->keys = state->keys; // as held in the joypad copied
+
+    return ERR_NONE;
+}
+
+// See gbcore.h
+void gbcore_state_free(gbcore_state_t* state)
+{
+    if(state != NULL) {
+        gameboy_free(&(state->gb));
+        free(state);
+    }
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+/**
+ * @file gbcore.h
+ * @brief Game Boy emulator core, to be embedded (libgbcore.a, libgbcore.so)
+ *
+ * Only this header (and error.h, for the error codes) is needed to use the
+ * library: the emulator behind a gbcore_t, and its saved states, are opaque.
+ * Nothing depends on GTK; libgbcore.so finds libcs212gbfinalext.so in its
+ * own directory (libgbcore.a needs -lcs212gbfinalext -lm -lpthread).
+ *
+ * The framebuffer and the memory are handed out as views into the
+ * emulator itself (no copy): they stay valid, and follow the emulation,
+ * until the core is freed.
+ *
+ * A core may be used from one thread at a time; distinct cores (and
+ * states) may be used from distinct threads (see gb_vec.h to step many
+ * cores at once).
+ *
+ * @date 2020
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief the emulator
+ */
+typedef struct gbcore_ gbcore_t;
+
+/**
+ * @brief a saved state of an emulator (see gbcore_save())
+ */
+typedef struct gbcore_state_ gbcore_state_t;
+
+/**
+ * @brief Keys given to gbcore_set_input() (or-ed)
+ */
+typedef enum {
+    GBCORE_RIGHT  = 1 << 0,
+    GBCORE_LEFT   = 1 << 1,
+    GBCORE_UP     = 1 << 2,
+    GBCORE_DOWN   = 1 << 3,
+    GBCORE_A      = 1 << 4,
+    GBCORE_B      = 1 << 5,
+    GBCORE_SELECT = 1 << 6,
+    GBCORE_START  = 1 << 7
+} gbcore_key_t;
+
+/**
+ * @brief the screen, as drawn
+ *
+ * Two planes of bits, line by line: the 2-bit gray level of pixel (x, y)
+ * (0: white to 3: black) has the bit x % 32 of msb[y * line_words + x / 32]
+ * as its most significant bit, and the one of lsb as its least significant.
+ */
+typedef struct {
+    const uint32_t* msb;
+    const uint32_t* lsb;
+    size_t width;
+    size_t height;
+    size_t line_words;
+} gbcore_framebuffer_t;
+
+/**
+ * @brief Memory regions of gbcore_memory()
+ */
+typedef enum {
+    GBCORE_VIDEO_RAM,
+    GBCORE_EXTERN_RAM,
+    GBCORE_WORK_RAM,
+    GBCORE_OAM,
+    GBCORE_IO,        // as last written (registers computed when read, e.g. DIV, excepted)
+    GBCORE_HIGH_RAM,
+    GBCORE_NB_REGIONS
+} gbcore_region_t;
+
+/**
+ * @brief a memory region
+ */
+typedef struct {
+    const uint8_t* data;
+    uint16_t start;       // Game Boy address of data[0]
+    size_t size;
+} gbcore_memory_t;
+
+/**
+ * @brief Creates an emulator, in its power-on state
+ *
+ * @param core where to write the new emulator
+ * @param filename ROM file
+ * @return error code
+ */
+int gbcore_create(gbcore_t** core, const char* filename);
+
+/**
+ * @brief Frees an emulator (and invalidates its views)
+ *
+ * @param core emulator to free (may be NULL)
+ */
+void gbcore_free(gbcore_t* core);
+
+/**
+ * @brief Puts an emulator back in its power-on state, without any allocation
+ *
+ * @param core emulator to reset
+ * @param fast_boot whether to start right after the boot ROM, without running it
+ * @return error code
+ */
+int gbcore_reset(gbcore_t* core, int fast_boot);
+
+/**
+ * @brief Runs an emulator until a frame is drawn
+ *        (at most one frame time, if its screen is off)
+ *
+ * @param core emulator to run
+ * @return error code
+ */
+int gbcore_step_frame(gbcore_t* core);
+
+/**
+ * @brief Sets the keys held from now on
+ *
+ * @param core emulator
+ * @param keys gbcore_key_t of the keys held, or-ed
+ * @return error code
+ */
+int gbcore_set_input(gbcore_t* core, uint8_t keys);
+
+/**
+ * @brief Number of cycles run since power-on
+ *
+ * @param core emulator
+ * @return its number of cycles (0 if core is NULL)
+ */
+uint64_t gbcore_cycles(const gbcore_t* core);
+
+/**
+ * @brief Gives the screen of an emulator
+ *
+ * @param core emulator
+ * @param framebuffer where to write the view of its screen
+ * @return error code
+ */
+int gbcore_framebuffer(const gbcore_t* core, gbcore_framebuffer_t* framebuffer);
+
+/**
+ * @brief Gives a memory region of an emulator
+ *
+ * @param core emulator
+ * @param region region wanted
+ * @param memory where to write the view of the region
+ * @return error code
+ */
+int gbcore_memory(const gbcore_t* core, gbcore_region_t region, gbcore_memory_t* memory);
+
+/**
+ * @brief Finds the memory region of a Game Boy address
+ *
+ * @param address Game Boy address
+ * @param region where to write its region (may be NULL)
+ * @param offset where to write its offset in the region, i.e. its index
+ *        in the data of gbcore_memory() (may be NULL)
+ * @return error code (ERR_BAD_PARAMETER if in none of the regions)
+ */
+int gbcore_region_of(uint16_t address, gbcore_region_t* region, size_t* offset);
+
+/**
+ * @brief Saves the state of an emulator
+ *
+ * @param core emulator to save
+ * @param state where the state is: a new one is created if *state is NULL,
+ *        else *state (saved from core before) is overwritten
+ * @return error code
+ */
+int gbcore_save(const gbcore_t* core, gbcore_state_t** state);
+
+/**
+ * @brief Puts an emulator back in a saved state, without any allocation
+ *
+ * @param core emulator to write to
+ * @param state state saved from core
+ * @return error code (ERR_BAD_PARAMETER if saved from another core)
+ */
+int gbcore_load(gbcore_t* core, const gbcore_state_t* state);
+
+/**
+ * @brief Frees a saved state
+ *
+ * @param state state to free (may be NULL)
+ */
+void gbcore_state_free(gbcore_state_t* state);
+
+#ifdef __cplusplus
+}
+#endif
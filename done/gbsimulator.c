@@ -1,7 +1,13 @@
 #include "sidlib.h"
 #include "gameboy.h"
+#include "bootrom.h"
+#include "frame_stream.h"
+#include "util.h" // for zero_init_var()
 
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <sys/time.h>
 
@@ -57,17 +63,51 @@ static void set_grey(guchar* pixels, int row, int col, int width, guchar grey)
 }
 
 // ======================================================================
+/**
+ * @brief number of pixbufs the generator draws into in turn (see sidlib.h)
+ */
+#define GB_NB_FRAMES 2
+
 static void generate_image(guchar* pixels, int height, int width)
 {
+    // lines to redraw in each pixbuf (which keeps the frame it was last given)
+    static guchar* frames[GB_NB_FRAMES] = { NULL };
+    static uint8_t to_draw[GB_NB_FRAMES][LCDC_LINES_BITMAP_SIZE];
+
     gameboy_run_until(&gb,get_time_in_GB_cyles_since(&start));
 
+    uint8_t dirty[LCDC_LINES_BITMAP_SIZE];
+    if(lcdc_take_dirty_lines(&(gb.screen), dirty) != ERR_NONE) {
+        memset(dirty, 0xFF, sizeof(dirty));
+    }
+
+    int f = 0;
+    while(f < GB_NB_FRAMES && frames[f] != pixels && frames[f] != NULL) {
+        ++f;
+    }
+    if(f == GB_NB_FRAMES || frames[f] == NULL) { // new pixbuf: draw it all
+        f %= GB_NB_FRAMES;
+        frames[f] = pixels;
+        memset(to_draw[f], 0xFF, sizeof(to_draw[f]));
+    }
+    for(int k=0; k<GB_NB_FRAMES; ++k) {
+        for(size_t b=0; b<LCDC_LINES_BITMAP_SIZE; ++b) {
+            to_draw[k][b] |= dirty[b];
+        }
+    }
+
     for(int i=0; i<height; ++i) {
+        const int y = i/GB_SCREEN_SCALE_FACTOR;
+        if(!bit_get(to_draw[f][y/8], y%8)) {
+            continue; // unchanged since this pixbuf was drawn
+        }
         for(int j=0; j<width; ++j) {
             uint8_t pixel_gameboy = 0;
-            image_get_pixel(&pixel_gameboy,&(gb.screen.display),j/GB_SCREEN_SCALE_FACTOR,i/GB_SCREEN_SCALE_FACTOR);
+            image_get_pixel(&pixel_gameboy,&(gb.screen.display),j/GB_SCREEN_SCALE_FACTOR,y);
             set_grey(pixels,i,j,width,(255 - 85 * pixel_gameboy));
         }
     }
+    memset(to_draw[f], 0, sizeof(to_draw[f]));
 }
 
 // ======================================================================
@@ -174,14 +214,121 @@ static gboolean keyrelease_handler(guint keyval, gpointer data)
 }
 #undef do_key
 
+// ======================================================================
+/**
+ * @brief default number of frames emulated in headless mode (one minute)
+ */
+#define HEADLESS_FRAMES 3600
+
+static void usage(const char* prog)
+{
+    fprintf(stderr, "usage: %s <rom> [--timing exact|line] [--fast-boot] [--headless [--format raw|pgm|y4m] [--output <file>] [--frames <n>]]\n"
+            "  --timing    exact: cycle by cycle (default); line: faster, a line at a time\n"
+            "  --fast-boot starts right after the boot ROM, without running it\n"
+            "  --headless  no display: emulates as fast as possible and writes the frames\n"
+            "  --format    output format (default: y4m)\n"
+            "  --output    output file, '-' for standard output (default),\n"
+            "              or e.g. frame%%05lu.pgm for one pgm file per frame\n"
+            "  --frames    number of frames to emulate (default: %d)\n", prog, HEADLESS_FRAMES);
+}
+
+// ======================================================================
+/**
+ * @brief Runs the Game Boy without any display, streaming its frames
+ */
+static int headless(const char* output, frame_format_t format, unsigned long frames)
+{
+    frame_stream_t stream;
+    M_EXIT_IF_ERR(frame_stream_open(&stream, output, format));
+
+    // each frame pushed once drawn, at the vertical blank
+    // (after at most a frame time, if the screen is off)
+    gameboy_until_t until;
+    zero_init_var(until);
+    until.conditions = GB_UNTIL_FRAMES;
+    until.frames = 1;
+
+    int err = ERR_NONE;
+    for(unsigned long f = 0; f < frames && err == ERR_NONE; ++f) {
+        until.cycle = gb.cycles + FRAME_TOTAL_CYCLES;
+        err = gameboy_run_to(&gb, &until, NULL);
+        if(err == ERR_NONE) {
+            err = lcdc_flush(&(gb.screen));
+        }
+        if(err == ERR_NONE) {
+            err = frame_stream_push(&stream, &(gb.screen.display));
+        }
+    }
+
+    const int close_err = frame_stream_close(&stream);
+    return err != ERR_NONE ? err : close_err;
+}
+
 // ======================================================================
 int main(int argc, char *argv[])
 {
+    if(argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char* const filename = argv[1];
+
+    // headless mode options
+    int is_headless = 0;
+    const char* output = "-";
+    frame_format_t format = FRAME_Y4M;
+    unsigned long frames = HEADLESS_FRAMES;
+    gameboy_timing_t timing = GB_TIMING_EXACT;
+    int fast_boot = 0;
+    for(int i = 2; i < argc; ++i) {
+        if(strcmp(argv[i], "--timing") == 0 && i + 1 < argc
+           && gameboy_timing_parse(argv[i + 1], &timing) == ERR_NONE) {
+            ++i;
+        } else if(strcmp(argv[i], "--fast-boot") == 0) {
+            fast_boot = 1;
+        } else if(strcmp(argv[i], "--headless") == 0) {
+            is_headless = 1;
+        } else if(strcmp(argv[i], "--format") == 0 && i + 1 < argc
+                  && frame_format_parse(argv[i + 1], &format) == ERR_NONE) {
+            ++i;
+        } else if(strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = strtoul(argv[++i], NULL, 10);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(is_headless) {
+        int err = gameboy_create(&gb, filename);
+        if(err == ERR_NONE && fast_boot) {
+            err = bootrom_fast_boot(&gb);
+        }
+        if(err == ERR_NONE) {
+            err = gameboy_set_timing(&gb, timing);
+        }
+        if(err == ERR_NONE) {
+            err = headless(output, format, frames);
+        }
+        gameboy_free(&gb);
+        if(err != ERR_NONE) {
+            fprintf(stderr, "%s: %s\n", argv[0], ERR_MESSAGES[err - ERR_NONE]);
+            return 1;
+        }
+        return 0;
+    }
+
     gettimeofday(&start,NULL);
     timerclear(&paused);
 
-    const char* const filename = argv[1];
     gameboy_create(&gb,filename);
+    if(fast_boot) {
+        bootrom_fast_boot(&gb);
+    }
+    gameboy_set_timing(&gb, timing);
     sd_launch(&argc, &argv,
               sd_init("Gameboy", LCD_WIDTH*GB_SCREEN_SCALE_FACTOR, LCD_HEIGHT*GB_SCREEN_SCALE_FACTOR, GB_FRAMERATE,
                       generate_image, keypress_handler, keyrelease_handler));
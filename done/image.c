@@ -119,84 +119,87 @@ int image_line_extract_wrap_ext(image_line_t* output, image_line_t iml, int64_t
 }
 
 // ======================================================================
-#define PALETTE_MASK_BIT 0x01
-
-int image_line_map_colors(image_line_t* output, image_line_t iml, palette_t map)
+image_line_view_t image_line_view_shift(image_line_t iml, int64_t shift)
 {
-    M_REQUIRE_NON_NULL(output);
-    M_REQUIRE_NON_NULL_IMAGE_LINE(iml);
+    image_line_view_t view;
 
-    if (map == DEFAULT_PALETTE) {
 #define do(I, X) \
-        I->X = bit_vector_cpy(iml.X)
+    I.X = bit_vector_view(0, iml.X, -shift, iml.X == NULL ? 0 : iml.X->size)
 
-        do_image_line(output);
+    do_image_line(view);
 #undef do
-        return ERR_NONE;
-    }
-
-    output->lsb = bit_vector_create(iml.lsb->size, 0);
-    output->msb = bit_vector_create(iml.msb->size, 0);
-    output->opacity = bit_vector_cpy(iml.opacity);
 
-    for (size_t i = 0; i < PALETTE_COLOR_COUNT; ++i) {
-        bit_vector_t* mask = NULL;
-
-        switch (i) {
-        case 0: {
-            bit_vector_t* tmp = bit_vector_not(bit_vector_cpy(iml.lsb));
-
-            if (tmp == NULL) {
-                image_line_free(output);
-                return ERR_MEM;
-            }
-
-            mask = bit_vector_and(bit_vector_not(bit_vector_cpy(iml.msb)), tmp);
-            bit_vector_free(&tmp);
-        } break;
+    return view;
+}
 
-        case 1: {
-            mask = bit_vector_and(bit_vector_not(bit_vector_cpy(iml.msb)), iml.lsb);
-        } break;
+// ======================================================================
+image_line_view_t image_line_view_extract_wrap_ext(image_line_t iml, int64_t index, size_t size)
+{
+    image_line_view_t view;
 
-        case 2: {
-            mask = bit_vector_and(bit_vector_not(bit_vector_cpy(iml.lsb)), iml.msb);
-        } break;
+#define do(I, X) \
+    I.X = bit_vector_view(1, iml.X, index, size)
 
-        case 3: {
-            mask = bit_vector_and(bit_vector_cpy(iml.lsb), iml.msb);
-        } break;
-        }
+    do_image_line(view);
+#undef do
 
-        if (mask == NULL) {
-            image_line_free(output);
-            return ERR_MEM;
-        }
+    return view;
+}
 
-        if (map & (PALETTE_MASK_BIT << (i * 2))) {
-            output->lsb = bit_vector_or(output->lsb, mask);
+// ======================================================================
+#define PALETTE_MASK_BIT 0x01
 
-            if (output->lsb == NULL) {
-                image_line_free(output);
-                return ERR_MEM;
+int image_line_map_colors_view(image_line_t* output, image_line_view_t view, palette_t map)
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL(view.msb.base);
+    M_REQUIRE_NON_NULL(view.lsb.base);
+    M_REQUIRE_NON_NULL(view.opacity.base);
+    M_REQUIRE(view.msb.size > 0, ERR_BAD_PARAMETER, "%s", "Size of view cannot be zero");
+    M_REQUIRE(view.msb.size == view.lsb.size && view.lsb.size == view.opacity.size, ERR_BAD_PARAMETER,
+              "Incorrect size in image_line_view (%lu, %lu, %lu)", view.msb.size, view.lsb.size, view.opacity.size);
+
+    const size_t size = view.msb.size;
+    output->msb     = bit_vector_create(size, 0);
+    output->lsb     = bit_vector_create(size, 0);
+    output->opacity = bit_vector_view_cpy(&view.opacity);
+    M_EXIT_IF_ERR(valid(output));
+
+    // one word (32 pixels) at a time: the pixels of color i get color map[i]
+    for (size_t w = 0; w < size_to_content_size(size); ++w) {
+        const uint32_t msb = bit_vector_view_word(&view.msb, w);
+        const uint32_t lsb = bit_vector_view_word(&view.lsb, w);
+        const uint32_t colors[PALETTE_COLOR_COUNT] = { ~msb & ~lsb, ~msb & lsb, msb & ~lsb, msb & lsb };
+
+        uint32_t out_msb = 0;
+        uint32_t out_lsb = 0;
+        for (size_t i = 0; i < PALETTE_COLOR_COUNT; ++i) {
+            if (map & (PALETTE_MASK_BIT << (i * 2))) {
+                out_lsb |= colors[i];
             }
-        }
-
-        if (map & (PALETTE_MASK_BIT << ((i * 2) + 1))) {
-            output->msb = bit_vector_or(output->msb, mask);
-
-            if (output->msb == NULL) {
-                image_line_free(output);
-                return ERR_MEM;
+            if (map & (PALETTE_MASK_BIT << ((i * 2) + 1))) {
+                out_msb |= colors[i];
             }
         }
 
-        bit_vector_free(&mask);
+        const size_t remaining = size - w * IMAGE_LINE_WORD_BITS;
+        const uint32_t mask = remaining < IMAGE_LINE_WORD_BITS ? GENERATE_FF(remaining) : 0xFFFFFFFF;
+        output->msb->content[w] = out_msb & mask;
+        output->lsb->content[w] = out_lsb & mask;
     }
 
     return ERR_NONE;
 }
 
+// ======================================================================
+int image_line_map_colors(image_line_t* output, image_line_t iml, palette_t map)
+{
+    M_REQUIRE_NON_NULL(output);
+    M_REQUIRE_NON_NULL_IMAGE_LINE(iml);
+
+    return image_line_map_colors_view(output, image_line_view_shift(iml, 0), map);
+}
+
 // ======================================================================
 int image_line_below_with_opacity(image_line_t* output, image_line_t iml1, image_line_t iml2, bit_vector_t* p_opacity)
 {
@@ -296,19 +299,42 @@ int image_create(image_t* pim, size_t width, size_t height)
     M_REQUIRE(width > 0, ERR_BAD_PARAMETER, "%s", "Parameter width is zero.");
     M_REQUIRE(height > 0, ERR_BAD_PARAMETER, "%s", "Parameter height is zero.");
 
+    const size_t words = size_to_content_size(width);
+    size_t bytes = IMAGE_PLANES * height * words * sizeof(uint32_t);
+    bytes = (bytes + IMAGE_ALIGNMENT - 1) / IMAGE_ALIGNMENT * IMAGE_ALIGNMENT; // as required by aligned_alloc
+
+    pim->slab = aligned_alloc(IMAGE_ALIGNMENT, bytes);
+    pim->vectors = calloc(IMAGE_PLANES * height, sizeof(bit_vector_t));
     pim->content = calloc(height, sizeof(image_line_t));
-    if (pim->content == NULL) return ERR_MEM;
+    if (pim->slab == NULL || pim->vectors == NULL || pim->content == NULL) {
+        free(pim->slab);
+        free(pim->vectors);
+        free(pim->content);
+        pim->slab = NULL;
+        pim->vectors = NULL;
+        pim->content = NULL;
+        pim->height = 0;
+        return ERR_MEM;
+    }
+    memset(pim->slab, 0, bytes);
 
     pim->height = height;
-
-    int error = ERR_NONE;
-    for (size_t i = 0; i < height && error == ERR_NONE; ++i) {
-        error = image_line_create(pim->content + i, width);
+    pim->width = width;
+    pim->line_words = words;
+
+    for (size_t p = 0; p < IMAGE_PLANES; ++p) {
+        for (size_t y = 0; y < height; ++y) {
+            bit_vector_t* const view = pim->vectors + p * height + y;
+            view->content = pim->slab + (p * height + y) * words;
+            view->size = width;
+            view->allocated = width;
+        }
     }
 
-    if (error != ERR_NONE) {
-        image_free(pim);
-        return error;
+    for (size_t y = 0; y < height; ++y) {
+        pim->content[y].msb     = pim->vectors + y;
+        pim->content[y].lsb     = pim->vectors + height + y;
+        pim->content[y].opacity = pim->vectors + 2 * height + y;
     }
 
     return ERR_NONE;
@@ -356,24 +382,51 @@ int image_own_line_content(image_t* pim, size_t y, image_line_t line)
     M_REQUIRE_MATCHING_IMAGE_LINE_SIZE(pim->content[y], line);
 
 #define do(I, X) \
-    bit_vector_free(&(I->content[y].X)); \
-    I->content[y].X = line.X
+    memcpy(I->content[y].X->content, line.X->content, I->line_words * sizeof(uint32_t)); \
+    bit_vector_free(&(line.X))
 
     do_image_line(pim);
 #undef do
     return ERR_NONE;
 }
 
+// ======================================================================
+int image_copy(image_t* dst, const image_t* src)
+{
+    M_REQUIRE_NON_NULL(dst);
+    M_REQUIRE_NON_NULL(src);
+    M_REQUIRE_NON_NULL(dst->slab);
+    M_REQUIRE_NON_NULL(src->slab);
+    M_REQUIRE(dst->width == src->width && dst->height == src->height, ERR_BAD_PARAMETER,
+              "Sizes do not match (%lu x %lu vs %lu x %lu)", dst->width, dst->height, src->width, src->height);
+
+    memcpy(dst->slab, src->slab, IMAGE_PLANES * src->height * src->line_words * sizeof(uint32_t));
+
+    return ERR_NONE;
+}
+
+// ======================================================================
+int image_clear(image_t* pim)
+{
+    M_REQUIRE_NON_NULL(pim);
+    M_REQUIRE_NON_NULL(pim->slab);
+
+    memset(pim->slab, 0, IMAGE_PLANES * pim->height * pim->line_words * sizeof(uint32_t));
+
+    return ERR_NONE;
+}
+
 // ======================================================================
 void image_free(image_t* pim)
 {
     if (pim == NULL) return;
 
-    for (size_t i = 0; i < pim->height; ++i) {
-        image_line_free(pim->content + i);
-    }
-
+    // the lines are only views into the slab
     pim->height = 0;
     free(pim->content);
     pim->content = NULL;
+    free(pim->vectors);
+    pim->vectors = NULL;
+    free(pim->slab);
+    pim->slab = NULL;
 }
@@ -36,17 +36,40 @@ typedef struct image_line_ image_line_t;
 
 #define IMAGE_LINE_WORD_BITS 32
 
+/**
+ * @brief Type to represent (without copying) image lines shifted or extracted
+ *        from other ones
+ */
+typedef struct {
+    bit_vector_view_t msb;
+    bit_vector_view_t lsb;
+    bit_vector_view_t opacity;
+} image_line_view_t;
+
+
+#define IMAGE_ALIGNMENT 64 // bytes (a cache line)
 
 //=========================================================================
 /**
  * @brief Type to represent images
+ *
+ * All the pixels are stored in one contiguous slab (aligned on
+ * IMAGE_ALIGNMENT bytes), plane by plane (msb, lsb then opacity), each plane
+ * line by line: the lines of content are views into it, which shall not
+ * be freed (nor resized) on their own.
  */
 struct image_ {
     size_t height;
     image_line_t* content;
+    size_t width;
+    size_t line_words;     // number of words of a line of a plane
+    uint32_t* slab;        // IMAGE_PLANES planes of height lines of line_words words
+    bit_vector_t* vectors; // headers of the views of content
 };
 typedef struct image_ image_t;
 
+#define IMAGE_PLANES 3
+
 //=========================================================================
 /**
  * @brief Create an image
@@ -88,6 +111,35 @@ int image_line_shift(image_line_t* output, image_line_t iml, int64_t shift);
  */
 int image_line_extract_wrap_ext(image_line_t* output, image_line_t iml, int64_t index, size_t size);
 
+//=========================================================================
+/**
+ * @brief View of a shifted image line (nothing is copied)
+ * @param iml image line to shift
+ * @param shift shift amount
+ * @return the view
+ */
+image_line_view_t image_line_view_shift(image_line_t iml, int64_t shift);
+
+//=========================================================================
+/**
+ * @brief View of an extracted image line (wrapping, nothing is copied)
+ * @param iml image line to extract
+ * @param index index from which to extract
+ * @param size size of the view
+ * @return the view
+ */
+image_line_view_t image_line_view_extract_wrap_ext(image_line_t iml, int64_t index, size_t size);
+
+//=========================================================================
+/**
+ * @brief Apply Palette to a view of an image line (the only copy made)
+ * @param output pointer to write output to
+ * @param view view of the image line to use palette on
+ * @param map palette to use
+ * @return Error code
+ */
+int image_line_map_colors_view(image_line_t* output, image_line_view_t view, palette_t map);
+
 //=========================================================================
 /**
  * @brief Apply Palette to image line
@@ -130,6 +182,13 @@ int image_line_below(image_line_t* output, image_line_t iml1, image_line_t iml2)
  */
 int image_line_join(image_line_t* output, image_line_t iml1, image_line_t iml2, int64_t start);
 
+/**
+ * @brief Sets all the pixels of an image to color 0, transparent
+ * @param pim pointer to image to clear
+ * @return Error code
+ */
+int image_clear(image_t* pim);
+
 //=========================================================================
 /**
  * @brief Free image line
@@ -170,7 +229,8 @@ int image_get_pixel(uint8_t* output, image_t* pim, size_t x, size_t y);
 
 //=========================================================================
 /**
- * @brief Set line content of image (using provided bit vectors pointers)
+ * @brief Set line content of image, taking ownership of the line
+ *        (its bit vectors are freed once copied into the image)
  * @param pim pointer to image
  * @param y line index to set
  * @param line line to use bit vectors from
@@ -178,6 +238,15 @@ int image_get_pixel(uint8_t* output, image_t* pim, size_t x, size_t y);
  */
 int image_own_line_content(image_t* pim, size_t y, image_line_t line);
 
+//=========================================================================
+/**
+ * @brief Copy the whole content of an image into another one of the same size
+ * @param dst pointer to image to write to
+ * @param src pointer to image to copy
+ * @return Error code
+ */
+int image_copy(image_t* dst, const image_t* src);
+
 //=========================================================================
 /**
  * @brief Free image
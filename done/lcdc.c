@@ -0,0 +1,948 @@
+/**
+ * @file lcdc.c
+ * @brief Game Boy LCD (liquid cristal display) controller simulation
+ *
+ * @date 2020
+ */
+#include <inttypes.h> // for PRIu64
+#include <stdlib.h> // for qsort
+#include <string.h> // for memset, memcmp, memcpy
+
+#include "lcdc.h"
+#include "gameboy.h"
+
+// placed here to prevent an include loop
+#include "cpu-storage.h"
+
+#define TILE_HEIGHT 8
+#define SPRITE_X_OFFSET 8
+#define SPRITE_Y_OFFSET 16
+#define NB_SPRITES 40
+#define SPRITE_SIZE 4 // bytes of a sprite in OAM
+#define OAM_SIZE (GRAPH_RAM_END - GRAPH_RAM_START + 1)
+
+// sprite attribute bits
+#define SPRITE_BEHIND_BG_MASK 0x80
+#define SPRITE_FLIP_Y_MASK    0x40
+#define SPRITE_FLIP_X_MASK    0x20
+#define SPRITE_PALETTE_MASK   0x10
+
+/**
+ * @brief Reads a register or the video memory
+ */
+static data_t lcdc_read(const lcdc_t* lcd, addr_t addr)
+{
+    return cpu_peek_at_idx(lcd->cpu, addr); // the DMA is not locked out by itself
+}
+
+/**
+ * @brief Writes a register
+ *        (directly on the bus: this is not a CPU write to listen to)
+ */
+static void lcdc_write(lcdc_t* lcd, addr_t addr, data_t data)
+{
+    bus_write(*(lcd->cpu->bus), addr, data);
+}
+
+/**
+ * @brief Runs a pending DMA at once: copies the source page into OAM
+ *
+ * When both the source and OAM are plain contiguous memory on the bus
+ * (the general case), this is a single memmove; otherwise (unmapped or
+ * split source, or I/O registers, which may be computed when read) the
+ * copy goes byte by byte through the bus.
+ */
+static void dma_copy(lcdc_t* lcd)
+{
+    data_t* const* bus = *(lcd->cpu->bus);
+    data_t* const src = bus[lcd->DMA_from];
+    data_t* const dst = bus[GRAPH_RAM_START];
+
+    bit_t contiguous = src != NULL && dst != NULL
+                       && (size_t) lcd->DMA_from + OAM_SIZE <= BUS_IO_START;
+    for(size_t i = 1; contiguous && i < OAM_SIZE; ++i) {
+        contiguous = bus[lcd->DMA_from + i] == src + i && bus[GRAPH_RAM_START + i] == dst + i;
+    }
+
+    if(contiguous) {
+        memmove(dst, src, OAM_SIZE);
+    } else {
+        for(addr_t i = 0; i < OAM_SIZE; ++i) {
+            lcdc_write(lcd, (addr_t)(GRAPH_RAM_START + i), lcdc_read(lcd, (addr_t)(lcd->DMA_from + i)));
+        }
+    }
+
+    lcd->DMA_to = GRAPH_RAM_END + 1;
+#ifdef SPRITE_CACHE
+    sprite_cache_invalidate(&(lcd->sprites));
+#endif
+}
+
+// ======================================================================
+/**
+ * @brief Sets the mode in STAT, and requests the corresponding interrupt
+ *        if enabled
+ */
+static void set_mode(lcdc_t* lcd, data_t mode)
+{
+    const data_t stat = lcdc_read(lcd, REG_STAT);
+    lcdc_write(lcd, REG_STAT, (data_t)((stat & ~STAT_REG_MODE_MASK) | (mode & STAT_REG_MODE_MASK)));
+
+    // modes 0, 1 and 2 have their interrupt enabling bit in STAT (bits 3 to 5)
+    if(mode <= 2 && bit_get(stat, mode + 3)) {
+        cpu_request_interrupt(lcd->cpu, LCD_STAT);
+    }
+}
+
+/**
+ * @brief Updates the LY=LYC bit of STAT, and requests the corresponding
+ *        interrupt if enabled
+ */
+static void update_LYC(lcdc_t* lcd)
+{
+    const bit_t equal = lcdc_read(lcd, REG_LY) == lcdc_read(lcd, REG_LYC);
+
+    data_t stat = lcdc_read(lcd, REG_STAT);
+    bit_edit(&stat, STAT_REG_LYC_EQ_LY_BIT, equal);
+    lcdc_write(lcd, REG_STAT, stat);
+
+    if(equal && bit_get(stat, STAT_REG_INT_LYC_BIT)) {
+        cpu_request_interrupt(lcd->cpu, LCD_STAT);
+    }
+}
+
+// ======================================================================
+/**
+ * @brief One row of a tile, in the bit order of the image lines
+ *
+ * @param addr address of the row (its first byte)
+ * @param mirror whether to flip the row along X
+ */
+static tile_row_t tile_row(lcdc_t* lcd, addr_t addr, bit_t mirror)
+{
+#ifdef TILE_CACHE
+    return tile_cache_row(&(lcd->tiles), *(lcd->cpu->bus), addr, mirror);
+#else
+    return tile_row_decode(*(lcd->cpu->bus), addr, mirror);
+#endif
+}
+
+/**
+ * @brief Reads the rows of the tiles of line y of the background or
+ *        of the window tile map
+ *
+ * @param area whether to use the high tile map
+ * @param y line in the tile map
+ * @param nb_tiles number of tiles to read (from the left of the map)
+ */
+static void tiles_rows(lcdc_t* lcd, tile_row_t* rows, bit_t area, data_t y, size_t nb_tiles)
+{
+    const addr_t map = area ? TILE_ADDR_BASE_HIGH : TILE_ADDR_BASE_LOW;
+    const bit_t low_source = (lcdc_read(lcd, REG_LCDC) & LCDC_REG_TILE_SOURCE_MASK) != 0;
+    const addr_t source = low_source ? TILE_SRC_ADDR_LOW : TILE_SRC_ADDR_HIGH;
+
+    for(size_t i = 0; i < nb_tiles; ++i) {
+        data_t tile = lcdc_read(lcd, (addr_t)(map + (y / TILE_HEIGHT) * TILE_LINE_SIZE + i));
+        if(!low_source) {
+            tile = (data_t)(tile + 0x80); // signed tile numbers
+        }
+        rows[i] = tile_row(lcd, (addr_t)(source + tile * TILE_SIZE + (y % TILE_HEIGHT) * 2), 0);
+    }
+}
+
+#ifndef SPRITE_CACHE
+/**
+ * @brief Compares two sprites by X coordinate, then by OAM index
+ */
+static int sprite_cmp(const void* s1, const void* s2)
+{
+    return (int) *(const uint16_t*) s1 - (int) *(const uint16_t*) s2;
+}
+#endif
+
+/**
+ * @brief Reads the (at most SPRITES_PER_LINE) sprites on line y,
+ *        by order of priority
+ */
+static void sprites_rows(lcdc_t* lcd, lcdc_line_t* inputs, data_t y)
+{
+    const data_t lcdc = lcdc_read(lcd, REG_LCDC);
+    const int height = (lcdc & LCDC_REG_OBJ_SIZE_MASK) ? 2 * TILE_HEIGHT : TILE_HEIGHT;
+
+#ifdef SPRITE_CACHE
+    const sprite_cache_line_t* selected = sprite_cache_line(&(lcd->sprites), *(lcd->cpu->bus),
+                                                            y, (data_t) height);
+    const size_t n = selected == NULL ? 0 : selected->nb;
+#define SELECTED(k) (selected->index[k])
+#else
+    uint16_t selected[SPRITES_PER_LINE] = { 0 }; // X coordinate, then OAM index
+    size_t n = 0;
+    for(size_t i = 0; i < NB_SPRITES && n < SPRITES_PER_LINE; ++i) {
+        const addr_t oam = (addr_t)(GRAPH_RAM_START + SPRITE_SIZE * i);
+        const data_t sy = (data_t)(lcdc_read(lcd, oam) - SPRITE_Y_OFFSET);
+        if(sy <= y && y < sy + height) {
+            selected[n++] = (uint16_t)(lcdc_read(lcd, (addr_t)(oam + 1)) << 8 | i);
+        }
+    }
+
+    if(n > 1) {
+        qsort(selected, n, sizeof(selected[0]), sprite_cmp);
+    }
+#define SELECTED(k) lsb8(selected[k])
+#endif
+
+    for(size_t k = 0; k < n; ++k) {
+        const addr_t oam = (addr_t)(GRAPH_RAM_START + SPRITE_SIZE * SELECTED(k));
+        const data_t flags = lcdc_read(lcd, (addr_t)(oam + 3));
+        lcdc_sprite_t* sprite = &(inputs->sprites[k]);
+
+        sprite->x = (data_t)(lcdc_read(lcd, (addr_t)(oam + 1)) - SPRITE_X_OFFSET);
+        sprite->palette = lcdc_read(lcd, (flags & SPRITE_PALETTE_MASK) ? REG_OBP1 : REG_OBP0);
+        sprite->behind = (flags & SPRITE_BEHIND_BG_MASK) != 0;
+
+        data_t row = (data_t)(y - (data_t)(lcdc_read(lcd, oam) - SPRITE_Y_OFFSET));
+        if(flags & SPRITE_FLIP_Y_MASK) {
+            row = (data_t)(height - 1 - row);
+        }
+        const data_t tile = lcdc_read(lcd, (addr_t)(oam + 2));
+        sprite->pixels = tile_row(lcd, (addr_t)(TILE_SRC_ADDR_LOW + tile * TILE_SIZE + row * 2),
+                                  (flags & SPRITE_FLIP_X_MASK) != 0);
+    }
+    inputs->nb_sprites = (data_t) n;
+#undef SELECTED
+}
+
+/**
+ * @brief Reads everything line y is drawn from
+ *        (and moves to the next line of the window if it is drawn)
+ */
+static void line_inputs(lcdc_t* lcd, lcdc_line_t* inputs, data_t y)
+{
+    memset(inputs, 0, sizeof(*inputs)); // the unused parts are compared too
+
+    const data_t lcdc = lcdc_read(lcd, REG_LCDC);
+    inputs->lcdc = lcdc;
+    if(!(lcdc & LCDC_REG_BG_MASK)) { // the line is not drawn
+        return;
+    }
+
+    inputs->scx = lcdc_read(lcd, REG_SCX);
+    inputs->bgp = lcdc_read(lcd, REG_BGP);
+    tiles_rows(lcd, inputs->background, (lcdc & LCDC_REG_BG_AREA_MASK) != 0,
+               (data_t)(lcdc_read(lcd, REG_SCY) + y), TILE_LINE_SIZE);
+
+    const data_t wx = lcdc_read(lcd, REG_WX);
+    inputs->window_x = LCD_WIDTH; // no window
+    if(wx >= WINDOW_OFFSET_X && wx - WINDOW_OFFSET_X < LCD_WIDTH
+       && (lcdc & LCDC_REG_WIN_MASK) && y >= lcdc_read(lcd, REG_WY)) {
+        inputs->window_x = (data_t)(wx - WINDOW_OFFSET_X);
+        tiles_rows(lcd, inputs->window, (lcdc & LCDC_REG_WIN_AREA_MASK) != 0,
+                   lcd->window_y, VISIBLE_LINE_SIZE);
+        ++(lcd->window_y);
+    }
+
+    if(lcdc & LCDC_REG_OBJ_MASK) {
+        sprites_rows(lcd, inputs, y);
+    }
+}
+
+// ======================================================================
+/**
+ * @brief Builds a line of tiles
+ *
+ * @param nb_tiles number of tiles (a multiple of 4)
+ */
+static int tiles_line(image_line_t* line, const tile_row_t* rows, size_t nb_tiles)
+{
+    M_EXIT_IF_ERR(image_line_create(line, nb_tiles * TILE_HEIGHT));
+
+    const size_t tiles_per_word = IMAGE_LINE_WORD_BITS / TILE_HEIGHT;
+    for(size_t i = 0; i < nb_tiles / tiles_per_word; ++i) {
+        uint32_t msb = 0;
+        uint32_t lsb = 0;
+        for(size_t k = 0; k < tiles_per_word; ++k) {
+            msb |= (uint32_t) rows[i * tiles_per_word + k].msb << (k * TILE_HEIGHT);
+            lsb |= (uint32_t) rows[i * tiles_per_word + k].lsb << (k * TILE_HEIGHT);
+        }
+        M_EXIT_IF_ERR(image_line_set_word(line, i, msb, lsb));
+    }
+
+    return ERR_NONE;
+}
+
+/**
+ * @brief Draws the sprites of a line
+ *
+ * @param only_above whether to skip the sprites behind the background
+ */
+static int sprites_line(image_line_t* line, const lcdc_line_t* inputs, bit_t only_above)
+{
+    M_EXIT_IF_ERR(image_line_create(line, LCD_WIDTH));
+
+    for(size_t k = 0; k < inputs->nb_sprites; ++k) {
+        const lcdc_sprite_t* s = &(inputs->sprites[k]);
+        if(only_above && s->behind) {
+            continue;
+        }
+
+        image_line_t sprite = { NULL, NULL, NULL };
+        image_line_t tmp = { NULL, NULL, NULL };
+        int err = image_line_create(&sprite, LCD_WIDTH);
+        if(err == ERR_NONE) {
+            err = image_line_set_word(&sprite, 0, s->pixels.msb, s->pixels.lsb);
+        }
+        if(err == ERR_NONE) { // shifted while colored, without any copy in between
+            err = image_line_map_colors_view(&tmp, image_line_view_shift(sprite, s->x), s->palette);
+            image_line_free(&sprite);
+            sprite = tmp;
+        }
+        if(err == ERR_NONE) { // the first sprites have priority
+            err = image_line_below(&tmp, sprite, *line);
+            image_line_free(line);
+            *line = tmp;
+        }
+        image_line_free(&sprite);
+        if(err != ERR_NONE) {
+            image_line_free(line);
+            return err;
+        }
+    }
+
+    return ERR_NONE;
+}
+
+/**
+ * @brief Draws the background of a line (LCD_WIDTH pixels)
+ */
+static int background_line(image_line_t* line, const lcdc_line_t* inputs)
+{
+    image_line_t map = { NULL, NULL, NULL };
+
+    M_EXIT_IF_ERR(tiles_line(&map, inputs->background, TILE_LINE_SIZE));
+
+    // the visible part is only copied once colored
+    const int err = image_line_map_colors_view(line, image_line_view_extract_wrap_ext(map, inputs->scx, LCD_WIDTH),
+                    inputs->bgp);
+    image_line_free(&map);
+
+    return err;
+}
+
+/**
+ * @brief Draws the window over the background line
+ */
+static int window_line(image_line_t* line, const lcdc_line_t* inputs)
+{
+    image_line_t window = { NULL, NULL, NULL };
+    image_line_t colored = { NULL, NULL, NULL };
+
+    M_EXIT_IF_ERR(tiles_line(&window, inputs->window, VISIBLE_LINE_SIZE));
+
+    int err = image_line_map_colors(&colored, window, inputs->bgp);
+    image_line_free(&window);
+    M_EXIT_IF_ERR(err);
+
+    err = image_line_shift(&window, colored, inputs->window_x);
+    image_line_free(&colored);
+    M_EXIT_IF_ERR(err);
+
+    image_line_t background = *line;
+    err = image_line_join(line, window, background, inputs->window_x);
+    image_line_free(&window);
+    if(err != ERR_NONE) {
+        return err;
+    }
+    image_line_free(&background);
+
+    return ERR_NONE;
+}
+
+/**
+ * @brief Draws the sprites of a line, in front of or behind the background line
+ */
+static int sprites_over(image_line_t* line, const lcdc_line_t* inputs)
+{
+    image_line_t all = { NULL, NULL, NULL };
+    image_line_t above = { NULL, NULL, NULL };
+    int err = sprites_line(&all, inputs, 0);
+    if(err == ERR_NONE) {
+        err = sprites_line(&above, inputs, 1);
+    }
+
+    // the background is kept where opaque (or where there is no sprite)...
+    bit_vector_t* mask = NULL;
+    if(err == ERR_NONE) {
+        bit_vector_t* no_sprite = bit_vector_not(bit_vector_cpy(all.opacity));
+        mask = bit_vector_or(bit_vector_cpy(line->opacity), no_sprite);
+        bit_vector_free(&no_sprite);
+        err = mask == NULL ? ERR_MEM : ERR_NONE;
+    }
+
+    image_line_t tmp = { NULL, NULL, NULL };
+    if(err == ERR_NONE) {
+        err = image_line_below_with_opacity(&tmp, all, *line, mask);
+    }
+    if(err == ERR_NONE) {
+        image_line_free(line);
+        *line = tmp;
+        // ...unless the sprite is not behind it
+        err = image_line_below(&tmp, *line, above);
+    }
+    if(err == ERR_NONE) {
+        image_line_free(line);
+        *line = tmp;
+    }
+
+    bit_vector_free(&mask);
+    image_line_free(&all);
+    image_line_free(&above);
+
+    return err;
+}
+
+/**
+ * @brief Draws a line of the screen (the background of which is on)
+ */
+static int render_line(image_line_t* line, const lcdc_line_t* inputs)
+{
+    M_EXIT_IF_ERR(background_line(line, inputs));
+
+    int err = ERR_NONE;
+    if(inputs->window_x < LCD_WIDTH) {
+        err = window_line(line, inputs);
+    }
+
+    if(err == ERR_NONE && (inputs->lcdc & LCDC_REG_OBJ_MASK)) {
+        err = sprites_over(line, inputs);
+    }
+
+    if(err != ERR_NONE) {
+        image_line_free(line);
+    }
+    return err;
+}
+
+/**
+ * @brief Draws line y of the screen from its inputs, unless it was last
+ *        drawn from the same ones (with -DLINE_CACHE)
+ */
+static int draw_line(lcdc_t* lcd, const lcdc_line_t* inputs, data_t y)
+{
+#ifdef LINE_CACHE
+    if(memcmp(inputs, &(lcd->lines[y]), sizeof(*inputs)) == 0) {
+        return ERR_NONE;
+    }
+#endif
+
+    image_line_t line = { NULL, NULL, NULL };
+    M_EXIT_IF_ERR(render_line(&line, inputs));
+    const int err = image_own_line_content(&(lcd->display), y, line);
+    if(err != ERR_NONE) {
+        image_line_free(&line);
+        return err;
+    }
+
+#ifdef LINE_CACHE
+    lcd->lines[y] = *inputs;
+#endif
+    bit_set(&(lcd->dirty_lines[y / 8]), y % 8);
+
+    return ERR_NONE;
+}
+
+#ifdef DEFERRED_RENDER
+// ======================================================================
+/**
+ * @brief Drawing thread: draws its range of lines of each given log
+ */
+static void* worker_main(void* arg)
+{
+    lcdc_worker_t* worker = arg;
+    lcdc_t* lcd = worker->lcd;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&(lcd->lock));
+    for(;;) {
+        while(lcd->job == seen && !lcd->stopping) {
+            pthread_cond_wait(&(lcd->work), &(lcd->lock));
+        }
+        if(lcd->stopping) {
+            break;
+        }
+        seen = lcd->job;
+        const int log = lcd->drawing;
+        pthread_mutex_unlock(&(lcd->lock));
+
+        int err = ERR_NONE;
+        for(size_t y = worker->first; y < worker->end; ++y) {
+            if(lcd->pending[log][y]) {
+                const int e = draw_line(lcd, &(lcd->log[log][y]), (data_t) y);
+                err = err == ERR_NONE ? e : err;
+                lcd->pending[log][y] = 0;
+            }
+        }
+
+        pthread_mutex_lock(&(lcd->lock));
+        if(lcd->error == ERR_NONE) {
+            lcd->error = err;
+        }
+        if(--(lcd->busy) == 0) {
+            pthread_cond_signal(&(lcd->done));
+        }
+    }
+    pthread_mutex_unlock(&(lcd->lock));
+
+    return NULL;
+}
+
+/**
+ * @brief Waits for the workers to finish drawing (the lock being held)
+ */
+static void wait_workers(lcdc_t* lcd)
+{
+    while(lcd->busy > 0) {
+        pthread_cond_wait(&(lcd->done), &(lcd->lock));
+    }
+}
+
+/**
+ * @brief Gives the log being filled to the workers (once they are done with
+ *        the previous one), and fills the other one from now on
+ *
+ * @param wait whether to wait until the log is drawn
+ * @return error code (first drawing error, if any)
+ */
+/**
+ * @brief Starts the drawing threads (the lock being held), each on a range
+ *        of whole bytes of the dirty lines bitmap
+ */
+static int workers_start(lcdc_t* lcd)
+{
+    for(size_t k = 0; k < LCDC_RENDER_THREADS; ++k) {
+        lcdc_worker_t* worker = &(lcd->workers[k]);
+        worker->lcd = lcd;
+        worker->first = 8 * (k * LCDC_LINES_BITMAP_SIZE / LCDC_RENDER_THREADS);
+        worker->end = 8 * ((k + 1) * LCDC_LINES_BITMAP_SIZE / LCDC_RENDER_THREADS);
+        if(pthread_create(&(worker->thread), NULL, worker_main, worker) != 0) {
+            lcd->stopping = 1;
+            pthread_cond_broadcast(&(lcd->work));
+            pthread_mutex_unlock(&(lcd->lock));
+            for(size_t i = 0; i < k; ++i) {
+                pthread_join(lcd->workers[i].thread, NULL);
+            }
+            pthread_mutex_lock(&(lcd->lock));
+            lcd->stopping = 0;
+            return ERR_MEM;
+        }
+    }
+    lcd->started = 1;
+
+    return ERR_NONE;
+}
+
+/**
+ * @brief Gives the log being filled to the workers (once they are done with
+ *        the previous one), and fills the other one from now on
+ *
+ * @param wait whether to wait until the log is drawn
+ * @return error code (first drawing error, if any)
+ */
+static int submit(lcdc_t* lcd, bit_t wait)
+{
+    pthread_mutex_lock(&(lcd->lock));
+    wait_workers(lcd);
+
+    if(memchr(lcd->pending[lcd->filling], 1, LCD_HEIGHT) != NULL) {
+        const int err = lcd->started ? ERR_NONE : workers_start(lcd);
+        if(err != ERR_NONE) { // the lines stay logged
+            pthread_mutex_unlock(&(lcd->lock));
+            return err;
+        }
+        lcd->drawing = lcd->filling;
+        lcd->filling = 1 - lcd->filling;
+        lcd->busy = LCDC_RENDER_THREADS;
+        ++(lcd->job);
+        pthread_cond_broadcast(&(lcd->work));
+        if(wait) {
+            wait_workers(lcd);
+        }
+    }
+
+    const int err = lcd->error;
+    lcd->error = ERR_NONE;
+    pthread_mutex_unlock(&(lcd->lock));
+
+    return err;
+}
+
+/**
+ * @brief Sets up the drawing, without starting the threads (see submit())
+ */
+static void workers_init(lcdc_t* lcd)
+{
+    memset(lcd->pending, 0, sizeof(lcd->pending));
+    lcd->filling = 0;
+    lcd->drawing = 1;
+    lcd->job = 0;
+    lcd->busy = 0;
+    lcd->error = ERR_NONE;
+    lcd->stopping = 0;
+    lcd->started = 0;
+    pthread_mutex_init(&(lcd->lock), NULL);
+    pthread_cond_init(&(lcd->work), NULL);
+    pthread_cond_init(&(lcd->done), NULL);
+}
+#endif
+
+/**
+ * @brief Draws line y of the screen (with -DDEFERRED_RENDER, only logs
+ *        what to draw it from)
+ */
+static int mode_3(lcdc_t* lcd, data_t y)
+{
+#ifdef DEFERRED_RENDER
+    lcdc_line_t* inputs = &(lcd->log[lcd->filling][y]);
+#else
+    lcdc_line_t line;
+    lcdc_line_t* inputs = &line;
+#endif
+
+    line_inputs(lcd, inputs, y);
+    if(!(inputs->lcdc & LCDC_REG_BG_MASK)) { // the line keeps its content
+        return ERR_NONE;
+    }
+
+#ifdef DEFERRED_RENDER
+    lcd->pending[lcd->filling][y] = 1;
+    return ERR_NONE;
+#else
+    return draw_line(lcd, inputs, y);
+#endif
+}
+
+// ======================================================================
+/**
+ * @brief Does what the controller does at a given cycle of the frame
+ */
+static int step(lcdc_t* lcd, uint64_t cycle)
+{
+    const uint64_t frame_cycle = (cycle - lcd->on_cycle) % FRAME_TOTAL_CYCLES;
+    if(frame_cycle == 0) {
+        lcd->window_y = 0;
+    }
+
+    const data_t y = (data_t)(frame_cycle / LINE_TOTAL_CYCLES);
+    const uint64_t x = frame_cycle % LINE_TOTAL_CYCLES;
+
+    if(y >= LCD_HEIGHT) { // vertical blank
+        M_REQUIRE(x == 0, ERR_BAD_PARAMETER, "unexpected cycle %" PRIu64 " of line %u", x, y);
+        if(y == LCD_HEIGHT) {
+#ifdef DEFERRED_RENDER
+            M_EXIT_IF_ERR(submit(lcd, 0)); // drawn while the next frame is emulated
+#endif
+            set_mode(lcd, 1);
+            cpu_request_interrupt(lcd->cpu, VBLANK);
+            ++(lcd->frames);
+        }
+        lcdc_write(lcd, REG_LY, y);
+        update_LYC(lcd);
+        lcd->next_cycle += LINE_TOTAL_CYCLES;
+        return ERR_NONE;
+    }
+
+    switch(x) {
+    case LINE_MODE_2_START_CYCLE:
+        lcdc_write(lcd, REG_LY, y);
+        update_LYC(lcd);
+        set_mode(lcd, 2);
+        lcd->next_cycle += LINE_MODE_2_CYCLES;
+        break;
+
+    case LINE_MODE_3_START_CYCLE:
+        set_mode(lcd, 3);
+        M_EXIT_IF_ERR(mode_3(lcd, y));
+        lcd->next_cycle += LINE_MODE_3_CYCLES;
+        break;
+
+    case LINE_MODE_0_START_CYCLE:
+        set_mode(lcd, 0);
+        lcd->next_cycle += LINE_MODE_0_CYCLES;
+        break;
+
+    default:
+        return ERR_BAD_PARAMETER;
+    }
+
+    return ERR_NONE;
+}
+
+// ======================================================================
+/**
+ * @brief Sets the state of the controller from its registers
+ *        (everything but the display and the drawing threads)
+ */
+static int init_state(lcdc_t* lcd)
+{
+    lcd->on = (lcdc_read(lcd, REG_LCDC) & LCDC_REG_LCD_STATUS_MASK) != 0;
+    lcd->next_cycle = UINT64_MAX;
+    lcd->on_cycle = lcd->on ? 0 : UINT64_MAX;
+    lcd->DMA_from = 0;
+    lcd->DMA_to = GRAPH_RAM_END + 1; // no DMA running
+    lcd->DMA_end = UINT64_MAX;
+    lcd->window_y = 0;
+    lcd->frames = 0;
+#ifdef TILE_CACHE
+    M_EXIT_IF_ERR(tile_cache_init(&(lcd->tiles)));
+#endif
+#ifdef SPRITE_CACHE
+    M_EXIT_IF_ERR(sprite_cache_init(&(lcd->sprites)));
+#endif
+#ifdef LINE_CACHE
+    memset(lcd->lines, 0, sizeof(lcd->lines)); // never drawn (as LCDC is then not 0)
+#endif
+    memset(lcd->dirty_lines, 0, sizeof(lcd->dirty_lines));
+
+    return ERR_NONE;
+}
+
+// See lcdc.h
+int lcdc_init(gameboy_t* gb)
+{
+    M_REQUIRE_NON_NULL(gb);
+
+    lcdc_t* lcd = &(gb->screen);
+    lcd->cpu = &(gb->cpu);
+    M_EXIT_IF_ERR(init_state(lcd));
+
+    M_EXIT_IF_ERR(image_create(&(lcd->display), LCD_WIDTH, LCD_HEIGHT));
+#ifdef DEFERRED_RENDER
+    workers_init(lcd);
+#endif
+
+    return ERR_NONE;
+}
+
+// See lcdc.h
+int lcdc_reset(lcdc_t* lcd)
+{
+    M_REQUIRE_NON_NULL(lcd);
+    M_REQUIRE_NON_NULL(lcd->cpu);
+
+#ifdef DEFERRED_RENDER
+    pthread_mutex_lock(&(lcd->lock));
+    wait_workers(lcd);
+    memset(lcd->pending, 0, sizeof(lcd->pending));
+    lcd->error = ERR_NONE;
+    pthread_mutex_unlock(&(lcd->lock));
+#endif
+    M_EXIT_IF_ERR(init_state(lcd));
+
+    return image_clear(&(lcd->display));
+}
+
+// See lcdc.h
+int lcdc_copy(lcdc_t* dst, const lcdc_t* src)
+{
+    M_REQUIRE_NON_NULL(dst);
+    M_REQUIRE_NON_NULL(src);
+    M_REQUIRE(dst != src, ERR_BAD_PARAMETER, "%s", "copy of a LCD controler into itself");
+
+    dst->on = src->on;
+    dst->next_cycle = src->next_cycle;
+    dst->on_cycle = src->on_cycle;
+    dst->DMA_from = src->DMA_from;
+    dst->DMA_to = src->DMA_to;
+    dst->DMA_end = src->DMA_end;
+    dst->window_y = src->window_y;
+    dst->frames = src->frames;
+#ifdef TILE_CACHE
+    dst->tiles = src->tiles;
+#endif
+#ifdef SPRITE_CACHE
+    dst->sprites = src->sprites;
+#endif
+#ifdef LINE_CACHE
+    memcpy(dst->lines, src->lines, sizeof(dst->lines));
+#endif
+
+#ifdef DEFERRED_RENDER
+    pthread_mutex_lock(&(dst->lock));
+    wait_workers(dst);
+    lcdc_t* const busy = (lcdc_t*) src; // only locked, to wait for its threads
+    pthread_mutex_lock(&(busy->lock));
+    wait_workers(busy);
+    memcpy(dst->log[dst->filling], src->log[src->filling], sizeof(dst->log[0]));
+    memcpy(dst->pending[dst->filling], src->pending[src->filling], sizeof(dst->pending[0]));
+    memset(dst->pending[dst->drawing], 0, sizeof(dst->pending[0]));
+    dst->error = src->error;
+#endif
+    memcpy(dst->dirty_lines, src->dirty_lines, sizeof(dst->dirty_lines));
+    const int err = image_copy(&(dst->display), &(src->display));
+#ifdef DEFERRED_RENDER
+    pthread_mutex_unlock(&(busy->lock));
+    pthread_mutex_unlock(&(dst->lock));
+#endif
+
+    return err;
+}
+
+// See lcdc.h
+void lcdc_free(lcdc_t* lcd)
+{
+    if(lcd != NULL) {
+#ifdef DEFERRED_RENDER
+        if(lcd->display.slab == NULL) { // not initialised: no threads
+            return;
+        }
+        pthread_mutex_lock(&(lcd->lock));
+        wait_workers(lcd);
+        lcd->stopping = 1;
+        pthread_cond_broadcast(&(lcd->work));
+        pthread_mutex_unlock(&(lcd->lock));
+        for(size_t k = 0; lcd->started && k < LCDC_RENDER_THREADS; ++k) {
+            pthread_join(lcd->workers[k].thread, NULL);
+        }
+        pthread_mutex_destroy(&(lcd->lock));
+        pthread_cond_destroy(&(lcd->work));
+        pthread_cond_destroy(&(lcd->done));
+#endif
+        image_free(&(lcd->display));
+    }
+}
+
+// See lcdc.h
+int lcdc_plug(lcdc_t* lcd, bus_t bus)
+{
+    M_REQUIRE_NON_NULL(lcd);
+    (void) bus; // the registers are plain memory, watched by lcdc_bus_listener()
+
+    return ERR_NONE;
+}
+
+// See lcdc.h
+void lcdc_dma_unlock(lcdc_t* lcd, uint64_t cycle)
+{
+    if(lcd != NULL && cycle >= lcd->DMA_end) {
+        lcd->cpu->dma_lockout = 0;
+        lcd->DMA_end = UINT64_MAX;
+    }
+}
+
+// See lcdc.h
+int lcdc_cycle(lcdc_t* lcd, uint64_t cycle)
+{
+    M_REQUIRE_NON_NULL(lcd);
+    M_REQUIRE(cycle <= lcd->next_cycle, ERR_BAD_PARAMETER,
+              "cycle %" PRIu64 " after the next step", cycle);
+
+    lcdc_dma_unlock(lcd, cycle + 1); // the CPU has run this cycle already
+    if(lcd->DMA_to <= GRAPH_RAM_END) {
+        dma_copy(lcd);
+    }
+
+    if(cycle == lcd->next_cycle) {
+        return step(lcd, cycle);
+    }
+
+    if(lcd->next_cycle == UINT64_MAX && (lcdc_read(lcd, REG_LCDC) & LCDC_REG_LCD_STATUS_MASK)) {
+        lcd->next_cycle = cycle; // switched on
+        lcd->on_cycle = cycle;
+        return step(lcd, cycle);
+    }
+
+    return ERR_NONE;
+}
+
+// See lcdc.h
+int lcdc_run_until(lcdc_t* lcd, uint64_t from, uint64_t to)
+{
+    M_REQUIRE_NON_NULL(lcd);
+    M_REQUIRE(from <= to && from <= lcd->next_cycle, ERR_BAD_PARAMETER,
+              "cycles %" PRIu64 " to %" PRIu64 " not before the next step", from, to);
+
+    if(lcd->DMA_to <= GRAPH_RAM_END) {
+        dma_copy(lcd);
+    }
+
+    if(lcd->next_cycle == UINT64_MAX && (lcdc_read(lcd, REG_LCDC) & LCDC_REG_LCD_STATUS_MASK)) {
+        lcd->next_cycle = from; // switched on
+        lcd->on_cycle = from;
+    }
+
+    while(lcd->next_cycle < to) {
+        M_EXIT_IF_ERR(step(lcd, lcd->next_cycle));
+    }
+    lcdc_dma_unlock(lcd, to);
+
+    return ERR_NONE;
+}
+
+// See lcdc.h
+int lcdc_flush(lcdc_t* lcd)
+{
+    M_REQUIRE_NON_NULL(lcd);
+
+#ifdef DEFERRED_RENDER
+    return submit(lcd, 1);
+#else
+    return ERR_NONE;
+#endif
+}
+
+// See lcdc.h
+int lcdc_take_dirty_lines(lcdc_t* lcd, uint8_t lines[LCDC_LINES_BITMAP_SIZE])
+{
+    M_REQUIRE_NON_NULL(lcd);
+    M_REQUIRE_NON_NULL(lines);
+    M_EXIT_IF_ERR(lcdc_flush(lcd));
+
+    memcpy(lines, lcd->dirty_lines, sizeof(lcd->dirty_lines));
+    memset(lcd->dirty_lines, 0, sizeof(lcd->dirty_lines));
+
+    return ERR_NONE;
+}
+
+// See lcdc.h
+int lcdc_bus_listener(lcdc_t* lcd, addr_t addr, uint64_t cycle)
+{
+    M_REQUIRE_NON_NULL(lcd);
+
+    switch(addr) {
+    case REG_LCDC: {
+        const bit_t on = (lcdc_read(lcd, REG_LCDC) & LCDC_REG_LCD_STATUS_MASK) != 0;
+        if(lcd->on && !on) { // switched off
+            set_mode(lcd, 0);
+            lcdc_write(lcd, REG_LY, 0);
+            update_LYC(lcd);
+            lcd->next_cycle = UINT64_MAX;
+        }
+        lcd->on = on;
+    }
+    break;
+
+    case REG_LYC:
+        update_LYC(lcd);
+        break;
+
+    case REG_DMA:
+        lcd->DMA_from = (addr_t)(lcdc_read(lcd, REG_DMA) << 8);
+        lcd->DMA_to = GRAPH_RAM_START;
+        lcd->DMA_end = cycle + DMA_CYCLES;
+        lcd->cpu->dma_lockout = 1;
+        break;
+
+    default:
+#ifdef TILE_CACHE
+        // a 16 bit write is only reported by its first address
+        tile_cache_invalidate_addr(&(lcd->tiles), addr);
+        tile_cache_invalidate_addr(&(lcd->tiles), (addr_t)(addr + 1));
+#endif
+#ifdef SPRITE_CACHE
+        sprite_cache_invalidate_addr(&(lcd->sprites), addr);
+        sprite_cache_invalidate_addr(&(lcd->sprites), (addr_t)(addr + 1));
+#endif
+        break;
+    }
+
+    return ERR_NONE;
+}
@@ -13,6 +13,12 @@
 #include "memory.h"
 #include "bit.h"
 #include "image.h"
+#include "tile_cache.h"
+#include "sprite_cache.h"
+
+#ifdef DEFERRED_RENDER
+#include <pthread.h>
+#endif
 
 typedef struct gameboy_ gameboy_t;
 
@@ -55,6 +61,9 @@ extern "C" {
 // This should be 17556
 #define FRAME_TOTAL_CYCLES ((LCD_HEIGHT + VBLANK_LINES) * LINE_TOTAL_CYCLES)
 
+// duration of an OAM DMA transfer (one byte per cycle)
+#define DMA_CYCLES 160
+
 
 // LCDC register bits
 
@@ -94,20 +103,114 @@ extern "C" {
 
 #define WINDOW_OFFSET_X  7
 
+
+// Sprites
+
+#define SPRITES_PER_LINE 10
+
+
+// size (in bytes) of a bitmap of the lines of the screen
+
+#define LCDC_LINES_BITMAP_SIZE (LCD_HEIGHT / 8)
+
+// number of threads drawing the frames with -DDEFERRED_RENDER
+// (each one draws a range of lines; at most LCDC_LINES_BITMAP_SIZE)
+#ifndef LCDC_RENDER_THREADS
+#define LCDC_RENDER_THREADS 2
+#endif
+
 // ======================================================================
 /**
- * @brief lcdc type
+ * @brief a sprite, as drawn on a line
+ */
+typedef struct {
+    data_t x;          // leftmost column (modulo 256)
+    palette_t palette;
+    bit_t behind;      // whether behind the (non 0 colors of the) background
+    tile_row_t pixels; // flipped if required
+} lcdc_sprite_t;
+
+/**
+ * @brief everything a line of the screen is drawn from
+ *        (all bytes significant, so that two of them can be compared with memcmp)
+ */
+typedef struct {
+    data_t lcdc;        // the line is drawn only if the background is on
+    data_t scx;
+    palette_t bgp;
+    data_t window_x;    // leftmost column of the window, LCD_WIDTH if none
+    data_t nb_sprites;
+    tile_row_t background[TILE_LINE_SIZE];
+    tile_row_t window[VISIBLE_LINE_SIZE];
+    lcdc_sprite_t sprites[SPRITES_PER_LINE]; // by order of priority
+} lcdc_line_t;
+
+typedef struct lcdc_ lcdc_t;
+
+#ifdef DEFERRED_RENDER
+/**
+ * @brief a thread drawing the lines from first to end (excluded)
  */
 typedef struct {
+    lcdc_t* lcd;
+    size_t first;
+    size_t end;
+    pthread_t thread;
+} lcdc_worker_t;
+#endif
+
+/**
+ * @brief lcdc type
+ *
+ * With -DDEFERRED_RENDER, the inputs of each line are logged at its mode 3,
+ * and the logged lines are drawn into display by LCDC_RENDER_THREADS threads
+ * from the vertical blank on, while the next frame is emulated: display
+ * shall only be read after lcdc_flush(). The threads are started with the
+ * first log given to them, so that a controler never run (e.g. of a clone
+ * kept as a saved state) has none.
+ *
+ * A write to DMA copies the whole source page into OAM at the next cycle,
+ * instead of over DMA_CYCLES cycles; the CPU is locked out of the bus for
+ * those cycles all the same: it only reaches 0xFF00-0xFFFF (the registers
+ * and the high RAM) until DMA_end (see cpu_t.dma_lockout).
+ */
+struct lcdc_ {
     cpu_t* cpu;
     bit_t on;
     uint64_t next_cycle;
     uint64_t on_cycle;
     addr_t   DMA_from;
-    addr_t   DMA_to;
+    addr_t   DMA_to;   // GRAPH_RAM_START while a DMA is pending
+    uint64_t DMA_end;  // first cycle the CPU has its whole bus again (UINT64_MAX: has it)
     image_t  display;
     data_t   window_y;
-} lcdc_t;
+    uint64_t frames;   // vertical blanks since lcdc_init() (or lcdc_reset())
+#ifdef TILE_CACHE
+    tile_cache_t tiles;
+#endif
+#ifdef SPRITE_CACHE
+    sprite_cache_t sprites;
+#endif
+#ifdef LINE_CACHE
+    lcdc_line_t lines[LCD_HEIGHT]; // what each line of display was drawn from
+#endif
+    uint8_t dirty_lines[LCDC_LINES_BITMAP_SIZE]; // lines drawn since lcdc_take_dirty_lines()
+#ifdef DEFERRED_RENDER
+    lcdc_line_t log[2][LCD_HEIGHT]; // inputs of the lines, of the frame being emulated and being drawn
+    uint8_t pending[2][LCD_HEIGHT]; // whether each logged line is still to be drawn
+    int filling;                    // log of the frame being emulated
+    int drawing;                    // log given to the threads
+    uint64_t job;                   // number of logs given to the threads
+    int busy;                       // number of threads still drawing
+    int error;                      // first drawing error (ERR_NONE if none)
+    int stopping;
+    bit_t started;                  // whether the threads are started
+    lcdc_worker_t workers[LCDC_RENDER_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t work;            // a log is given, or the threads are stopping
+    pthread_cond_t done;            // a thread is done with its log
+#endif
+};
 
 
 /**
@@ -119,6 +222,30 @@ typedef struct {
 int lcdc_init(gameboy_t* gb);
 
 
+/**
+ * @brief Puts back a LCD controler in the state lcdc_init() leaves it in
+ *        (from the current registers, with a blank display), keeping its
+ *        display and its drawing threads
+ *
+ * @param lcd LCD controler to reset
+ * @return error code
+ */
+int lcdc_reset(lcdc_t* lcd);
+
+
+/**
+ * @brief Copies the state of a LCD controler (display and caches included)
+ *        into another initialized one, which keeps its CPU and its drawing
+ *        threads; with -DDEFERRED_RENDER, the lines logged but not yet drawn
+ *        by src are drawn by dst
+ *
+ * @param dst LCD controler to write to
+ * @param src LCD controler to copy
+ * @return error code
+ */
+int lcdc_copy(lcdc_t* dst, const lcdc_t* src);
+
+
 /**
  * @brief Frees a LCD controler
  * @param lcd LCD controler to free
@@ -145,14 +272,57 @@ int lcdc_plug(lcdc_t* lcd, bus_t bus);
 int lcdc_cycle(lcdc_t* lcd, uint64_t cycle);
 
 
+/**
+ * @brief Run the LCD controler cycles from one cycle to another at once
+ *        (only its steps in between; a DMA in progress is finished)
+ *
+ * @param lcd LCD controler to cycle
+ * @param from the first cycle number
+ * @param to the cycle number after the last one
+ * @return error code
+ */
+int lcdc_run_until(lcdc_t* lcd, uint64_t from, uint64_t to);
+
+
+/**
+ * @brief Draws the logged lines and waits for them to be drawn, so that
+ *        display can be read (does nothing without -DDEFERRED_RENDER)
+ *
+ * @param lcd LCD controler
+ * @return error code (first drawing error since the last call, if any)
+ */
+int lcdc_flush(lcdc_t* lcd);
+
+
+/**
+ * @brief Gives the lines of the display drawn since the last call
+ *        (with -DLINE_CACHE, only those drawn differently), and forgets them
+ *
+ * @param lcd LCD controler
+ * @param lines (modified) bitmap of the lines: line y is bit y % 8 of lines[y / 8]
+ * @return error code
+ */
+int lcdc_take_dirty_lines(lcdc_t* lcd, uint8_t lines[LCDC_LINES_BITMAP_SIZE]);
+
+
+/**
+ * @brief Ends the CPU bus lockout of the last DMA if it is over (done by
+ *        lcdc_cycle(); to be done before each instruction otherwise)
+ *
+ * @param lcd LCD controler
+ * @param cycle cycle the CPU is about to run
+ */
+void lcdc_dma_unlock(lcdc_t* lcd, uint64_t cycle);
+
 /**
  * @brief LCD controler bus listening handler
  *
  * @param lcd LCD controler
  * @param address trigger address
+ * @param cycle cycle following the write (the first one a DMA locks the CPU out for)
  * @return error code
  */
-int lcdc_bus_listener(lcdc_t* lcd, addr_t addr);
+int lcdc_bus_listener(lcdc_t* lcd, addr_t addr, uint64_t cycle);
 
 #ifdef __cplusplus
 }
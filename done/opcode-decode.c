@@ -0,0 +1,28 @@
+/**
+ * @file opcode-decode.c
+ * @brief Decoded instruction table, generated by the preprocessor from the
+ *        same instruction lists as instruction_direct and instruction_prefixed
+ *
+ * @date 2020
+ */
+#include "opcode-decode.h"
+#include "opcode-list.h"
+
+// the operand extractions of opcode.h, as constant expressions
+#define DECODE_REG(op, index) (((op) >> (index)) & OPCODE_REG_MASK)
+
+#define DECODE(Family, Code, Bytes, Cycles, Xtra) \
+    { .family = Family, .bytes = Bytes, .cycles = Cycles, .xtra_cycles = Xtra, \
+      .r_dst = DECODE_REG(Code, 3), .r_src = DECODE_REG(Code, 0), \
+      .pair = DECODE_REG(Code, OPCODE_REG_PAIR_IDX) & OPCODE_REG_PAIR_MASK, \
+      .cc = ((Code) >> OPCODE_CC_IDX) & OPCODE_CC_MASK }
+
+// every OP_ macro now expands to its decoded entry
+#undef INSTR_DFX
+#define INSTR_DFX(Kind, Family, Code, Bytes, Cycles, Xtra) \
+    DECODE(Family, Code, Bytes, Cycles, Xtra)
+
+const decoded_instr_t instruction_decoded[DECODED_TABLE_SIZE] = {
+    INSTRUCTIONS_DIRECT,
+    INSTRUCTIONS_PREFIXED
+};
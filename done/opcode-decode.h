@@ -0,0 +1,60 @@
+#pragma once
+
+/**
+ * @file opcode-decode.h
+ * @brief Decoded instruction table: everything the CPU dispatch needs about
+ *        an instruction, precomputed at compile time, 8 bytes per instruction
+ *
+ * @date 2020
+ */
+
+#include <stdint.h>
+
+#include "opcode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//=========================================================================
+/**
+ * @brief Decoded instruction: family (i.e. handler), sizes, timings and
+ *        operands already extracted from the opcode
+ */
+typedef struct {
+    uint8_t family;      // opcode_family
+    uint8_t bytes;       // 1 (or 2 if prefixed) + size of the immediate
+    uint8_t cycles;
+    uint8_t xtra_cycles;
+    uint8_t r_dst;       // extract_reg(opcode, 3), also extract_n3(opcode)
+    uint8_t r_src;       // extract_reg(opcode, 0)
+    uint8_t pair;        // extract_reg_pair(opcode)
+    uint8_t cc;          // extract_cc(opcode)
+} decoded_instr_t;
+
+/**
+ * @brief Number of entries of the decoded table: direct then prefixed instructions
+ */
+#define DECODED_TABLE_SIZE 512
+
+/**
+ * @brief Index in the decoded table of the instruction of given kind and opcode
+ */
+#define decoded_index(kind, opcode) \
+    ((((kind) == PREFIXED) << 8) | (opcode))
+
+/**
+ * @brief Decoded table entry of an instruction_t
+ */
+#define decoded_of(lu) \
+    (&instruction_decoded[decoded_index((lu)->kind, (lu)->opcode)])
+
+/**
+ * @brief The decoded table, indexed by decoded_index()
+ *        (same order as instruction_direct followed by instruction_prefixed)
+ */
+extern const decoded_instr_t instruction_decoded[DECODED_TABLE_SIZE];
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,84 @@
+/**
+ * @file predecode.c
+ * @brief Predecoded instruction cache for GameBoy Emulator
+ *
+ * @date 2020
+ */
+#include <string.h> // for memset
+
+#include "predecode.h"
+
+// See predecode.h
+int predecode_init(predecode_t* cache)
+{
+    M_REQUIRE_NON_NULL(cache);
+
+    predecode_invalidate(cache);
+
+    return ERR_NONE;
+}
+
+// See predecode.h
+void predecode_invalidate(predecode_t* cache)
+{
+    if(cache != NULL) {
+        memset(cache->entries, 0, sizeof(cache->entries));
+    }
+}
+
+// See predecode.h
+void predecode_invalidate_addr(predecode_t* cache, addr_t addr)
+{
+    if(cache == NULL || addr > PREDECODE_END) {
+        return;
+    }
+
+    // the written byte may be the opcode or one of the (up to 2) bytes after it
+    for(int back = 0; back <= 2 && back <= addr; ++back) {
+        predecode_entry_t* e = &cache->entries[(addr - back) & PREDECODE_MASK];
+        if(e->pc == addr - back) {
+            e->instr = NULL;
+        }
+    }
+}
+
+// See predecode.h
+const predecode_entry_t* predecode_fetch(predecode_t* cache, const bus_t bus, addr_t pc)
+{
+    if(cache == NULL || bus == NULL || pc > PREDECODE_END) {
+        return NULL;
+    }
+
+    predecode_entry_t* e = &cache->entries[pc & PREDECODE_MASK];
+    const data_t* src = bus[pc];
+
+    if(e->instr != NULL && e->pc == pc && e->src == src) { // hit
+        return e;
+    }
+
+    if(src == NULL) { // nothing mapped there
+        return NULL;
+    }
+
+    // miss: decode from the bus
+    const instruction_t* instr = NULL;
+    data_t data = 0;
+    if(*src == PREFIXED) {
+        bus_read(bus, (addr_t)(pc + 1), &data);
+        instr = &instruction_prefixed[data];
+    } else {
+        instr = &instruction_direct[*src];
+    }
+
+    if(pc + instr->bytes - 1 > PREDECODE_END) { // operands outside of ROM
+        return NULL;
+    }
+
+    e->src = src;
+    e->instr = instr;
+    e->pc = pc;
+    bus_read(bus, (addr_t)(pc + 1), &(e->imm8));
+    bus_read16(bus, (addr_t)(pc + 1), &(e->imm16));
+
+    return e;
+}
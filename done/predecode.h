@@ -0,0 +1,103 @@
+#pragma once
+
+/**
+ * @file predecode.h
+ * @brief Predecoded instruction cache for GameBoy Emulator
+ *        (used by the CPU fetch with -DPREDECODE)
+ *
+ * Direct-mapped cache of the instructions executed from ROM (boot ROM and
+ * cartridge), indexed by the low bits of PC. An entry keeps the resolved
+ * instruction and its immediate operands, so that a hit needs no bus read.
+ *
+ * An entry is only valid for the memory it was decoded from: it records the
+ * bus pointer of its opcode, so an entry decoded from a ROM bank no longer
+ * matches once another bank is mapped at that address (the boot ROM being
+ * unmapped is the only bank switch of this emulator, which has no MBC).
+ * Writes into the ROM area must be reported with predecode_invalidate_addr().
+ * Instructions executed from RAM are never cached.
+ *
+ * @date 2020
+ */
+
+#include <stdint.h>
+
+#include "bus.h"
+#include "error.h"
+#include "memory.h"
+#include "opcode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief last address of the cached area (the ROM banks)
+ */
+#define PREDECODE_END  0x7FFF
+
+/**
+ * @brief number of entries of the cache (a power of 2)
+ */
+#define PREDECODE_SIZE 0x1000
+#define PREDECODE_MASK (PREDECODE_SIZE - 1)
+
+//=========================================================================
+/**
+ * @brief one predecoded instruction
+ */
+typedef struct {
+    const data_t* src;          // bus pointer of the opcode when decoded (identifies the bank)
+    const instruction_t* instr; // NULL if the entry is empty
+    addr_t pc;                  // address of the opcode
+    addr_t imm16;               // 16 bit immediate, as read by cpu_read_addr_after_opcode()
+    data_t imm8;                // 8 bit immediate, as read by cpu_read_data_after_opcode()
+} predecode_entry_t;
+
+/**
+ * @brief the cache itself
+ */
+typedef struct {
+    predecode_entry_t entries[PREDECODE_SIZE];
+} predecode_t;
+
+//=========================================================================
+/**
+ * @brief Initializes an empty cache
+ *
+ * @param cache cache to initialize
+ * @return error code
+ */
+int predecode_init(predecode_t* cache);
+
+/**
+ * @brief Empties the whole cache (e.g. on bank switch)
+ *
+ * @param cache cache to empty (nothing is done if NULL)
+ */
+void predecode_invalidate(predecode_t* cache);
+
+/**
+ * @brief Drops the entries that may contain a written address,
+ *        i.e. the instructions starting at most 2 bytes before it
+ *
+ * @param cache cache to update (nothing is done if NULL)
+ * @param addr written address
+ */
+void predecode_invalidate_addr(predecode_t* cache, addr_t addr);
+
+/**
+ * @brief Gives the predecoded instruction at a given address,
+ *        decoding it from the bus on a miss
+ *
+ * @param cache cache to look into
+ * @param bus bus to decode from on a miss
+ * @param pc address of the instruction
+ * @return the cache entry, or NULL if the instruction cannot be cached
+ *         (not entirely in ROM, or cache or bus NULL): it must then be
+ *         fetched from the bus
+ */
+const predecode_entry_t* predecode_fetch(predecode_t* cache, const bus_t bus, addr_t pc);
+
+#ifdef __cplusplus
+}
+#endif
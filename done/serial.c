@@ -0,0 +1,124 @@
+/**
+ * @file serial.c
+ * @brief Game Boy serial port simulation
+ *
+ * @date 2020
+ */
+#include "serial.h"
+
+// placed here to prevent an include loop
+#include "cpu-storage.h"
+
+/**
+ * @brief Writes a register (not seen by the bus listeners, as from the hardware)
+ */
+static void serial_write(serial_t* serial, addr_t addr, data_t data)
+{
+    bus_write(*(serial->cpu->bus), addr, data);
+}
+
+// See serial.h
+int serial_init(serial_t* serial, cpu_t* cpu)
+{
+    M_REQUIRE_NON_NULL(serial);
+    M_REQUIRE_NON_NULL(cpu);
+
+    serial->cpu = cpu;
+    serial->sink = NULL;
+    serial->opaque = NULL;
+
+    return serial_reset(serial);
+}
+
+// See serial.h
+int serial_reset(serial_t* serial)
+{
+    M_REQUIRE_NON_NULL(serial);
+
+    serial->end = UINT64_MAX;
+    serial_output_clear(serial);
+
+    return ERR_NONE;
+}
+
+// See serial.h
+int serial_set_sink(serial_t* serial, serial_sink_t sink, void* opaque)
+{
+    M_REQUIRE_NON_NULL(serial);
+
+    serial->sink = sink;
+    serial->opaque = sink == NULL ? NULL : opaque;
+
+    return ERR_NONE;
+}
+
+// See serial.h
+int serial_cycle(serial_t* serial, uint64_t cycle)
+{
+    M_REQUIRE_NON_NULL(serial);
+
+    if(cycle < serial->end) {
+        return ERR_NONE;
+    }
+
+    // nothing linked: only ones came in
+    serial->end = UINT64_MAX;
+    serial_write(serial, REG_SB, 0xFF);
+    data_t sc = cpu_read_at_idx(serial->cpu, REG_SC);
+    bit_unset(&sc, SC_START_BIT);
+    serial_write(serial, REG_SC, sc);
+    cpu_request_interrupt(serial->cpu, SERIAL);
+
+    return ERR_NONE;
+}
+
+// See serial.h
+int serial_bus_listener(serial_t* serial, addr_t addr, uint64_t cycle)
+{
+    M_REQUIRE_NON_NULL(serial);
+
+    if(addr != REG_SC) {
+        return ERR_NONE;
+    }
+
+    const data_t sc = cpu_read_at_idx(serial->cpu, REG_SC);
+    if(!bit_get(sc, SC_START_BIT) || !bit_get(sc, SC_CLOCK_BIT)) { // stopped, or waiting for the other side
+        serial->end = UINT64_MAX;
+        return ERR_NONE;
+    }
+
+    const data_t byte = cpu_read_at_idx(serial->cpu, REG_SB);
+    if(serial->length < SERIAL_OUTPUT_SIZE) {
+        serial->output[serial->length] = (char) byte;
+        ++(serial->length);
+        serial->output[serial->length] = '\0';
+    }
+    if(serial->sink != NULL) {
+        serial->sink(serial->opaque, byte);
+    }
+    serial->end = cycle + SERIAL_TRANSFER_CYCLES;
+
+    return ERR_NONE;
+}
+
+// See serial.h
+const char* serial_output(const serial_t* serial, size_t* length)
+{
+    if(serial == NULL) {
+        return NULL;
+    }
+
+    if(length != NULL) {
+        *length = serial->length;
+    }
+    return serial->output;
+}
+
+// See serial.h
+void serial_output_clear(serial_t* serial)
+{
+    if(serial != NULL) {
+        serial->length = 0;
+        serial->output[0] = '\0';
+    }
+}
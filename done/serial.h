@@ -0,0 +1,129 @@
+#pragma once
+
+/**
+ * @file serial.h
+ * @brief Game Boy serial port simulation header
+ *
+ * Nothing is linked to the port: a transfer started with the internal clock
+ * shifts the byte of SB out (captured in memory, see serial_output(), and
+ * given to the sink, if any, see serial_set_sink()), shifts 0xFF in, and
+ * ends SERIAL_TRANSFER_CYCLES cycles later with the serial interrupt; a
+ * transfer started with the external clock never ends.
+ *
+ * This is how test ROMs (e.g. blargg's) report their results.
+ *
+ * @date 2020
+ */
+#include <stddef.h> // for size_t
+#include <stdint.h>
+
+#include "bit.h"
+#include "cpu.h"
+#include "error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SERIAL BUS REG ADDR
+
+#define REG_SB 0xFF01
+#define REG_SC 0xFF02
+
+// SC register bits
+
+#define SC_CLOCK_BIT 0 // internal clock
+#define SC_START_BIT 7 // transfer running
+
+// 8 bits at 8192 Hz (GB_CYCLES_PER_S / 8192 = 128 cycles per bit)
+#define SERIAL_TRANSFER_CYCLES 1024
+
+// bytes captured at most (the next ones are only given to the sink)
+#define SERIAL_OUTPUT_SIZE 4096
+
+/**
+ * @brief Function given each byte sent
+ *
+ * @param opaque as given to serial_set_sink()
+ * @param byte byte sent
+ */
+typedef void (*serial_sink_t)(void* opaque, data_t byte);
+
+/**
+ * @brief serial port type
+ */
+typedef struct {
+    cpu_t* cpu;
+    uint64_t end;                     // cycle at which the transfer ends (UINT64_MAX if none)
+    serial_sink_t sink;               // NULL if none
+    void* opaque;
+    size_t length;                    // number of bytes captured
+    char output[SERIAL_OUTPUT_SIZE + 1]; // bytes captured, null terminated
+} serial_t;
+
+/**
+ * @brief Initiates a serial port, without sink
+ *
+ * @param serial serial port to initiate
+ * @param cpu cpu to use for the serial port
+ * @return error code
+ */
+int serial_init(serial_t* serial, cpu_t* cpu);
+
+/**
+ * @brief Puts back a serial port in the state serial_init() leaves it in
+ *        (nothing captured), keeping its cpu and its sink
+ *
+ * @param serial serial port to reset
+ * @return error code
+ */
+int serial_reset(serial_t* serial);
+
+/**
+ * @brief Sets (or removes, given NULL) the function given each byte sent
+ *
+ * @param serial serial port
+ * @param sink function to call
+ * @param opaque first parameter of sink
+ * @return error code
+ */
+int serial_set_sink(serial_t* serial, serial_sink_t sink, void* opaque);
+
+/**
+ * @brief Ends the transfer, if it is over at a given cycle
+ *
+ * @param serial serial port
+ * @param cycle current cycle
+ * @return error code
+ */
+int serial_cycle(serial_t* serial, uint64_t cycle);
+
+/**
+ * @brief Starts (or stops) a transfer after a write to SC
+ *
+ * @param serial serial port
+ * @param addr address written to
+ * @param cycle cycle of the write
+ * @return error code
+ */
+int serial_bus_listener(serial_t* serial, addr_t addr, uint64_t cycle);
+
+/**
+ * @brief Bytes captured since the last serial_output_clear()
+ *
+ * @param serial serial port
+ * @param length where to write their number (may be NULL)
+ * @return the bytes, null terminated (NULL if serial is NULL)
+ */
+const char* serial_output(const serial_t* serial, size_t* length);
+
+/**
+ * @brief Forgets the bytes captured
+ *
+ * @param serial serial port
+ */
+void serial_output_clear(serial_t* serial);
+
+#ifdef __cplusplus
+}
+#endif
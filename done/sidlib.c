@@ -14,22 +14,13 @@ static int update_(gpointer data)
 {
     simple_image_displayer_t* const psd = data;
 
-    GdkPixbuf* pb = gtk_image_get_pixbuf(GTK_IMAGE(psd->image));
-    // gdk_pixbuf_fill(pb, 0); // clear to black
-
-    guchar* pixels = gdk_pixbuf_get_pixels(pb);
-    psd->gen(pixels, psd->height, psd->width);
-    gtk_image_set_from_pixbuf(GTK_IMAGE(psd->image),
-                              gdk_pixbuf_new_from_data(
-                              pixels,
-                              GDK_COLORSPACE_RGB,      // colorspace
-                              0,                       // has_alpha (no alpha)
-                              8,                       // bits-per-sample (must be 8)
-                              psd->width, psd->height, // cols, rows
-                              3*psd->width,            // rowstride
-                              NULL, NULL               // nothing to free yet
-                              )
-                             );
+    // draw into the buffer not displayed...
+    GdkPixbuf* back = psd->frames[1 - psd->front];
+    psd->gen(gdk_pixbuf_get_pixels(back), psd->height, psd->width);
+
+    // ...then display it: no new pixbuf, the image only swaps and redraws
+    gtk_image_set_from_pixbuf(GTK_IMAGE(psd->image), back);
+    psd->front = 1 - psd->front;
 
     return 1; // continue timer
 }
@@ -50,20 +41,34 @@ simple_image_displayer_t* sd_init(const char* title, int width, int height, guin
         output->timeout_id = 0;
         output->title = title;
         output->image = NULL;
+        output->frames[0] = output->frames[1] = NULL;
+        output->front = 0;
     }
     return output;
 }
 
 // ======================================================================
-static GBytes* bw_to_rgb(const guchar* bw, guint size)
+static void free_pixels_(guchar* pixels, gpointer data __attribute__((unused)))
 {
-    GByteArray* rgb = g_byte_array_sized_new(3 * size);
-    if (rgb != NULL) {
-        for (size_t i = 0; i < size; i++)
-            for (size_t j = 0; j < 3; j++)
-                g_byte_array_append(rgb, bw + i, 1);
-    }
-    return g_byte_array_free_to_bytes(rgb);
+    free(pixels);
+}
+
+// ======================================================================
+/**
+ * @brief creates an all black RGB pixbuf, of rowstride 3*width as expected by the generator
+ */
+static GdkPixbuf* new_frame_(int width, int height)
+{
+    guchar* pixels = calloc((size_t) (3 * width), (size_t) height);
+    if (pixels == NULL) return NULL;
+    return gdk_pixbuf_new_from_data(pixels,
+                                    GDK_COLORSPACE_RGB, // colorspace
+                                    0,                  // has_alpha (no alpha)
+                                    8,                  // bits-per-sample (must be 8)
+                                    width, height,      // cols, rows
+                                    3*width,            // rowstride
+                                    free_pixels_, NULL  // frees the pixels with the pixbuf
+                                   );
 }
 
 // ======================================================================
@@ -115,8 +120,16 @@ static gboolean keyrelease_handler_(GtkWidget* widget __attribute__((unused)),
 void sd_launch(int* p_argc, char*** p_argv, simple_image_displayer_t* p_sd)
 {
     if (p_sd != NULL) {
-        // initial image all black
-        guchar* bw = calloc((size_t) p_sd->width * sizeof(guchar), (size_t) p_sd->height);
+        // two persistent frames (initially all black): one displayed, one drawn into
+        p_sd->frames[0] = new_frame_(p_sd->width, p_sd->height);
+        p_sd->frames[1] = new_frame_(p_sd->width, p_sd->height);
+        if (p_sd->frames[0] == NULL || p_sd->frames[1] == NULL) {
+            if (p_sd->frames[0] != NULL) g_object_unref(p_sd->frames[0]);
+            if (p_sd->frames[1] != NULL) g_object_unref(p_sd->frames[1]);
+            free(p_sd);
+            return;
+        }
+        p_sd->front = 0;
 
         gtk_init(p_argc, p_argv);
         GtkWidget* window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -124,16 +137,7 @@ void sd_launch(int* p_argc, char*** p_argv, simple_image_displayer_t* p_sd)
         gtk_window_set_default_size(GTK_WINDOW(window), p_sd->width + 20, p_sd->height + 20);
         gtk_window_set_position(GTK_WINDOW(window), GTK_WIN_POS_CENTER);
 
-        p_sd->image = gtk_image_new_from_pixbuf(
-                      gdk_pixbuf_new_from_bytes(
-                      bw_to_rgb(bw, (guint) (p_sd->height * p_sd->width)),
-                      GDK_COLORSPACE_RGB,        // colorspace
-                      0,                         // has_alpha (no alpha)
-                      8,                         // bits-per-sample (must be 8)
-                      p_sd->width, p_sd->height, // cols, rows
-                      3*p_sd->width              // rowstride
-                      )
-                      );
+        p_sd->image = gtk_image_new_from_pixbuf(p_sd->frames[0]);
         gtk_container_add(GTK_CONTAINER(window), p_sd->image);
 
         // quit function
@@ -157,6 +161,8 @@ void sd_launch(int* p_argc, char*** p_argv, simple_image_displayer_t* p_sd)
 
         gtk_widget_show_all(window);
         gtk_main();
+        g_object_unref(p_sd->frames[0]);
+        g_object_unref(p_sd->frames[1]);
         free(p_sd);
     }
 }
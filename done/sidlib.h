@@ -16,6 +16,8 @@ extern "C" {
 
 /**
  * @brief image generator function type
+ *        (draws RGB pixels, of rowstride 3*width, into the frame not displayed,
+ *        which holds the image generated two calls before)
  */
 typedef void (*ds_image_generator)(guchar*, int, int);
 
@@ -40,6 +42,8 @@ typedef struct {
     guint timeout_id;
     const char* title;
     GtkWidget* image;
+    GdkPixbuf* frames[2]; // double buffer: generator draws into frames[1 - front]
+    int front;            // index of the displayed frame
 } simple_image_displayer_t;
 
 
@@ -0,0 +1,89 @@
+/**
+ * @file sprite_cache.c
+ * @brief Per-line sprite selection cache for GameBoy Emulator
+ *
+ * @date 2020
+ */
+#include <string.h> // for memset
+
+#include "sprite_cache.h"
+
+#define SPRITE_CACHE_OAM_SIZE (SPRITE_CACHE_END - SPRITE_CACHE_START + 1)
+#define SPRITE_CACHE_SPRITE_SIZE 4 // bytes of a sprite in OAM
+#define SPRITE_CACHE_Y_OFFSET 16
+
+/**
+ * @brief Selects the sprites of all the lines in one pass over OAM
+ */
+static void build(sprite_cache_t* cache, const bus_t bus, data_t height)
+{
+    data_t oam[SPRITE_CACHE_OAM_SIZE] = { 0 };
+    for(addr_t i = 0; i < SPRITE_CACHE_OAM_SIZE; ++i) {
+        bus_read(bus, (addr_t)(SPRITE_CACHE_START + i), &(oam[i]));
+    }
+
+    memset(cache->lines, 0, sizeof(cache->lines));
+    for(uint8_t i = 0; i < SPRITE_CACHE_NB_SPRITES; ++i) {
+        const data_t* sprite = &(oam[SPRITE_CACHE_SPRITE_SIZE * i]);
+        const data_t sy = (data_t)(sprite[0] - SPRITE_CACHE_Y_OFFSET);
+
+        for(int y = sy; y < sy + height && y < SPRITE_CACHE_LINES; ++y) {
+            sprite_cache_line_t* line = &(cache->lines[y]);
+            if(line->nb == SPRITE_CACHE_PER_LINE) { // the first ones in OAM only
+                continue;
+            }
+            // inserted after the ones with a lower or the same X
+            size_t k = line->nb++;
+            for(; k > 0 && oam[SPRITE_CACHE_SPRITE_SIZE * line->index[k - 1] + 1] > sprite[1]; --k) {
+                line->index[k] = line->index[k - 1];
+            }
+            line->index[k] = i;
+        }
+    }
+
+    cache->height = height;
+    cache->dirty = 0;
+}
+
+// ======================================================================
+// See sprite_cache.h
+int sprite_cache_init(sprite_cache_t* cache)
+{
+    M_REQUIRE_NON_NULL(cache);
+
+    memset(cache, 0, sizeof(*cache));
+    sprite_cache_invalidate(cache);
+
+    return ERR_NONE;
+}
+
+// See sprite_cache.h
+void sprite_cache_invalidate(sprite_cache_t* cache)
+{
+    if(cache != NULL) {
+        cache->dirty = 1;
+    }
+}
+
+// See sprite_cache.h
+void sprite_cache_invalidate_addr(sprite_cache_t* cache, addr_t addr)
+{
+    if(addr >= SPRITE_CACHE_START && addr <= SPRITE_CACHE_END) {
+        sprite_cache_invalidate(cache);
+    }
+}
+
+// See sprite_cache.h
+const sprite_cache_line_t* sprite_cache_line(sprite_cache_t* cache, const bus_t bus,
+                                             data_t y, data_t height)
+{
+    if(cache == NULL || bus == NULL || y >= SPRITE_CACHE_LINES) {
+        return NULL;
+    }
+
+    if(cache->dirty || cache->height != height) {
+        build(cache, bus, height);
+    }
+
+    return &(cache->lines[y]);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+/**
+ * @file sprite_cache.h
+ * @brief Per-line sprite selection cache for GameBoy Emulator
+ *        (used by the LCD controller with -DSPRITE_CACHE)
+ *
+ * Keeps, for each visible line, the (at most SPRITE_CACHE_PER_LINE) sprites
+ * of OAM (0xFE00 to 0xFE9F) shown on it, by order of priority (X coordinate,
+ * then OAM index). All the lines are built from OAM in a single pass, only
+ * when used after OAM or the sprite height changed: every write into OAM
+ * must be reported with sprite_cache_invalidate_addr().
+ *
+ * @date 2020
+ */
+
+#include <stdint.h>
+
+#include "bus.h"
+#include "bit.h"
+#include "error.h"
+#include "memory.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief OAM area
+ */
+#define SPRITE_CACHE_START 0xFE00
+#define SPRITE_CACHE_END   0xFE9F
+
+#define SPRITE_CACHE_NB_SPRITES 40
+#define SPRITE_CACHE_PER_LINE 10
+#define SPRITE_CACHE_LINES 144 // visible lines
+
+//=========================================================================
+/**
+ * @brief the sprites of one line
+ */
+typedef struct {
+    uint8_t nb;                            // number of sprites on the line
+    uint8_t index[SPRITE_CACHE_PER_LINE];  // their OAM indexes, by order of priority
+} sprite_cache_line_t;
+
+/**
+ * @brief the cache itself
+ */
+typedef struct {
+    sprite_cache_line_t lines[SPRITE_CACHE_LINES];
+    data_t height;  // sprite height the lines were built for
+    uint8_t dirty;
+} sprite_cache_t;
+
+//=========================================================================
+/**
+ * @brief Initializes a cache, to be built at its first use
+ *
+ * @param cache cache to initialize
+ * @return error code
+ */
+int sprite_cache_init(sprite_cache_t* cache);
+
+/**
+ * @brief Marks the cache as to be built again (e.g. when OAM is changed
+ *        other than by a reported write)
+ *
+ * @param cache cache to update (nothing is done if NULL)
+ */
+void sprite_cache_invalidate(sprite_cache_t* cache);
+
+/**
+ * @brief Marks the cache as to be built again if a written address is in OAM
+ *
+ * @param cache cache to update (nothing is done if NULL)
+ * @param addr written address
+ */
+void sprite_cache_invalidate_addr(sprite_cache_t* cache, addr_t addr);
+
+/**
+ * @brief Gives the sprites of a line, building all the lines from the bus
+ *        first if OAM or the sprite height changed
+ *
+ * @param cache cache to look into
+ * @param bus bus to read OAM from
+ * @param y line (below SPRITE_CACHE_LINES)
+ * @param height height of the sprites (8 or 16)
+ * @return the sprites of the line (NULL if a parameter is invalid)
+ */
+const sprite_cache_line_t* sprite_cache_line(sprite_cache_t* cache, const bus_t bus,
+                                             data_t y, data_t height);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,231 @@
+/**
+ * @file test-blargg.c
+ * @brief runs all blargg's test ROMs at once, one thread each
+ *
+ * Each ROM is run until its result is sent on the serial port ("Passed" or
+ * "Failed" line), until it is stuck in a "JR -2" loop no interrupt can
+ * leave, or at most for its cycle budget (as in tests/run_blargg.sh):
+ * the whole suite takes about the time of its slowest ROM.
+ *
+ * @date 2020
+ */
+
+#include "gameboy.h"
+#include "serial.h"
+#include "util.h"  // for zero_init_var()
+#include "error.h"
+
+// placed here to prevent an include loop
+#include "cpu-storage.h" // cpu_read_at_idx()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h> // for PRIu64
+#include <pthread.h>
+
+#define DEFAULT_DIR "tests/data/blargg_roms"
+
+// endless loops are looked for once per frame
+#define SLICE_CYCLES FRAME_TOTAL_CYCLES
+
+// JR -2: jumps onto itself
+#define OP_JR 0x18
+#define JR_SELF 0xFE
+
+#define MILLION 1000000
+
+/**
+ * @brief why a ROM stopped
+ */
+typedef enum {
+    STOP_RESULT, // result line sent
+    STOP_LOOP,   // stuck forever
+    STOP_BUDGET, // out of cycles
+    STOP_ERROR   // emulation error
+} stop_t;
+
+static const char* const stop_names[] = { "result", "endless loop", "cycle budget", "error" };
+
+/**
+ * @brief a test ROM and its outcome
+ */
+typedef struct {
+    const char* name;
+    uint64_t budget;          // in millions of cycles
+    gameboy_timing_t timing;
+    const char* dir;
+    // outcome
+    int err;
+    stop_t stop;
+    uint64_t cycles;
+    int passed;
+    char output[SERIAL_OUTPUT_SIZE + 1];
+} blargg_test_t;
+
+static blargg_test_t tests[] = {
+    { .name = "01-special.gb",             .budget = 5 },
+    { .name = "02-interrupts.gb",          .budget = 5 },
+    { .name = "03-op sp,hl.gb",            .budget = 5 },
+    { .name = "04-op r,imm.gb",            .budget = 7 },
+    { .name = "05-op rp.gb",               .budget = 7 },
+    { .name = "06-ld r,r.gb",              .budget = 5 },
+    { .name = "07-jr,jp,call,ret,rst.gb",  .budget = 4 },
+    { .name = "08-misc instrs.gb",         .budget = 5 },
+    { .name = "09-op r,r.gb",              .budget = 15 },
+    { .name = "10-bit ops.gb",             .budget = 20 },
+    { .name = "11-op a,(hl).gb",           .budget = 25 },
+    { .name = "instr_timing.gb",           .budget = 5 }
+};
+
+#define NB_TESTS (sizeof(tests) / sizeof(tests[0]))
+
+// ======================================================================
+static void error(const char* pgm, const char* msg)
+{
+    fputs("ERROR: ", stderr);
+    if (msg != NULL) fputs(msg, stderr);
+    fprintf(stderr, "\nusage:    %s [exact|line [rom_dir]]\n", pgm);
+    fprintf(stderr, "examples: %s\n", pgm);
+    fprintf(stderr, "          %s line " DEFAULT_DIR "\n", pgm);
+}
+
+// ======================================================================
+/**
+ * @brief whether the ROM sent a whole "Passed" or "Failed" line
+ */
+static int has_result(const char* output)
+{
+    const char* const results[] = { "Passed", "Failed" };
+    for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); ++i) {
+        const char* found = strstr(output, results[i]);
+        if (found != NULL && strchr(found, '\n') != NULL) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// ======================================================================
+/**
+ * @brief whether the CPU spins on a "JR -2" no interrupt can take it out of
+ */
+static int is_stuck(cpu_t* cpu)
+{
+    return cpu_read_at_idx(cpu, cpu->PC) == OP_JR
+           && cpu_read_at_idx(cpu, (addr_t)(cpu->PC + 1)) == JR_SELF
+           && (!cpu->IME || cpu->IE == 0);
+}
+
+// ======================================================================
+/**
+ * @brief whether the output is the one of a passed test
+ *        (the ROM name, two empty lines, and "Passed")
+ */
+static int is_passed(const char* name, const char* output)
+{
+    char expected[FILENAME_MAX + 16];
+    const size_t name_length = strlen(name) - strlen(".gb");
+    snprintf(expected, sizeof(expected), "%.*s\n\n\nPassed", (int) name_length, name);
+
+    // trailing new lines ignored
+    size_t length = strlen(output);
+    while (length > 0 && output[length - 1] == '\n') {
+        --length;
+    }
+    return length == strlen(expected) && strncmp(output, expected, length) == 0;
+}
+
+// ======================================================================
+static void* run_test(void* arg)
+{
+    blargg_test_t* test = arg;
+
+    char filename[FILENAME_MAX];
+    snprintf(filename, sizeof(filename), "%s/%s", test->dir, test->name);
+
+    gameboy_t* gb = calloc(1, sizeof(gameboy_t));
+    if (gb == NULL) {
+        test->err = ERR_MEM;
+        test->stop = STOP_ERROR;
+        return NULL;
+    }
+    test->err = gameboy_create(gb, filename);
+    if (test->err == ERR_NONE) {
+        test->err = gameboy_set_timing(gb, test->timing);
+    }
+
+    // stops at each line sent, and once per frame
+    gameboy_until_t until;
+    zero_init_var(until);
+    until.conditions = GB_UNTIL_SERIAL;
+    until.serial = "\n";
+
+    const uint64_t budget = test->budget * MILLION;
+    const char* output = serial_output(&(gb->serial), NULL);
+    test->stop = test->err == ERR_NONE ? STOP_BUDGET : STOP_ERROR;
+    while (test->err == ERR_NONE && gb->cycles < budget) {
+        until.cycle = budget - gb->cycles < SLICE_CYCLES ? budget : gb->cycles + SLICE_CYCLES;
+        test->err = gameboy_run_to(gb, &until, NULL);
+        if (test->err != ERR_NONE) {
+            test->stop = STOP_ERROR;
+        } else if (has_result(output)) {
+            test->stop = STOP_RESULT;
+            break;
+        } else if (!gb->boot && is_stuck(&(gb->cpu))) {
+            test->stop = STOP_LOOP;
+            break;
+        }
+    }
+
+    test->cycles = gb->cycles;
+    strcpy(test->output, output);
+    test->passed = test->err == ERR_NONE && is_passed(test->name, test->output);
+
+    gameboy_free(gb);
+    free(gb);
+    return NULL;
+}
+
+// ======================================================================
+int main(int argc, char* argv[])
+{
+    gameboy_timing_t timing = GB_TIMING_EXACT;
+    if (argc > 1 && gameboy_timing_parse(argv[1], &timing) != ERR_NONE) {
+        error(argv[0], "unknown timing mode");
+        return ERR_BAD_PARAMETER;
+    }
+    const char* const dir = argc > 2 ? argv[2] : DEFAULT_DIR;
+
+    pthread_t threads[NB_TESTS];
+    int started[NB_TESTS];
+    for (size_t i = 0; i < NB_TESTS; ++i) {
+        tests[i].timing = timing;
+        tests[i].dir = dir;
+        started[i] = pthread_create(&threads[i], NULL, run_test, &tests[i]) == 0;
+        if (!started[i]) { // run here then
+            run_test(&tests[i]);
+        }
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < NB_TESTS; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+
+        const blargg_test_t* test = &tests[i];
+        printf("%s: %s (%s after %" PRIu64 " cycles).\n", test->name,
+               test->passed ? "PASSED" : "FAILED", stop_names[test->stop], test->cycles);
+        if (!test->passed) {
+            ++failed;
+            if (test->err != ERR_NONE) {
+                printf("  error: %s\n", ERR_MESSAGES[test->err - ERR_NONE]);
+            }
+            printf("  output:\n%s\n", test->output[0] == '\0' ? "    empty output." : test->output);
+        }
+    }
+    printf("%zu/%zu passed\n", NB_TESTS - failed, NB_TESTS);
+
+    return failed == 0 ? 0 : 1;
+}
@@ -70,6 +70,7 @@ int mem_dump_to_file(const char* filename, component_t* c)
 #define PRPAIR "0x%04" PRIX16
 void cpu_dump(FILE* file, cpu_t* cpu)
 {
+    cpu_flags_sync(cpu); // F may still be pending in lazy flags mode
     fprintf(file, "REGS: " PRREG ", " PRREG ", " PRREG ", " PRREG ", " PRREG ", " PRREG ", " PRREG ", " PRREG "\n",
             cpu->A, cpu->B, cpu->C, cpu->D, cpu->E, cpu->F, cpu->H, cpu->L);
     fprintf(file, "REGPAIRS: " PRPAIR ", " PRPAIR ", " PRPAIR ", " PRPAIR "\n",
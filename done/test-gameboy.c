@@ -22,8 +22,9 @@ static void error(const char* pgm, const char* msg)
 {
     fputs("ERROR: ", stderr);
     if (msg != NULL) fputs(msg, stderr);
-    fprintf(stderr, "\nusage:    %s input_file [iterations]\n", pgm);
+    fprintf(stderr, "\nusage:    %s input_file [iterations [exact|line]]\n", pgm);
     fprintf(stderr, "examples: %s rom.gb 1000\n", pgm);
+    fprintf(stderr, "          %s rom.gb 1000 line\n", pgm);
     fprintf(stderr, "          %s game.gb\n", pgm);
 }
 
@@ -57,6 +58,7 @@ int mem_dump_to_file(const char* filename, component_t* c)
 #define PRPAIR "0x%04" PRIX16
 void cpu_dump(FILE* file, cpu_t* cpu)
 {
+    cpu_flags_sync(cpu); // F may still be pending in lazy flags mode
     fprintf(file, "REGS: " PRREG ", " PRREG ", " PRREG ", " PRREG ", " PRREG ", " PRREG ", " PRREG ", " PRREG "\n",
             cpu->A, cpu->B, cpu->C, cpu->D, cpu->E, cpu->F, cpu->H, cpu->L);
     fprintf(file, "REGPAIRS: " PRPAIR ", " PRPAIR ", " PRPAIR ", " PRPAIR "\n",
@@ -83,6 +85,13 @@ int cpu_dump_to_file(const char* filename, cpu_t* cpu)
     return ERR_NONE;
 }
 
+// ======================================================================
+// prints what is sent on the serial port (e.g. the results of test ROMs)
+static void serial_print(void* opaque _unused, data_t byte)
+{
+    putchar(byte);
+}
+
 // ======================================================================
 int main(int argc, char* argv[])
 {
@@ -101,11 +110,23 @@ int main(int argc, char* argv[])
         return err;
     }
 
+    serial_set_sink(&(gb.serial), serial_print, NULL);
+
     uint64_t cycle = 1;
     if (argc > 2) {
         cycle = (uint64_t) atoll(argv[2]);
     }
 
+    if (argc > 3) {
+        gameboy_timing_t timing = GB_TIMING_EXACT;
+        if (gameboy_timing_parse(argv[3], &timing) != ERR_NONE) {
+            error(argv[0], "unknown timing mode");
+            gameboy_free(&gb);
+            return ERR_BAD_PARAMETER;
+        }
+        gameboy_set_timing(&gb, timing);
+    }
+
     err = gameboy_run_until(&gb, cycle);
     if (err == ERR_NONE) {
         cpu_dump_to_file("dump_cpu.txt", &(gb.cpu));
@@ -24,13 +24,16 @@ error () {
 display () {
     output="$(cat "$1")"
     if [ "x$output" = 'x' ]; then
-        echo '    empty output. Did you forget to compile with -DBLARGG ?'
+        echo '    empty output.'
     else
         echo "$output"
     fi
 }
 
 # ======================================================================
+# any argument is given to test-gameboy after the number of cycles
+# (e.g. "line" to run the tests in the per-line timing mode)
+# (test-blargg runs them all at once, each until its result is sent)
 rootdir="$(realpath "$(dirname "$(realpath "$0")")/..")"
 exec="${rootdir}/test-gameboy"
 [ -x "${exec}" ] || error "Cannot find \"${exec}\""
@@ -62,7 +65,7 @@ do
 
 Passed"
     status=
-    "$exec" "${testdir}/$gb_file" ${time}000000 > $temp 2> $temp2
+    "$exec" "${testdir}/$gb_file" ${time}000000 "$@" > $temp 2> $temp2
     if [ "x$(cat $temp)" = "x$expected" ]; then
         status=ok
     else
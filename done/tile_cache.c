@@ -0,0 +1,107 @@
+/**
+ * @file tile_cache.c
+ * @brief Decoded tile cache for GameBoy Emulator
+ *
+ * @date 2020
+ */
+#include <string.h> // for memset
+
+#include "tile_cache.h"
+
+#define TILE_CACHE_TILE_SIZE (2 * TILE_CACHE_TILE_ROWS)
+
+/**
+ * @brief Reverses the order of the bits of a byte
+ */
+static data_t reverse(data_t b)
+{
+    data_t r = 0;
+    for(int i = 0; i < 8; ++i) {
+        r = (data_t)(r << 1 | (b & 1));
+        b >>= 1;
+    }
+    return r;
+}
+
+/**
+ * @brief Decodes the 8 rows of a tile from the bus
+ */
+static void decode(tile_cache_t* cache, const bus_t bus, size_t tile)
+{
+    const addr_t start = (addr_t)(TILE_CACHE_START + tile * TILE_CACHE_TILE_SIZE);
+
+    for(size_t y = 0; y < TILE_CACHE_TILE_ROWS; ++y) {
+        cache->mirrored[tile][y] = tile_row_decode(bus, (addr_t)(start + 2 * y), 1);
+        cache->rows[tile][y].lsb = reverse(cache->mirrored[tile][y].lsb);
+        cache->rows[tile][y].msb = reverse(cache->mirrored[tile][y].msb);
+    }
+
+    cache->dirty[tile] = 0;
+}
+
+// ======================================================================
+// See tile_cache.h
+tile_row_t tile_row_decode(const bus_t bus, addr_t addr, bit_t mirror)
+{
+    tile_row_t row = { 0, 0 };
+    if(bus == NULL) {
+        return row;
+    }
+
+    bus_read(bus, addr, &(row.lsb));
+    bus_read(bus, (addr_t)(addr + 1), &(row.msb));
+
+    // in the video RAM, the leftmost pixel is the most significant bit
+    if(!mirror) {
+        row.lsb = reverse(row.lsb);
+        row.msb = reverse(row.msb);
+    }
+
+    return row;
+}
+
+// ======================================================================
+// See tile_cache.h
+int tile_cache_init(tile_cache_t* cache)
+{
+    M_REQUIRE_NON_NULL(cache);
+
+    memset(cache, 0, sizeof(*cache));
+    tile_cache_invalidate(cache);
+
+    return ERR_NONE;
+}
+
+// See tile_cache.h
+void tile_cache_invalidate(tile_cache_t* cache)
+{
+    if(cache != NULL) {
+        memset(cache->dirty, 1, sizeof(cache->dirty));
+    }
+}
+
+// See tile_cache.h
+void tile_cache_invalidate_addr(tile_cache_t* cache, addr_t addr)
+{
+    if(cache != NULL && addr >= TILE_CACHE_START && addr <= TILE_CACHE_END) {
+        cache->dirty[(addr - TILE_CACHE_START) / TILE_CACHE_TILE_SIZE] = 1;
+    }
+}
+
+// See tile_cache.h
+tile_row_t tile_cache_row(tile_cache_t* cache, const bus_t bus, addr_t addr, bit_t mirror)
+{
+    tile_row_t none = { 0, 0 };
+    if(cache == NULL || bus == NULL || addr < TILE_CACHE_START || addr > TILE_CACHE_END) {
+        return none;
+    }
+
+    const size_t tile = (size_t)(addr - TILE_CACHE_START) / TILE_CACHE_TILE_SIZE;
+    const size_t y = (size_t)(addr - TILE_CACHE_START) % TILE_CACHE_TILE_SIZE / 2;
+
+    if(cache->dirty[tile]) {
+        decode(cache, bus, tile);
+    }
+
+    return mirror ? cache->mirrored[tile][y] : cache->rows[tile][y];
+}
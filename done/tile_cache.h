@@ -0,0 +1,107 @@
+#pragma once
+
+/**
+ * @file tile_cache.h
+ * @brief Decoded tile cache for GameBoy Emulator
+ *        (used by the LCD controller with -DTILE_CACHE)
+ *
+ * Keeps the 8 rows of the 384 tiles of the video RAM (0x8000 to 0x97FF)
+ * decoded into the bit order of the image lines (leftmost pixel in bit 0),
+ * both as displayed and mirrored (for the sprites flipped along X).
+ *
+ * A tile is decoded again from the bus only when it is used after having
+ * been marked dirty: every write into the tile data must be reported with
+ * tile_cache_invalidate_addr().
+ *
+ * @date 2020
+ */
+
+#include <stdint.h>
+
+#include "bus.h"
+#include "bit.h"
+#include "error.h"
+#include "memory.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief tile data area of the video RAM
+ */
+#define TILE_CACHE_START 0x8000
+#define TILE_CACHE_END   0x97FF
+
+#define TILE_CACHE_NB_TILES 384
+#define TILE_CACHE_TILE_ROWS 8
+
+//=========================================================================
+/**
+ * @brief one decoded row of 8 pixels
+ */
+typedef struct {
+    data_t msb; // most significant bits of the colors of the 8 pixels
+    data_t lsb; // least significant bits of the colors of the 8 pixels
+} tile_row_t;
+
+/**
+ * @brief the cache itself
+ */
+typedef struct {
+    tile_row_t rows[TILE_CACHE_NB_TILES][TILE_CACHE_TILE_ROWS];     // as displayed
+    tile_row_t mirrored[TILE_CACHE_NB_TILES][TILE_CACHE_TILE_ROWS]; // flipped along X
+    uint8_t dirty[TILE_CACHE_NB_TILES];
+} tile_cache_t;
+
+//=========================================================================
+/**
+ * @brief Initializes a cache, all the tiles of which are to be decoded
+ *
+ * @param cache cache to initialize
+ * @return error code
+ */
+int tile_cache_init(tile_cache_t* cache);
+
+/**
+ * @brief Marks all the tiles as dirty (e.g. when the video RAM is changed
+ *        other than by a reported write)
+ *
+ * @param cache cache to update (nothing is done if NULL)
+ */
+void tile_cache_invalidate(tile_cache_t* cache);
+
+/**
+ * @brief Marks as dirty the tile containing a written address
+ *        (nothing is done out of the tile data area)
+ *
+ * @param cache cache to update (nothing is done if NULL)
+ * @param addr written address
+ */
+void tile_cache_invalidate_addr(tile_cache_t* cache, addr_t addr);
+
+/**
+ * @brief Decodes one tile row from the bus (without any cache)
+ *
+ * @param bus bus to decode from
+ * @param addr address of the row (its first byte)
+ * @param mirror whether the row is wanted flipped along X
+ * @return the decoded row
+ */
+tile_row_t tile_row_decode(const bus_t bus, addr_t addr, bit_t mirror);
+
+/**
+ * @brief Gives a decoded tile row, decoding its tile from the bus if dirty
+ *
+ * @param cache cache to look into
+ * @param bus bus to decode from
+ * @param addr address of the row (its first byte, between TILE_CACHE_START
+ *        and TILE_CACHE_END)
+ * @param mirror whether the row is wanted flipped along X
+ * @return the decoded row (all pixels of color 0 if the address is invalid)
+ */
+tile_row_t tile_cache_row(tile_cache_t* cache, const bus_t bus, addr_t addr, bit_t mirror);
+
+#ifdef __cplusplus
+}
+#endif
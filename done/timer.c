@@ -3,6 +3,29 @@
 //placed here to prevent an include loop
 #include "cpu-storage.h"
 
+/**
+ * @brief Computes DIV when read (see timer_init())
+ */
+static int div_read(void* owner, addr_t addr, data_t* data)
+{
+    (void) addr;
+    const gbtimer_t* const timer = owner;
+    *data = msb8(timer->counter);
+
+    return ERR_NONE;
+}
+
+/**
+ * @brief Writes DIV into the bus, unless it is computed when read
+ */
+static int sync_div(gbtimer_t* timer)
+{
+    if(timer->cpu->io != NULL) {
+        return ERR_NONE;
+    }
+    return cpu_write_at_idx(timer->cpu, REG_DIV, msb8(timer->counter)); // sync 8 strong bits of timer with bus
+}
+
 // See timer.h
 int timer_init(gbtimer_t* timer, cpu_t* cpu)
 {
@@ -11,6 +34,9 @@ int timer_init(gbtimer_t* timer, cpu_t* cpu)
 
     timer->cpu = cpu;
     timer->counter = 0;
+    if(cpu->io != NULL) {
+        M_EXIT_IF_ERR(bus_io_set_reader(*(cpu->io), REG_DIV, div_read, timer));
+    }
 
     return ERR_NONE;
 }
@@ -23,7 +49,7 @@ int timer_cycle(gbtimer_t* timer)
     bit_t old_state = timer_state(timer);
 
     timer->counter += TIMER_CYCLE;
-    int ret = cpu_write_at_idx(timer->cpu, REG_DIV, msb8(timer->counter)); // sync 8 strong bits of timer with bus
+    int ret = sync_div(timer);
     if(ret!=ERR_NONE) {
         return ret;
     }
@@ -42,7 +68,7 @@ int timer_bus_listener(gbtimer_t* timer, addr_t addr)
 
     if(addr == REG_DIV) {
         timer->counter = 0;
-        int ret = cpu_write_at_idx(timer->cpu, REG_DIV, 0); // sync 8 strong bits of timer with bus
+        int ret = sync_div(timer);
         if(ret!=ERR_NONE) {
             return ret;
         }
@@ -54,44 +80,119 @@ int timer_bus_listener(gbtimer_t* timer, addr_t addr)
     return ERR_NONE;
 }
 
-// See timer.h
-bit_t timer_state(gbtimer_t* timer)
+/**
+ * @brief State of the timer for a given TAC and internal counter
+ */
+static bit_t counter_state(data_t tac, uint16_t counter)
 {
-    M_REQUIRE_NON_NULL(timer);
+    bit_t tac_2 = bit_get(tac, 2);
 
-    bit_t tac_2 = (bit_get(cpu_read_at_idx(timer->cpu, REG_TAC), 2));
-
-    bit_t tac_index = cpu_read_at_idx(timer->cpu, REG_TAC) & 0x03;
+    bit_t tac_index = tac & 0x03;
 
     switch(tac_index) {
     case 0 : {
-        return tac_2 & bit_get(msb8(timer->counter), 1); //9th bit is 1st of most significant bits
+        return tac_2 & bit_get(msb8(counter), 1); //9th bit is 1st of most significant bits
     }
     case 1 : {
-        return tac_2 & bit_get(timer->counter, 3);
+        return tac_2 & bit_get(counter, 3);
     }
     case 2 : {
-        return tac_2 & bit_get(timer->counter, 5);
+        return tac_2 & bit_get(counter, 5);
     }
     case 3 : {
-        return tac_2 & bit_get(timer->counter, 7);
+        return tac_2 & bit_get(counter, 7);
     }
     default:
         return 0;
     }
 }
 
+// See timer.h
+bit_t timer_state(gbtimer_t* timer)
+{
+    M_REQUIRE_NON_NULL(timer);
+
+    return counter_state(cpu_read_at_idx(timer->cpu, REG_TAC), timer->counter);
+}
+
+/**
+ * @brief Increments TIMA
+ */
+static void incr_TIMA(gbtimer_t* timer)
+{
+    uint8_t timer_val = cpu_read_at_idx(timer->cpu, REG_TIMA);
+    if(timer_val == 0xFF) {
+        cpu_request_interrupt(timer->cpu,TIMER); // raise interruption when "go-around"
+        uint8_t reset_val = cpu_read_at_idx(timer->cpu, REG_TMA);
+        cpu_write_at_idx(timer->cpu, REG_TIMA, reset_val);
+    } else {
+        cpu_write_at_idx(timer->cpu, REG_TIMA, ++timer_val);
+    }
+}
+
 // See timer.h
 void timer_incr_if_state_change(gbtimer_t* timer, bit_t old_state)
 {
     if(timer!=NULL && old_state == 1 && timer_state(timer) == 0)  {
-        uint8_t timer_val = cpu_read_at_idx(timer->cpu, REG_TIMA);
-        if(timer_val == 0xFF) {
-            cpu_request_interrupt(timer->cpu,TIMER); // raise interruption when "go-around"
-            uint8_t reset_val = cpu_read_at_idx(timer->cpu, REG_TMA);
-            cpu_write_at_idx(timer->cpu, REG_TIMA, reset_val);
-        } else {
-            cpu_write_at_idx(timer->cpu, REG_TIMA, ++timer_val);
+        incr_TIMA(timer);
+    }
+}
+
+// See timer.h
+uint64_t timer_quiet_cycles(gbtimer_t* timer, bit_t with_div, uint64_t max)
+{
+    if(timer == NULL) {
+        return 0;
+    }
+
+    const data_t tac = cpu_read_at_idx(timer->cpu, REG_TAC);
+    if(!bit_get(tac, 2) && !with_div) { // TIMA stopped and DIV not looked at
+        return max;
+    }
+
+    // at most one DIV period (or 256 cycles for TIMA): short loop
+    uint16_t counter = timer->counter;
+    bit_t state = counter_state(tac, counter);
+    for(uint64_t n = 0; n < max; ++n) {
+        const uint16_t next = (uint16_t)(counter + TIMER_CYCLE);
+        const bit_t next_state = counter_state(tac, next);
+        if((state == 1 && next_state == 0) || (with_div && msb8(next) != msb8(counter))) {
+            return n;
         }
+        counter = next;
+        state = next_state;
+    }
+
+    return max;
+}
+
+// See timer.h
+int timer_fast_forward(gbtimer_t* timer, uint64_t cycles)
+{
+    M_REQUIRE_NON_NULL(timer);
+
+    timer->counter = (uint16_t)(timer->counter + cycles * TIMER_CYCLE);
+
+    return sync_div(timer);
+}
+
+// See timer.h
+int timer_catch_up(gbtimer_t* timer, uint64_t cycles)
+{
+    M_REQUIRE_NON_NULL(timer);
+
+    // the state falls each time the counter goes through a multiple of
+    // twice its bit (9, 3, 5 or 7 according to TAC)
+    static const uint64_t periods[] = { 1 << 10, 1 << 4, 1 << 6, 1 << 8 };
+    const data_t tac = cpu_read_at_idx(timer->cpu, REG_TAC);
+    const uint64_t from = timer->counter;
+    const uint64_t to = from + cycles * TIMER_CYCLE;
+    uint64_t falls = bit_get(tac, 2) ? to / periods[tac & 0x03] - from / periods[tac & 0x03] : 0;
+
+    M_EXIT_IF_ERR(timer_fast_forward(timer, cycles));
+    for(; falls > 0; --falls) {
+        incr_TIMA(timer);
     }
+
+    return ERR_NONE;
 }
@@ -39,7 +39,8 @@ typedef struct {
 } gbtimer_t;
 
 /**
- * @brief Initiates a timer
+ * @brief Initiates a timer (DIV being computed when read, if the cpu has
+ *        read handlers, see bus_io_t)
  *
  * @param timer timer to initiate
  * @param cpu cpu to use for timer
@@ -82,6 +83,36 @@ bit_t timer_state(gbtimer_t* timer);
  */
 void timer_incr_if_state_change(gbtimer_t* timer, bit_t old_state);
 
+/**
+ * @brief Number of cycles the timer can run from now on without any visible
+ *        effect: no change of TIMA (hence of IF), nor of DIV if requested
+ *
+ * @param timer Timer
+ * @param with_div whether a change of DIV is a visible effect
+ * @param max maximum number of cycles to look for
+ * @return number of quiet cycles (at most max)
+ */
+uint64_t timer_quiet_cycles(gbtimer_t* timer, bit_t with_div, uint64_t max);
+
+/**
+ * @brief Runs several Timer cycles at once; only valid for cycles known
+ *        to be quiet (see timer_quiet_cycles())
+ *
+ * @param timer timer to cycle
+ * @param cycles number of cycles
+ * @return error code
+ */
+int timer_fast_forward(gbtimer_t* timer, uint64_t cycles);
+
+/**
+ * @brief Runs several Timer cycles at once, TIMA included (increments,
+ *        reloads and interrupts all applied at the end)
+ *
+ * @param timer timer to cycle
+ * @param cycles number of cycles
+ * @return error code
+ */
+int timer_catch_up(gbtimer_t* timer, uint64_t cycles);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,261 @@
+/**
+ * @file unit-test-alu_table.c
+ * @brief Unit test code for the table-driven ALU: exhaustive comparison
+ *        against the reference ALU, and benchmark of both
+ *
+ * @date 2020
+ */
+
+// for thread-safe randomization
+#include <time.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <check.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#include "tests.h"
+#include "alu.h"
+#include "alu_ext.h"
+#include "alu_table.h"
+#include "bit.h"
+#include "error.h"
+
+// ------------------------------------------------------------
+#define LOOP_ON(T) const size_t s_ = sizeof(T) / sizeof(*T);  \
+  for(size_t i_ = 0; i_ < s_; ++i_)
+
+/**
+ * @brief flags already present in the result before the operation
+ *        (some ALU functions keep them, others overwrite them)
+ */
+static const flags_t initial_flags[] = {0x00, 0xF0, FLAG_Z | FLAG_H, FLAG_N | FLAG_C};
+
+#define ck_assert_same_output(ref, tab, what, x, y, c) \
+    ck_assert_msg((ref).value == (tab).value && (ref).flags == (tab).flags, \
+                  what "(0x%02X, 0x%02X, %d) failed: table gives (0x%02X, 0x%02X) instead of (0x%02X, 0x%02X)", \
+                  x, y, c, (tab).value, (tab).flags, (ref).value, (ref).flags)
+
+START_TEST(alu_table_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    alu_output_t result = {0, 0};
+
+    ck_assert_int_eq(alu_table_init(), ERR_NONE);
+    ck_assert_int_eq(alu_table_ready(), 1);
+
+    ck_assert_int_eq(alu_table_add8(NULL, 0, 0, 0), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(alu_table_sub8(NULL, 0, 0, 0), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(alu_table_inc8(NULL, 0), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(alu_table_dec8(NULL, 0), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(alu_table_shift(NULL, 0, LEFT), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(alu_table_shift(&result, 0, 2), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(alu_table_shiftR_A(NULL, 0), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(alu_table_rotate(NULL, 0, LEFT), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(alu_table_rotate(&result, 0, 2), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(alu_table_carry_rotate(NULL, 0, LEFT, 0), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(alu_table_carry_rotate(&result, 0, 2, 0), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(alu_table_swap4(NULL, 0), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(alu_table_bcd_adjust(NULL), ERR_BAD_PARAMETER);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(alu_table_add8_sub8_exhaustive)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    LOOP_ON(initial_flags) {
+        for (int c = 0; c <= 1; ++c) {
+            for (int x = 0; x <= 0xFF; ++x) {
+                for (int y = 0; y <= 0xFF; ++y) {
+                    alu_output_t ref = {0, initial_flags[i_]};
+                    alu_output_t tab = {0, initial_flags[i_]};
+                    ck_assert_int_eq(alu_add8(&ref, x, y, c), ERR_NONE);
+                    ck_assert_int_eq(alu_table_add8(&tab, x, y, c), ERR_NONE);
+                    ck_assert_same_output(ref, tab, "alu_table_add8", x, y, c);
+
+                    ref.flags = tab.flags = initial_flags[i_];
+                    ck_assert_int_eq(alu_sub8(&ref, x, y, c), ERR_NONE);
+                    ck_assert_int_eq(alu_table_sub8(&tab, x, y, c), ERR_NONE);
+                    ck_assert_same_output(ref, tab, "alu_table_sub8", x, y, c);
+                }
+            }
+        }
+    }
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(alu_table_unary_exhaustive)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    LOOP_ON(initial_flags) {
+        const flags_t f = initial_flags[i_];
+        for (int x = 0; x <= 0xFF; ++x) {
+            alu_output_t ref = {0, f};
+            alu_output_t tab = {0, f};
+
+            alu_add8(&ref, x, 1, 0);
+            alu_table_inc8(&tab, x);
+            ck_assert_same_output(ref, tab, "alu_table_inc8", x, 1, 0);
+
+            ref.flags = tab.flags = f;
+            alu_sub8(&ref, x, 1, 0);
+            alu_table_dec8(&tab, x);
+            ck_assert_same_output(ref, tab, "alu_table_dec8", x, 1, 0);
+
+            ref.flags = tab.flags = f;
+            alu_shiftR_A(&ref, x);
+            alu_table_shiftR_A(&tab, x);
+            ck_assert_same_output(ref, tab, "alu_table_shiftR_A", x, 0, 0);
+
+            ref.flags = tab.flags = f;
+            alu_swap4(&ref, x);
+            alu_table_swap4(&tab, x);
+            ck_assert_same_output(ref, tab, "alu_table_swap4", x, 0, 0);
+
+            for (rot_dir_t dir = LEFT; dir <= RIGHT; ++dir) {
+                ref.flags = tab.flags = f;
+                alu_shift(&ref, x, dir);
+                alu_table_shift(&tab, x, dir);
+                ck_assert_same_output(ref, tab, "alu_table_shift", x, dir, 0);
+
+                ref.flags = tab.flags = f;
+                alu_rotate(&ref, x, dir);
+                alu_table_rotate(&tab, x, dir);
+                ck_assert_same_output(ref, tab, "alu_table_rotate", x, dir, 0);
+
+                for (int c = 0; c <= 1; ++c) {
+                    ref.flags = tab.flags = f;
+                    alu_carry_rotate(&ref, x, dir, c ? f | FLAG_C : f & ~FLAG_C);
+                    alu_table_carry_rotate(&tab, x, dir, c ? f | FLAG_C : f & ~FLAG_C);
+                    ck_assert_same_output(ref, tab, "alu_table_carry_rotate", x, dir, c);
+                }
+            }
+        }
+    }
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(alu_table_bcd_adjust_exhaustive)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    // all flag bytes, to also check that Z and the 4 lsb are ignored
+    for (int f = 0; f <= 0xFF; ++f) {
+        for (int x = 0; x <= 0xFF; ++x) {
+            alu_output_t ref = {x, f};
+            alu_output_t tab = {x, f};
+            ck_assert_int_eq(alu_bcd_adjust(&ref), ERR_NONE);
+            ck_assert_int_eq(alu_table_bcd_adjust(&tab), ERR_NONE);
+            ck_assert_same_output(ref, tab, "alu_table_bcd_adjust", x, f, 0);
+        }
+    }
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ------------------------------------------------------------
+#define BENCH_ROUNDS 40
+
+/**
+ * @brief runs all (x, y, carry) inputs of an 8 bit ALU operation BENCH_ROUNDS times
+ *        and returns a checksum of the results (so that nothing gets optimized away)
+ */
+#define bench_add_sub(op, sum) \
+    do { \
+        for (int r_ = 0; r_ < BENCH_ROUNDS; ++r_) \
+            for (int c_ = 0; c_ <= 1; ++c_) \
+                for (int x_ = 0; x_ <= 0xFF; ++x_) \
+                    for (int y_ = 0; y_ <= 0xFF; ++y_) { \
+                        alu_output_t o_ = {0, 0}; \
+                        op(&o_, x_, y_, c_); \
+                        sum += o_.value + o_.flags; \
+                    } \
+    } while(0)
+
+START_TEST(alu_table_benchmark)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    ck_assert_int_eq(alu_table_init(), ERR_NONE);
+
+    uint64_t sum_ref = 0;
+    uint64_t sum_tab = 0;
+
+    clock_t start = clock();
+    bench_add_sub(alu_add8, sum_ref);
+    bench_add_sub(alu_sub8, sum_ref);
+    const double time_ref = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    bench_add_sub(alu_table_add8, sum_tab);
+    bench_add_sub(alu_table_sub8, sum_tab);
+    const double time_tab = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    ck_assert_msg(sum_ref == sum_tab, "checksums differ: %" PRIu64 " vs %" PRIu64, sum_ref, sum_tab);
+
+#ifdef WITH_PRINT
+    printf("alu_add8 + alu_sub8, %d x 2 x 131072 calls: reference %.3f s, table %.3f s (x%.1f)\n",
+           BENCH_ROUNDS, time_ref, time_tab, time_tab > 0 ? time_ref / time_tab : 0.0);
+    printf("=== END of %s\n", __func__);
+#else
+    (void) time_ref; // only printed
+    (void) time_tab;
+#endif
+}
+END_TEST
+
+// ================================================================================
+Suite* alu_table_test_suite()
+{
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#pragma GCC diagnostic ignored "-Wconversion"
+    srand(time(NULL) ^ getpid() ^ pthread_self());
+#pragma GCC diagnostic pop
+
+    Suite* s = suite_create("alu_table.c tests");
+
+    Add_Case(s, tc1, "ALU table arguments tests");
+    tcase_add_test(tc1, alu_table_err);
+
+    Add_Case(s, tc2, "ALU table vs. reference ALU tests");
+    tcase_set_timeout(tc2, 60);
+    tcase_add_test(tc2, alu_table_add8_sub8_exhaustive);
+    tcase_add_test(tc2, alu_table_unary_exhaustive);
+    tcase_add_test(tc2, alu_table_bcd_adjust_exhaustive);
+
+    Add_Case(s, tc3, "ALU table benchmark");
+    tcase_set_timeout(tc3, 60);
+    tcase_add_test(tc3, alu_table_benchmark);
+
+    return s;
+}
+
+TEST_SUITE(alu_table_test_suite)
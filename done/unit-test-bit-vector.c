@@ -687,6 +687,75 @@ START_TEST(bit_vector_shift_exec)
 END_TEST
 
 
+START_TEST(bit_vector_view_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    const uint32_t deadboss = PV1_DEADBOSS_VALUE;
+    bit_vector_t* pbv = bit_vector_create(PV2_SIZE * IMAGE_LINE_WORD_BITS, 0);
+    fill_vector_with(pbv, deadboss, PV2_SIZE);
+    bit_vector_t* odd = bit_vector_extract_zero_ext(pbv, 3, 45);
+    ck_assert_ptr_nonnull(odd);
+
+    // same bits as the extracted vectors, without any copy
+    const int64_t indexes[] = { -70, -33, -32, -5, 0, 1, 31, 32, 37, 64, 100 };
+    const size_t sizes[] = { 1, 17, 32, 45, 64, 96 };
+    for (size_t i = 0; i < sizeof(indexes) / sizeof(indexes[0]); ++i) {
+        for (size_t j = 0; j < sizeof(sizes) / sizeof(sizes[0]); ++j) {
+            for (bit_t type = 0; type <= 1; ++type) {
+                const bit_vector_t* bases[] = { pbv, odd };
+                for (size_t b = 0; b < 2; ++b) {
+                    const bit_vector_view_t view = bit_vector_view(type, bases[b], indexes[i], sizes[j]);
+                    ck_assert_ptr_eq(view.base, bases[b]);
+                    for (size_t k = 0; k < sizes[j]; ++k) {
+                        const int64_t n = (int64_t) bases[b]->size;
+                        const int64_t at = indexes[i] + (int64_t) k;
+                        const bit_t expected = type ? bit_vector_get(bases[b], (size_t)((at % n + n) % n))
+                                               : (at < 0 ? 0 : bit_vector_get(bases[b], (size_t) at));
+                        const uint32_t word = bit_vector_view_word(&view, k / IMAGE_LINE_WORD_BITS);
+                        ck_assert_int_eq((word >> (k % IMAGE_LINE_WORD_BITS)) & 1, expected);
+                    }
+                    if (sizes[j] % IMAGE_LINE_WORD_BITS != 0) { // nothing beyond the size
+                        const uint32_t last = bit_vector_view_word(&view, sizes[j] / IMAGE_LINE_WORD_BITS);
+                        ck_assert_int_eq(last >> (sizes[j] % IMAGE_LINE_WORD_BITS), 0);
+                    }
+                }
+            }
+        }
+    }
+
+    // materialized only on demand
+    const bit_vector_view_t shifted = bit_vector_view(0, pbv, -5, pbv->size);
+    bit_vector_t* copy = bit_vector_view_cpy(&shifted);
+    bit_vector_t* shift = bit_vector_shift(pbv, 5);
+    ck_assert_ptr_nonnull(copy);
+    vector_match_vector(copy, shift);
+
+    // logic ops reading views
+    bit_vector_t* all = bit_vector_create(pbv->size, 1);
+    ck_assert_ptr_eq(bit_vector_and_view(all, &shifted), all);
+    vector_match_vector(all, shift);
+    bit_vector_t* none = bit_vector_create(pbv->size, 0);
+    ck_assert_ptr_eq(bit_vector_or_view(none, &shifted), none);
+    vector_match_vector(none, shift);
+    const bit_vector_view_t small = bit_vector_view(0, pbv, 0, IMAGE_LINE_WORD_BITS);
+    ck_assert_ptr_null(bit_vector_or_view(none, &small));
+
+    bit_vector_free(&all);
+    bit_vector_free(&none);
+    bit_vector_free(&copy);
+    bit_vector_free(&shift);
+    bit_vector_free(&odd);
+    bit_vector_free(&pbv);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+
 
 START_TEST(bit_vector_join_exec)
 {
@@ -931,6 +1000,7 @@ Suite* cartridge_test_suite()
     tcase_add_test(tc1, bit_vector_extract_zero_exec);
     tcase_add_test(tc1, bit_vector_extract_wrap_exec);
     tcase_add_test(tc1, bit_vector_shift_exec);
+    tcase_add_test(tc1, bit_vector_view_exec);
     tcase_add_test(tc1, bit_vector_join_exec);
     tcase_add_test(tc1, bit_vector_various);
     tcase_add_test(tc1, bit_vector_deadboss);
@@ -0,0 +1,190 @@
+/**
+ * @file unit-test-bootrom.c
+ * @brief Unit test code for the boot ROM
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "tests.h"
+#include "gameboy.h"
+#include "bootrom.h"
+#include "error.h"
+#include "util.h"
+
+// placed here to prevent an include loop
+#include "cpu-storage.h"
+
+#define FIBONACCI_ROM "tests/data/fibonacci.gb"
+#define LOGO_ROM "tests/data/blargg_roms/01-special.gb"
+#define HEADER_CHECKSUM 0x014D
+
+#define INIT(gb, rom) \
+    gameboy_t* gb = calloc(1, sizeof(gameboy_t)); \
+    ck_assert_ptr_nonnull(gb); \
+    ck_assert_int_eq(gameboy_create(gb, rom), ERR_NONE)
+
+#define FREE(gb) \
+    do { \
+        gameboy_free(gb); \
+        free(gb); \
+    } while(0)
+
+/**
+ * @brief checks that a fast boot leaves a gameboy just as the boot ROM does
+ */
+static void check_fast_boot(const char* rom)
+{
+    INIT(booted, rom);
+    INIT(fast, rom);
+
+    ck_assert_int_eq(bootrom_fast_boot(fast), ERR_NONE);
+    ck_assert_int_eq(fast->boot, 0);
+    while(booted->boot) {
+        ck_assert_int_eq(gameboy_run_until(booted, booted->cycles + 1), ERR_NONE);
+    }
+    ck_assert_int_eq(booted->cycles, fast->cycles);
+
+    // CPU
+    ck_assert_int_eq(cpu_flags_sync(&(booted->cpu)), ERR_NONE);
+    ck_assert_int_eq(cpu_flags_sync(&(fast->cpu)), ERR_NONE);
+    ck_assert_int_eq(booted->cpu.A, fast->cpu.A); // F: see bootrom_fast_boot_flags
+    ck_assert_int_eq(booted->cpu.BC, fast->cpu.BC);
+    ck_assert_int_eq(booted->cpu.DE, fast->cpu.DE);
+    ck_assert_int_eq(booted->cpu.HL, fast->cpu.HL);
+    ck_assert_int_eq(booted->cpu.SP, fast->cpu.SP);
+    ck_assert_int_eq(booted->cpu.PC, fast->cpu.PC);
+    ck_assert_int_eq(booted->cpu.IME, fast->cpu.IME);
+    ck_assert_int_eq(booted->cpu.IE, fast->cpu.IE);
+    ck_assert_int_eq(booted->cpu.IF, fast->cpu.IF);
+    ck_assert_int_eq(booted->cpu.HALT, fast->cpu.HALT);
+    ck_assert_int_eq(booted->cpu.idle_time, fast->cpu.idle_time);
+    ck_assert_int_eq(booted->cpu.write_listener, fast->cpu.write_listener);
+
+    // timer and screen
+    ck_assert_int_eq(booted->timer.counter, fast->timer.counter);
+    ck_assert_int_eq(booted->screen.on, fast->screen.on);
+    ck_assert_int_eq(booted->screen.next_cycle, fast->screen.next_cycle);
+    ck_assert_int_eq(booted->screen.on_cycle, fast->screen.on_cycle);
+    ck_assert_int_eq(booted->screen.window_y, fast->screen.window_y);
+    ck_assert_int_eq(lcdc_flush(&(booted->screen)), ERR_NONE);
+    ck_assert_int_eq(lcdc_flush(&(fast->screen)), ERR_NONE);
+    for(size_t y = 0; y < LCD_HEIGHT; ++y) {
+        for(size_t x = 0; x < LCD_WIDTH; ++x) {
+            uint8_t p1 = 0;
+            uint8_t p2 = 0;
+            ck_assert_int_eq(image_get_pixel(&p1, &(booted->screen.display), x, y), ERR_NONE);
+            ck_assert_int_eq(image_get_pixel(&p2, &(fast->screen.display), x, y), ERR_NONE);
+            ck_assert_int_eq(p1, p2);
+        }
+    }
+    uint8_t lines1[LCDC_LINES_BITMAP_SIZE];
+    uint8_t lines2[LCDC_LINES_BITMAP_SIZE];
+    ck_assert_int_eq(lcdc_take_dirty_lines(&(booted->screen), lines1), ERR_NONE);
+    ck_assert_int_eq(lcdc_take_dirty_lines(&(fast->screen), lines2), ERR_NONE);
+    ck_assert_int_eq(memcmp(lines1, lines2, sizeof(lines1)), 0);
+
+    // all the memory, cartridge plugged
+    for(uint32_t a = 0; a < BUS_SIZE; ++a) {
+        ck_assert_int_eq(cpu_read_at_idx(&(booted->cpu), (addr_t) a),
+                         cpu_read_at_idx(&(fast->cpu), (addr_t) a));
+    }
+
+    FREE(booted);
+    FREE(fast);
+}
+
+START_TEST(bootrom_fast_boot_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(gb, FIBONACCI_ROM);
+
+    ck_assert_bad_param(bootrom_fast_boot(NULL));
+    ck_assert_int_eq(bootrom_fast_boot(gb), ERR_NONE);
+    ck_assert_bad_param(bootrom_fast_boot(gb)); // already booted
+
+    FREE(gb);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(bootrom_fast_boot_no_logo)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    check_fast_boot(FIBONACCI_ROM);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(bootrom_fast_boot_logo)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    check_fast_boot(LOGO_ROM);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(bootrom_fast_boot_flags)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    // header checksums, and the flags left by their check
+    static const struct {
+        data_t checksum;
+        data_t F;
+    } cases[] = {
+        { 0x00, 0x80 }, { 0x10, 0x90 }, { 0x01, 0xB0 }, { 0x66, 0xB0 }
+    };
+
+    for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        INIT(gb, FIBONACCI_ROM);
+        gb->cartridge.c.mem->memory[HEADER_CHECKSUM] = cases[i].checksum;
+
+        ck_assert_int_eq(bootrom_fast_boot(gb), ERR_NONE);
+        ck_assert_int_eq(cpu_flags_sync(&(gb->cpu)), ERR_NONE);
+        ck_assert_int_eq(gb->cpu.A, 0x01);
+        ck_assert_int_eq(gb->cpu.F, cases[i].F);
+
+        FREE(gb);
+    }
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ================================================================================
+Suite* bootrom_test_suite()
+{
+    Suite* s = suite_create("bootrom.c tests");
+
+    Add_Case(s, tc1, "Boot ROM tests");
+    tcase_add_test(tc1, bootrom_fast_boot_err);
+    tcase_add_test(tc1, bootrom_fast_boot_no_logo);
+    tcase_add_test(tc1, bootrom_fast_boot_logo);
+    tcase_add_test(tc1, bootrom_fast_boot_flags);
+
+    return s;
+}
+
+TEST_SUITE(bootrom_test_suite)
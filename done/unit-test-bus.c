@@ -210,6 +210,89 @@ START_TEST(bus_write_exec)
 END_TEST
 
 
+/**
+ * @brief read handler for the tests: the low byte of the address, plus *owner
+ */
+static int io_reader(void* owner, addr_t address, data_t* data)
+{
+    *data = (data_t)(lsb8(address) + *(const data_t*) owner);
+    return ERR_NONE;
+}
+
+START_TEST(bus_io_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+    bus_io_t io;
+    zero_init_var(io);
+    data_t data = 0;
+    data_t delta = 0;
+
+    ck_assert_bad_param(bus_io_set_reader(NULL, BUS_IO_START, io_reader, &delta));
+    ck_assert_int_eq(bus_io_set_reader(io, BUS_IO_START - 1, io_reader, &delta), ERR_ADDRESS);
+    ck_assert_int_eq(bus_io_set_reader(io, BUS_IO_END + 1, io_reader, &delta), ERR_ADDRESS);
+
+    ck_assert_bad_param(bus_io_read(bus, NULL, BUS_IO_START, &data));
+    ck_assert_int_eq(bus_io_read(bus, io, BUS_IO_END + 1, &data), ERR_ADDRESS);
+    ck_assert_int_eq(bus_io_set_reader(io, BUS_IO_START, io_reader, &delta), ERR_NONE);
+    ck_assert_bad_param(bus_io_read(bus, io, BUS_IO_START, NULL));
+
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+
+START_TEST(bus_io_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+    bus_io_t io;
+    zero_init_var(io);
+    data_t data = 0;
+    data_t delta = 3;
+    ck_assert_int_eq(component_create(&c, BUS_IO_SIZE), ERR_NONE);
+    ck_assert_int_eq(bus_plug(bus, &c, BUS_IO_START, BUS_IO_END), ERR_NONE);
+    *bus[BUS_IO_START + 4] = 0x42;
+    *bus[BUS_IO_START + 5] = 0x43;
+
+    // no handler: from the bus
+    ck_assert_int_eq(bus_io_read(bus, io, BUS_IO_START + 4, &data), ERR_NONE);
+    ck_assert_int_eq(data, 0x42);
+
+    ck_assert_int_eq(bus_io_set_reader(io, BUS_IO_START + 4, io_reader, &delta), ERR_NONE);
+    ck_assert_int_eq(bus_io_read(bus, io, BUS_IO_START + 4, &data), ERR_NONE);
+    ck_assert_int_eq(data, 0x04 + 3);
+    delta = 5; // computed at each read
+    ck_assert_int_eq(bus_io_read(bus, io, BUS_IO_START + 4, &data), ERR_NONE);
+    ck_assert_int_eq(data, 0x04 + 5);
+    ck_assert_int_eq(*bus[BUS_IO_START + 4], 0x42);
+
+    // others untouched
+    ck_assert_int_eq(bus_io_read(bus, io, BUS_IO_START + 5, &data), ERR_NONE);
+    ck_assert_int_eq(data, 0x43);
+
+    ck_assert_int_eq(bus_io_set_reader(io, BUS_IO_START + 4, NULL, &delta), ERR_NONE);
+    ck_assert_ptr_null(io[4].owner);
+    ck_assert_int_eq(bus_io_read(bus, io, BUS_IO_START + 4, &data), ERR_NONE);
+    ck_assert_int_eq(data, 0x42);
+
+    component_free(&c);
+
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+
 Suite* bus_test_suite()
 {
 #pragma GCC diagnostic push
@@ -231,6 +314,9 @@ Suite* bus_test_suite()
     tcase_add_test(tc3, bus_write_err);
     tcase_add_test(tc3, bus_write_exec);
 
+    tcase_add_test(tc3, bus_io_err);
+    tcase_add_test(tc3, bus_io_exec);
+
     return s;
 }
 
@@ -33,7 +33,8 @@
 
 #define DO_RUN(cpu, ...) \
     instruction_t lu = __VA_ARGS__; \
-    ck_assert_int_eq(cpu_dispatch(&lu, &cpu), ERR_NONE)
+    ck_assert_int_eq(cpu_dispatch(&lu, &cpu), ERR_NONE); \
+    ck_assert_int_eq(cpu_flags_sync(&cpu), ERR_NONE)
 
 #define RUN_FOR_REG(cpu, reg, ...) \
     cpu_reg_set(&cpu, reg, dt[i_]);\
@@ -0,0 +1,201 @@
+/**
+ * @file unit-test-frame-stream.c
+ * @brief Unit test code for the frame stream of the headless mode
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tests.h"
+#include "frame_stream.h"
+#include "error.h"
+
+#define NB_FRAMES 3
+#define RAW_FRAME_SIZE (FRAME_PIXELS / 4)
+#define PGM_HEADER "P5\n160 144\n255\n"
+#define Y4M_HEADER "YUV4MPEG2 W160 H144 F1048576:17556 Ip A1:1 Cmono\n"
+
+/**
+ * @brief a Game Boy screen with its 32 first pixels in color 2
+ */
+#define INIT \
+    image_t display; \
+    ck_assert_int_eq(image_create(&display, LCD_WIDTH, LCD_HEIGHT), ERR_NONE); \
+    ck_assert_int_eq(image_line_set_word(&display.content[0], 0, 0xFFFFFFFF, 0), ERR_NONE); \
+    char filename[64]; \
+    snprintf(filename, sizeof(filename), "/tmp/unit-test-frame-stream-%d", (int) getpid())
+
+#define FREE \
+    image_free(&display)
+
+/**
+ * @brief writes NB_FRAMES frames of display to a stream
+ */
+#define write_frames(name, format) \
+    do { \
+        frame_stream_t stream; \
+        ck_assert_int_eq(frame_stream_open(&stream, name, format), ERR_NONE); \
+        for (int i = 0; i < NB_FRAMES; ++i) { \
+            ck_assert_int_eq(frame_stream_push(&stream, &display), ERR_NONE); \
+        } \
+        ck_assert_int_eq(frame_stream_close(&stream), ERR_NONE); \
+    } while(0)
+
+/**
+ * @brief reads a whole (small) file into buf, and gives its size
+ */
+static size_t read_file(const char* name, uint8_t* buf, size_t max)
+{
+    FILE* in = fopen(name, "rb");
+    ck_assert_ptr_nonnull(in);
+    const size_t size = fread(buf, 1, max, in);
+    fclose(in);
+    return size;
+}
+
+static uint8_t buf[NB_FRAMES * (FRAME_PIXELS + 64) + 128];
+
+START_TEST(frame_stream_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    frame_format_t format = FRAME_RAW;
+    ck_assert_bad_param(frame_format_parse(NULL, &format));
+    ck_assert_bad_param(frame_format_parse("raw", NULL));
+    ck_assert_bad_param(frame_format_parse("gif", &format));
+    ck_assert_bad_param(frame_format_parse("ppm", &format));
+    ck_assert_int_eq(frame_format_parse("pgm", &format), ERR_NONE);
+    ck_assert_int_eq(format, FRAME_PGM);
+
+    frame_stream_t stream;
+    ck_assert_bad_param(frame_stream_open(NULL, "-", FRAME_RAW));
+    ck_assert_bad_param(frame_stream_open(&stream, NULL, FRAME_RAW));
+    ck_assert_bad_param(frame_stream_open(&stream, "-", NB_FRAME_FORMATS));
+    ck_assert_int_eq(frame_stream_open(&stream, "/nonexistent/dir/out", FRAME_RAW), ERR_IO);
+
+    // file name patterns holding anything but one conversion of the frame number
+    static const char* const patterns[] = {
+        "f%s.pgm", "%n", "f%lu-%lu.pgm", "f%%%lu.pgm", "f%lu%.pgm", "f%-5lu.pgm", "f%x.pgm",
+        "f%.2lu.pgm", "f%lld.pgm", "f%99999999999lu.pgm", "f%"
+    };
+    for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); ++i) {
+        ck_assert_bad_param(frame_stream_open(&stream, patterns[i], FRAME_PGM));
+    }
+    ck_assert_bad_param(frame_stream_push(NULL, NULL));
+    ck_assert_bad_param(frame_stream_close(NULL));
+
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(frame_stream_raw)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    write_frames(filename, FRAME_RAW);
+    ck_assert_int_eq(read_file(filename, buf, sizeof(buf)), NB_FRAMES * RAW_FRAME_SIZE);
+    for (int i = 0; i < NB_FRAMES; ++i) {
+        const uint8_t* frame = buf + i * RAW_FRAME_SIZE;
+        ck_assert_int_eq(frame[0], 0xAA);
+        ck_assert_int_eq(frame[7], 0xAA);
+        ck_assert_int_eq(frame[8], 0x00);
+        ck_assert_int_eq(frame[RAW_FRAME_SIZE - 1], 0x00);
+    }
+    remove(filename);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(frame_stream_pgm)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    // concatenated frames
+    write_frames(filename, FRAME_PGM);
+    const size_t frame_size = strlen(PGM_HEADER) + FRAME_PIXELS;
+    ck_assert_int_eq(read_file(filename, buf, sizeof(buf)), NB_FRAMES * frame_size);
+    ck_assert_mem_eq(buf + frame_size, PGM_HEADER, strlen(PGM_HEADER));
+    ck_assert_int_eq(buf[frame_size + strlen(PGM_HEADER)], 85);
+    ck_assert_int_eq(buf[frame_size + strlen(PGM_HEADER) + 32], 255);
+    remove(filename);
+
+    // one file per frame
+    char pattern[80];
+    snprintf(pattern, sizeof(pattern), "%s-%%03lu.pgm", filename);
+    write_frames(pattern, FRAME_PGM);
+    for (unsigned long i = 0; i < NB_FRAMES; ++i) {
+        char name[96];
+        snprintf(name, sizeof(name), "%s-00%lu.pgm", filename, i);
+        ck_assert_int_eq(read_file(name, buf, sizeof(buf)), frame_size);
+        ck_assert_mem_eq(buf, PGM_HEADER, strlen(PGM_HEADER));
+        remove(name);
+    }
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(frame_stream_y4m)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    write_frames(filename, FRAME_Y4M);
+    const size_t frame_size = strlen("FRAME\n") + FRAME_PIXELS;
+    ck_assert_int_eq(read_file(filename, buf, sizeof(buf)), strlen(Y4M_HEADER) + NB_FRAMES * frame_size);
+    ck_assert_mem_eq(buf, Y4M_HEADER, strlen(Y4M_HEADER));
+    const uint8_t* last = buf + strlen(Y4M_HEADER) + (NB_FRAMES - 1) * frame_size;
+    ck_assert_mem_eq(last, "FRAME\n", strlen("FRAME\n"));
+    ck_assert_int_eq(last[strlen("FRAME\n")], 85);
+    ck_assert_int_eq(last[frame_size - 1], 255);
+    remove(filename);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ================================================================================
+Suite* frame_stream_test_suite()
+{
+    Suite* s = suite_create("frame_stream.c tests");
+
+    Add_Case(s, tc1, "Frame stream tests");
+    tcase_add_test(tc1, frame_stream_err);
+    tcase_add_test(tc1, frame_stream_raw);
+    tcase_add_test(tc1, frame_stream_pgm);
+    tcase_add_test(tc1, frame_stream_y4m);
+
+    return s;
+}
+
+TEST_SUITE(frame_stream_test_suite)
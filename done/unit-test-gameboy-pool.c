@@ -0,0 +1,370 @@
+/**
+ * @file unit-test-gameboy-pool.c
+ * @brief Unit test code for the memory, the reset, the clones and copies of the gameboys,
+ *        and their pools
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+#include "gameboy.h"
+#include "gameboy_pool.h"
+#include "bootrom.h"
+#include "error.h"
+#include "util.h"
+
+// placed here to prevent an include loop
+#include "cpu-storage.h"
+
+#define ROM "tests/data/blargg_roms/01-special.gb"
+
+// after the boot, into the test
+#define RUN_CYCLES 2500000
+
+// where Tetris writes, to select a ROM bank
+#define ROM_WRITE_ADDR 0x2000
+
+#define INIT(gb) \
+    gameboy_t* gb = calloc(1, sizeof(gameboy_t)); \
+    ck_assert_ptr_nonnull(gb); \
+    ck_assert_int_eq(gameboy_create(gb, ROM), ERR_NONE)
+
+#define FREE(gb) \
+    do { \
+        gameboy_free(gb); \
+        free(gb); \
+    } while(0)
+
+/**
+ * @brief checks that two gameboys are in the same state
+ */
+static void check_same(gameboy_t* gb1, gameboy_t* gb2)
+{
+    ck_assert_int_eq(gb1->cycles, gb2->cycles);
+    ck_assert_int_eq(gb1->boot, gb2->boot);
+
+    ck_assert_int_eq(cpu_flags_sync(&(gb1->cpu)), ERR_NONE);
+    ck_assert_int_eq(cpu_flags_sync(&(gb2->cpu)), ERR_NONE);
+    ck_assert_int_eq(gb1->cpu.AF, gb2->cpu.AF);
+    ck_assert_int_eq(gb1->cpu.BC, gb2->cpu.BC);
+    ck_assert_int_eq(gb1->cpu.DE, gb2->cpu.DE);
+    ck_assert_int_eq(gb1->cpu.HL, gb2->cpu.HL);
+    ck_assert_int_eq(gb1->cpu.SP, gb2->cpu.SP);
+    ck_assert_int_eq(gb1->cpu.PC, gb2->cpu.PC);
+    ck_assert_int_eq(gb1->cpu.IME, gb2->cpu.IME);
+    ck_assert_int_eq(gb1->cpu.HALT, gb2->cpu.HALT);
+    ck_assert_int_eq(gb1->cpu.idle_time, gb2->cpu.idle_time);
+    ck_assert_int_eq(gb1->timer.counter, gb2->timer.counter);
+    ck_assert_int_eq(gb1->screen.next_cycle, gb2->screen.next_cycle);
+
+    for(uint32_t a = 0; a < BUS_SIZE; ++a) {
+        ck_assert_int_eq(cpu_read_at_idx(&(gb1->cpu), (addr_t) a),
+                         cpu_read_at_idx(&(gb2->cpu), (addr_t) a));
+    }
+
+    ck_assert_int_eq(lcdc_flush(&(gb1->screen)), ERR_NONE);
+    ck_assert_int_eq(lcdc_flush(&(gb2->screen)), ERR_NONE);
+    for(size_t y = 0; y < LCD_HEIGHT; ++y) {
+        for(size_t x = 0; x < LCD_WIDTH; ++x) {
+            uint8_t p1 = 0;
+            uint8_t p2 = 0;
+            ck_assert_int_eq(image_get_pixel(&p1, &(gb1->screen.display), x, y), ERR_NONE);
+            ck_assert_int_eq(image_get_pixel(&p2, &(gb2->screen.display), x, y), ERR_NONE);
+            ck_assert_int_eq(p1, p2);
+        }
+    }
+}
+
+START_TEST(gameboy_arena_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(gb);
+
+    ck_assert_ptr_nonnull(gb->arena);
+    ck_assert_int_eq((uintptr_t) gb->arena % GB_ARENA_ALIGNMENT, 0);
+
+    // everything but the cartridge, echo RAM and the CPU registers, at its address
+    for(uint32_t a = GB_ARENA_START; a < BUS_SIZE; ++a) {
+        if(a == REG_IF || a == REG_IE) {
+            continue;
+        }
+        const addr_t mirror = (addr_t)(a >= ECHO_RAM_START && a <= ECHO_RAM_END
+                                       ? a - ECHO_RAM_START + WORK_RAM_START : a);
+        ck_assert_ptr_eq(gb->bus[a], gb->arena + GB_ARENA_OFFSET(mirror));
+    }
+    for(uint32_t a = BOOT_ROM_START; a <= BOOT_ROM_END; ++a) {
+        ck_assert_ptr_eq(gb->bus[a], gb->arena + GB_ARENA_OFFSET(GB_ARENA_BOOT_ROM) + a);
+    }
+
+    FREE(gb);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_reset_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(fresh);
+    INIT(used);
+
+    ck_assert_bad_param(gameboy_reset(NULL));
+
+    // reset in the middle of the boot...
+    ck_assert_int_eq(gameboy_run_until(used, 1000), ERR_NONE);
+    ck_assert_int_eq(gameboy_reset(used), ERR_NONE);
+    check_same(fresh, used);
+
+    // ...and after it (fast boots included), its ROM written to
+    ck_assert_int_eq(bootrom_fast_boot(used), ERR_NONE);
+    ck_assert_int_eq(gameboy_run_until(used, RUN_CYCLES), ERR_NONE);
+    ck_assert_int_eq(cpu_write_at_idx(&(used->cpu), ROM_WRITE_ADDR,
+                                      (data_t) ~cpu_read_at_idx(&(used->cpu), ROM_WRITE_ADDR)), ERR_NONE);
+    ck_assert_int_eq(gameboy_reset(used), ERR_NONE);
+    check_same(fresh, used);
+
+    ck_assert_int_eq(gameboy_run_until(fresh, RUN_CYCLES), ERR_NONE);
+    ck_assert_int_eq(gameboy_run_until(used, RUN_CYCLES), ERR_NONE);
+    ck_assert_int_eq(fresh->boot, 0);
+    check_same(fresh, used);
+
+    FREE(fresh);
+    FREE(used);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_create_from_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(model);
+
+    gameboy_t* copy = calloc(1, sizeof(gameboy_t));
+    ck_assert_ptr_nonnull(copy);
+    ck_assert_bad_param(gameboy_create_from(NULL, &(model->cartridge)));
+    ck_assert_bad_param(gameboy_create_from(copy, NULL));
+    ck_assert_int_eq(gameboy_create_from(copy, &(model->cartridge)), ERR_NONE);
+    ck_assert_ptr_eq(copy->cartridge.c.mem, model->cartridge.c.mem);
+    check_same(model, copy);
+
+    FREE(model);
+    FREE(copy);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_clone_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(model);
+    INIT(reference);
+    gameboy_t* clone1 = calloc(1, sizeof(gameboy_t));
+    gameboy_t* clone2 = calloc(1, sizeof(gameboy_t));
+    ck_assert_ptr_nonnull(clone1);
+    ck_assert_ptr_nonnull(clone2);
+
+    ck_assert_bad_param(gameboy_clone(NULL, clone1));
+    ck_assert_bad_param(gameboy_clone(model, NULL));
+    ck_assert_bad_param(gameboy_clone(model, model));
+
+    // a clone failing frees what it set up only, whatever its gameboy held
+    gameboy_t* broken = calloc(1, sizeof(gameboy_t));
+    ck_assert_ptr_nonnull(broken);
+    broken->arena = model->arena; // but no ROM to share
+    memset(clone1, 0xA5, sizeof(gameboy_t));
+    ck_assert_bad_param(gameboy_clone(broken, clone1));
+    ck_assert_ptr_null(clone1->arena);
+    free(broken);
+
+    // during the boot...
+    ck_assert_int_eq(gameboy_run_until(model, 1000), ERR_NONE);
+    ck_assert_int_eq(gameboy_run_until(reference, 1000), ERR_NONE);
+    ck_assert_int_eq(gameboy_clone(model, clone1), ERR_NONE);
+    ck_assert_ptr_eq(clone1->cartridge.c.mem, model->cartridge.c.mem);
+    check_same(model, clone1);
+
+    ck_assert_int_eq(gameboy_run_until(model, RUN_CYCLES), ERR_NONE);
+    ck_assert_int_eq(gameboy_run_until(clone1, RUN_CYCLES), ERR_NONE);
+    ck_assert_int_eq(gameboy_run_until(reference, RUN_CYCLES), ERR_NONE);
+    ck_assert_int_eq(clone1->boot, 0);
+    check_same(reference, clone1);
+
+    // ...and after it
+    ck_assert_int_eq(gameboy_clone(model, clone2), ERR_NONE);
+#ifdef DEFERRED_RENDER
+    ck_assert(!clone2->screen.started); // no drawing threads until drawn
+#endif
+    check_same(model, clone2);
+#ifdef DEFERRED_RENDER
+    ck_assert(clone2->screen.started);
+#endif
+
+    // none of them writes into the memory of the other
+    const data_t data = cpu_read_at_idx(&(model->cpu), WORK_RAM_START);
+    ck_assert_int_eq(cpu_write_at_idx(&(model->cpu), WORK_RAM_START, (data_t) ~data), ERR_NONE);
+    ck_assert_int_eq(cpu_read_at_idx(&(clone2->cpu), WORK_RAM_START), data);
+
+    // nor into their shared ROM (as a Tetris write to 0x2000 would)
+    const data_t rom = cpu_read_at_idx(&(clone2->cpu), ROM_WRITE_ADDR);
+    ck_assert_int_eq(cpu_write_at_idx(&(model->cpu), ROM_WRITE_ADDR, (data_t) ~rom), ERR_NONE);
+    ck_assert_int_eq(cpu_write16_at_idx(&(model->cpu), BANK_ROM_SIZE - 1, 0xABCD), ERR_NONE);
+    ck_assert_int_eq(cpu_read_at_idx(&(model->cpu), ROM_WRITE_ADDR), rom);
+    ck_assert_int_eq(cpu_read_at_idx(&(clone2->cpu), ROM_WRITE_ADDR), rom);
+    ck_assert_int_eq(cpu_read_at_idx(&(clone2->cpu), BANK_ROM_SIZE - 1),
+                     cpu_read_at_idx(&(reference->cpu), BANK_ROM_SIZE - 1));
+    ck_assert_int_eq(cpu_read_at_idx(&(model->cpu), BANK_ROM_SIZE), 0xAB); // video RAM
+
+    // nor needs it (the ROM staying for the clones)
+    FREE(model);
+    ck_assert_int_eq(gameboy_run_until(clone1, 2 * RUN_CYCLES), ERR_NONE);
+    ck_assert_int_eq(gameboy_run_until(clone2, 2 * RUN_CYCLES), ERR_NONE);
+    ck_assert_int_eq(gameboy_run_until(reference, 2 * RUN_CYCLES), ERR_NONE);
+    check_same(reference, clone1);
+    check_same(reference, clone2);
+
+    FREE(clone1);
+    FREE(clone2);
+    FREE(reference);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_copy_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(model);
+    INIT(other); // same ROM, read on its own
+    gameboy_t* copy = calloc(1, sizeof(gameboy_t));
+    ck_assert_ptr_nonnull(copy);
+
+    ck_assert_bad_param(gameboy_copy(NULL, model));
+    ck_assert_bad_param(gameboy_copy(model, NULL));
+    ck_assert_bad_param(gameboy_copy(other, model));
+    ck_assert_int_eq(gameboy_copy(model, model), ERR_NONE);
+
+    // after the boot, onto the boot (the boot ROM plugged back)...
+    ck_assert_int_eq(gameboy_clone(model, copy), ERR_NONE);
+    ck_assert_int_eq(gameboy_run_until(model, 1000), ERR_NONE);
+    ck_assert_int_eq(gameboy_run_until(copy, RUN_CYCLES), ERR_NONE);
+    ck_assert_int_eq(copy->boot, 0);
+    ck_assert_int_eq(gameboy_copy(copy, model), ERR_NONE);
+    check_same(model, copy);
+
+    ck_assert_int_eq(gameboy_run_until(model, RUN_CYCLES), ERR_NONE);
+    ck_assert_int_eq(gameboy_run_until(copy, RUN_CYCLES), ERR_NONE);
+    ck_assert_int_eq(model->boot, 0);
+    check_same(model, copy);
+
+    // ...and back (the cartridge plugged back)
+    ck_assert_int_eq(gameboy_reset(copy), ERR_NONE);
+    ck_assert_int_eq(gameboy_copy(copy, model), ERR_NONE);
+    check_same(model, copy);
+    ck_assert_int_eq(gameboy_run_until(model, 2 * RUN_CYCLES), ERR_NONE);
+    ck_assert_int_eq(gameboy_run_until(copy, 2 * RUN_CYCLES), ERR_NONE);
+    check_same(model, copy);
+
+    FREE(model);
+    FREE(other);
+    FREE(copy);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_pool_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(fresh);
+    gameboy_pool_t pool;
+    zero_init_var(pool);
+
+    ck_assert_bad_param(gameboy_pool_create(NULL, ROM, 2));
+    ck_assert_bad_param(gameboy_pool_create(&pool, NULL, 2));
+    ck_assert_bad_param(gameboy_pool_create(&pool, ROM, 0));
+    ck_assert_ptr_null(gameboy_pool_acquire(NULL));
+    ck_assert_int_eq(gameboy_pool_create(&pool, ROM, 2), ERR_NONE);
+
+    gameboy_t* gb1 = gameboy_pool_acquire(&pool);
+    gameboy_t* gb2 = gameboy_pool_acquire(&pool);
+    ck_assert_ptr_nonnull(gb1);
+    ck_assert_ptr_nonnull(gb2);
+    ck_assert_ptr_ne(gb1, gb2);
+    ck_assert_ptr_null(gameboy_pool_acquire(&pool));
+    check_same(fresh, gb2);
+
+    // given back at its power-on state
+    ck_assert_int_eq(gameboy_run_until(gb1, 100000), ERR_NONE);
+    ck_assert_int_eq(gameboy_pool_release(&pool, gb1), ERR_NONE);
+    ck_assert_bad_param(gameboy_pool_release(&pool, gb1));
+    ck_assert_bad_param(gameboy_pool_release(&pool, fresh));
+    ck_assert_bad_param(gameboy_pool_release(NULL, gb2));
+    ck_assert_ptr_eq(gameboy_pool_acquire(&pool), gb1);
+    check_same(fresh, gb1);
+
+    // not given back if it cannot be reset
+    memory_t* const mem = gb2->components[0].mem;
+    gb2->components[0].mem = NULL;
+    ck_assert_bad_param(gameboy_pool_release(&pool, gb2));
+    gb2->components[0].mem = mem;
+    ck_assert_int_eq(gameboy_pool_release(&pool, gb1), ERR_NONE);
+    ck_assert_ptr_eq(gameboy_pool_acquire(&pool), gb1);
+    ck_assert_ptr_null(gameboy_pool_acquire(&pool));
+    ck_assert_int_eq(gameboy_pool_release(&pool, gb2), ERR_NONE);
+    ck_assert_ptr_eq(gameboy_pool_acquire(&pool), gb2);
+
+    gameboy_pool_free(&pool);
+    FREE(fresh);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ================================================================================
+Suite* gameboy_pool_test_suite()
+{
+    Suite* s = suite_create("gameboy_pool.c tests");
+
+    Add_Case(s, tc1, "Gameboy memory, reset, clone, copy and pool tests");
+    tcase_add_test(tc1, gameboy_arena_exec);
+    tcase_add_test(tc1, gameboy_reset_exec);
+    tcase_add_test(tc1, gameboy_create_from_exec);
+    tcase_add_test(tc1, gameboy_clone_exec);
+    tcase_add_test(tc1, gameboy_copy_exec);
+    tcase_add_test(tc1, gameboy_pool_exec);
+
+    return s;
+}
+
+TEST_SUITE(gameboy_pool_test_suite)
@@ -0,0 +1,454 @@
+/**
+ * @file unit-test-gameboy.c
+ * @brief Unit test code for running a gameboy, until a cycle or a condition
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+#include "gameboy.h"
+#include "bootrom.h"
+#include "error.h"
+#include "util.h"
+
+// placed here to prevent an include loop
+#include "cpu-storage.h"
+
+#define ROM "tests/data/blargg_roms/01-special.gb"
+
+// after the boot, into the test
+#define RUN_CYCLES 2500000
+
+// the test ROM sends its name, then its result
+#define ROM_NAME "01-special"
+#define ROM_RESULT "Passed"
+#define ROM_END_CYCLES 5000000
+
+// first instruction of the cartridge
+#define CARTRIDGE_ENTRY 0x0100
+
+#define OAM_SIZE (GRAPH_RAM_END - GRAPH_RAM_START + 1)
+#define DMA_SOURCE 0xC100
+
+#define INIT(gb) \
+    gameboy_t* gb = calloc(1, sizeof(gameboy_t)); \
+    ck_assert_ptr_nonnull(gb); \
+    ck_assert_int_eq(gameboy_create(gb, ROM), ERR_NONE)
+
+#define FREE(gb) \
+    do { \
+        gameboy_free(gb); \
+        free(gb); \
+    } while(0)
+
+#define INIT_UNTIL(until, last) \
+    gameboy_until_t until; \
+    zero_init_var(until); \
+    until.cycle = last
+
+/**
+ * @brief whether the CPU of a gameboy is about to run the instruction at pc
+ */
+static int at_pc(const gameboy_t* gb, addr_t pc)
+{
+    return gb->cpu.PC == pc && gb->cpu.idle_time == 0 && !gb->cpu.HALT;
+}
+
+START_TEST(gameboy_run_until_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    for(int t = 0; t < NB_GB_TIMINGS; ++t) {
+        INIT(gb);
+        ck_assert_int_eq(gameboy_set_timing(gb, (gameboy_timing_t) t), ERR_NONE);
+
+        ck_assert_bad_param(gameboy_run_until(NULL, 1000));
+
+        // until an absolute cycle
+        ck_assert_int_eq(gameboy_run_until(gb, 1000), ERR_NONE);
+        ck_assert_int_eq(gb->cycles, 1000);
+        ck_assert_int_eq(gameboy_run_until(gb, 1000), ERR_NONE);
+        ck_assert_int_eq(gb->cycles, 1000);
+        ck_assert_int_eq(gameboy_run_until(gb, 500), ERR_NONE);
+        ck_assert_int_eq(gb->cycles, 1000);
+        ck_assert_int_eq(gameboy_run_until(gb, 1001), ERR_NONE);
+        ck_assert_int_eq(gb->cycles, 1001);
+
+        FREE(gb);
+    }
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_run_to_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(gb);
+    INIT_UNTIL(until, 1000);
+
+    ck_assert_bad_param(gameboy_run_to(NULL, &until, NULL));
+    ck_assert_bad_param(gameboy_run_to(gb, NULL, NULL));
+
+    until.conditions = GB_UNTIL_ALL + 1;
+    ck_assert_bad_param(gameboy_run_to(gb, &until, NULL));
+
+    until.conditions = GB_UNTIL_SERIAL;
+    ck_assert_bad_param(gameboy_run_to(gb, &until, NULL));
+    until.serial = "";
+    ck_assert_bad_param(gameboy_run_to(gb, &until, NULL));
+    ck_assert_int_eq(gb->cycles, 0);
+
+    FREE(gb);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_run_to_cycle_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(gb);
+    INIT_UNTIL(until, 1000);
+    gameboy_until_flag_t reached = 0;
+
+    // nothing met before
+    until.conditions = GB_UNTIL_PC;
+    until.pc = CARTRIDGE_ENTRY;
+    ck_assert_int_eq(gameboy_run_to(gb, &until, &reached), ERR_NONE);
+    ck_assert_int_eq(reached, GB_UNTIL_CYCLE);
+    ck_assert_int_eq(gb->cycles, 1000);
+
+    ck_assert_int_eq(gameboy_run_to(gb, &until, NULL), ERR_NONE);
+    ck_assert_int_eq(gb->cycles, 1000);
+
+    FREE(gb);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_run_to_pc_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(gb);
+    INIT(reference);
+    INIT_UNTIL(until, UINT64_MAX);
+    gameboy_until_flag_t reached = 0;
+
+    // at the first cycle the boot ROM is done with
+    until.conditions = GB_UNTIL_PC;
+    until.pc = CARTRIDGE_ENTRY;
+    ck_assert_int_eq(gameboy_run_to(gb, &until, &reached), ERR_NONE);
+    ck_assert_int_eq(reached, GB_UNTIL_PC);
+    ck_assert(at_pc(gb, CARTRIDGE_ENTRY));
+    ck_assert_int_eq(gb->boot, 0);
+
+    while(!at_pc(reference, CARTRIDGE_ENTRY)) {
+        ck_assert_int_eq(gameboy_run_until(reference, reference->cycles + 1), ERR_NONE);
+    }
+    ck_assert_int_eq(reference->cycles, gb->cycles);
+
+    // going on from it
+    until.cycle = gb->cycles + 1000;
+    ck_assert_int_eq(gameboy_run_to(gb, &until, &reached), ERR_NONE);
+    ck_assert_int_eq(reached, GB_UNTIL_CYCLE);
+
+    // the same in the line mode
+    FREE(reference);
+    INIT(line);
+    ck_assert_int_eq(gameboy_set_timing(line, GB_TIMING_LINE), ERR_NONE);
+    until.cycle = UINT64_MAX;
+    ck_assert_int_eq(gameboy_run_to(line, &until, &reached), ERR_NONE);
+    ck_assert_int_eq(reached, GB_UNTIL_PC);
+    ck_assert(at_pc(line, CARTRIDGE_ENTRY));
+    ck_assert_int_eq(line->boot, 0);
+
+    FREE(gb);
+    FREE(line);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_run_to_memory_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(gb);
+    INIT(reference);
+    INIT_UNTIL(until, UINT64_MAX);
+    gameboy_until_flag_t reached = 0;
+
+    // first vertical blank
+    until.conditions = GB_UNTIL_MEMORY;
+    until.address = REG_LY;
+    until.mask = 0xFF;
+    until.value = LCD_HEIGHT;
+    ck_assert_int_eq(gameboy_run_to(gb, &until, &reached), ERR_NONE);
+    ck_assert_int_eq(reached, GB_UNTIL_MEMORY);
+    ck_assert_int_eq(cpu_read_at_idx(&(gb->cpu), REG_LY), LCD_HEIGHT);
+
+    while(cpu_read_at_idx(&(reference->cpu), REG_LY) != LCD_HEIGHT) {
+        ck_assert_int_eq(gameboy_run_until(reference, reference->cycles + 1), ERR_NONE);
+    }
+    ck_assert_int_eq(reference->cycles, gb->cycles);
+
+    // a bit only: LY odd
+    until.mask = 0x01;
+    until.value = 0x01;
+    ck_assert_int_eq(gameboy_run_to(gb, &until, &reached), ERR_NONE);
+    ck_assert_int_eq(reached, GB_UNTIL_MEMORY);
+    ck_assert_int_eq(cpu_read_at_idx(&(gb->cpu), REG_LY), LCD_HEIGHT + 1);
+
+    FREE(gb);
+    FREE(reference);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_run_to_frames_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    for(int t = 0; t < NB_GB_TIMINGS; ++t) {
+        INIT(gb);
+        ck_assert_int_eq(gameboy_set_timing(gb, (gameboy_timing_t) t), ERR_NONE);
+        INIT_UNTIL(until, UINT64_MAX);
+        gameboy_until_flag_t reached = 0;
+
+        ck_assert_int_eq(gameboy_run_until(gb, RUN_CYCLES), ERR_NONE);
+        const uint64_t frames = gb->screen.frames;
+        ck_assert_int_gt(frames, 0);
+
+        until.conditions = GB_UNTIL_FRAMES;
+        until.frames = 3;
+        ck_assert_int_eq(gameboy_run_to(gb, &until, &reached), ERR_NONE);
+        ck_assert_int_eq(reached, GB_UNTIL_FRAMES);
+        ck_assert_int_eq(gb->screen.frames, frames + 3);
+        ck_assert_int_eq(cpu_read_at_idx(&(gb->cpu), REG_LY), LCD_HEIGHT);
+
+        FREE(gb);
+    }
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_run_to_serial_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    for(int t = 0; t < NB_GB_TIMINGS; ++t) {
+        INIT(gb);
+        ck_assert_int_eq(gameboy_set_timing(gb, (gameboy_timing_t) t), ERR_NONE);
+        INIT_UNTIL(until, ROM_END_CYCLES);
+        gameboy_until_flag_t reached = 0;
+        size_t length = 0;
+
+        until.conditions = GB_UNTIL_SERIAL;
+        until.serial = ROM_NAME;
+        ck_assert_int_eq(gameboy_run_to(gb, &until, &reached), ERR_NONE);
+        ck_assert_int_eq(reached, GB_UNTIL_SERIAL);
+        ck_assert_str_eq(serial_output(&(gb->serial), &length), ROM_NAME);
+
+        // only in the bytes sent from then on
+        until.serial = "0";
+        until.conditions = GB_UNTIL_SERIAL | GB_UNTIL_FRAMES;
+        until.frames = UINT64_MAX / 2;
+        ck_assert_int_eq(gameboy_run_to(gb, &until, &reached), ERR_NONE);
+        ck_assert_int_eq(reached, GB_UNTIL_CYCLE);
+
+        FREE(gb);
+    }
+
+    INIT(gb);
+    INIT_UNTIL(until, ROM_END_CYCLES);
+    gameboy_until_flag_t reached = 0;
+    until.conditions = GB_UNTIL_SERIAL;
+    until.serial = ROM_RESULT "\n";
+    ck_assert_int_eq(gameboy_run_to(gb, &until, &reached), ERR_NONE);
+    ck_assert_int_eq(reached, GB_UNTIL_SERIAL);
+    ck_assert_str_eq(serial_output(&(gb->serial), NULL), ROM_NAME "\n\n\n" ROM_RESULT "\n");
+    ck_assert_int_lt(gb->cycles, ROM_END_CYCLES);
+    FREE(gb);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_line_timer_write_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    // in the work RAM: waits, starts the timer, waits, clears TIMA, loops
+    static const data_t program[] = {
+        0x06, 0x14,       // LD B, 20
+        0x05,             // DEC B
+        0x20, 0xFD,       // JR NZ, -3
+        0x3E, 0x05,       // LD A, 0x05
+        0xE0, 0x07,       // LDH (TAC), A: in the middle of the first line
+        0x06, 0x14,       // LD B, 20
+        0x05,             // DEC B
+        0x20, 0xFD,       // JR NZ, -3
+        0xAF,             // XOR A
+        0xE0, 0x05,       // LDH (TIMA), A: in the middle of the second line
+        0x18, 0xFE        // JR -2
+    };
+
+    gameboy_t* gbs[NB_GB_TIMINGS] = { NULL };
+    for(int t = 0; t < NB_GB_TIMINGS; ++t) {
+        INIT(gb);
+        gbs[t] = gb;
+        ck_assert_int_eq(gameboy_set_timing(gb, (gameboy_timing_t) t), ERR_NONE);
+        ck_assert_int_eq(bootrom_fast_boot(gb), ERR_NONE);
+        for(addr_t i = 0; i < sizeof(program); ++i) {
+            ck_assert_int_eq(cpu_write_at_idx(&(gb->cpu), (addr_t)(WORK_RAM_START + i), program[i]), ERR_NONE);
+        }
+        ck_assert_int_eq(cpu_write_at_idx(&(gb->cpu), REG_TIMA, 0x80), ERR_NONE);
+        ck_assert_int_eq(cpu_write_at_idx(&(gb->cpu), REG_TAC, 0x00), ERR_NONE);
+        gb->cpu.write_listener = 0;
+        gb->cpu.idle_time = 0;
+        gb->cpu.PC = WORK_RAM_START;
+    }
+
+    // the timer is caught up at the end of each line
+    for(int l = 0; l < 3; ++l) {
+        for(int t = 0; t < NB_GB_TIMINGS; ++t) {
+            ck_assert_int_eq(gameboy_run_until(gbs[t], gbs[t]->cycles + LINE_TOTAL_CYCLES), ERR_NONE);
+        }
+        const gameboy_t* const exact = gbs[GB_TIMING_EXACT];
+        const gameboy_t* const line = gbs[GB_TIMING_LINE];
+        ck_assert_int_eq(line->timer.counter, exact->timer.counter);
+        ck_assert_int_eq(cpu_read_at_idx(&(line->cpu), REG_TIMA), cpu_read_at_idx(&(exact->cpu), REG_TIMA));
+        ck_assert_int_eq(cpu_read_at_idx(&(line->cpu), REG_TAC), 0x05);
+        ck_assert_int_eq(line->cpu.IF, exact->cpu.IF);
+    }
+    // the ticks before each write not applied after it
+    ck_assert_int_lt(cpu_read_at_idx(&(gbs[GB_TIMING_LINE]->cpu), REG_TIMA), 0x80);
+
+    for(int t = 0; t < NB_GB_TIMINGS; ++t) {
+        FREE(gbs[t]);
+    }
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gameboy_dma_lockout_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    // in the work RAM: calls the DMA routine, with the stack in the work RAM too
+    static const data_t program[] = {
+        0x31, 0xFF, 0xDF, // LD SP, 0xDFFF
+        0xCD, 0x80, 0xFF, // CALL 0xFF80
+        0x18, 0xFE        // JR -2
+    };
+    const addr_t end = WORK_RAM_START + 6;
+    // in the high RAM: starts a DMA from DMA_SOURCE, and waits for it to end
+    data_t routine[] = {
+        0x3E, 0xC1,       // LD A, 0xC1
+        0xE0, 0x46,       // LDH (DMA), A
+        0x3E, 0x28,       // LD A, 40: 160 cycles
+        0x3D,             // DEC A
+        0x20, 0xFD,       // JR NZ, -3
+        0xC9              // RET
+    };
+    const addr_t wait = 5;
+
+    // waiting long enough, then not (32 loops): returning to 0xFFFF, the stack not readable yet
+    for(int w = 0; w < 2; ++w) {
+        routine[wait] = w == 0 ? 0x28 : 0x20;
+        for(int t = 0; t < NB_GB_TIMINGS; ++t) {
+            INIT(gb);
+            ck_assert_int_eq(gameboy_set_timing(gb, (gameboy_timing_t) t), ERR_NONE);
+            ck_assert_int_eq(bootrom_fast_boot(gb), ERR_NONE);
+            for(addr_t i = 0; i < sizeof(program); ++i) {
+                ck_assert_int_eq(cpu_write_at_idx(&(gb->cpu), (addr_t)(WORK_RAM_START + i), program[i]), ERR_NONE);
+            }
+            for(addr_t i = 0; i < sizeof(routine); ++i) {
+                ck_assert_int_eq(cpu_write_at_idx(&(gb->cpu), (addr_t)(HIGH_RAM_START + i), routine[i]), ERR_NONE);
+            }
+            for(addr_t i = 0; i < OAM_SIZE; ++i) {
+                ck_assert_int_eq(cpu_write_at_idx(&(gb->cpu), (addr_t)(DMA_SOURCE + i), (data_t)(i + 1)), ERR_NONE);
+            }
+            gb->cpu.write_listener = 0;
+            gb->cpu.idle_time = 0;
+            gb->cpu.PC = WORK_RAM_START;
+
+            ck_assert_int_eq(gameboy_run_until(gb, gb->cycles + 2 * DMA_CYCLES), ERR_NONE);
+            ck_assert_int_eq(gb->cpu.dma_lockout, 0);
+            for(addr_t i = 0; i < OAM_SIZE; ++i) {
+                ck_assert_int_eq(cpu_read_at_idx(&(gb->cpu), (addr_t)(GRAPH_RAM_START + i)), i + 1);
+            }
+            if(w == 0) {
+                ck_assert(at_pc(gb, end) || gb->cpu.PC == end + 2);
+            } else {
+                ck_assert(gb->cpu.PC != end && gb->cpu.PC != end + 2);
+            }
+
+            FREE(gb);
+        }
+    }
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ================================================================================
+Suite* gameboy_test_suite()
+{
+    Suite* s = suite_create("gameboy.c tests");
+
+    Add_Case(s, tc1, "Gameboy run tests");
+    tcase_add_test(tc1, gameboy_run_until_exec);
+    tcase_add_test(tc1, gameboy_run_to_err);
+    tcase_add_test(tc1, gameboy_run_to_cycle_exec);
+    tcase_add_test(tc1, gameboy_run_to_pc_exec);
+    tcase_add_test(tc1, gameboy_run_to_memory_exec);
+    tcase_add_test(tc1, gameboy_run_to_frames_exec);
+    tcase_add_test(tc1, gameboy_run_to_serial_exec);
+    tcase_add_test(tc1, gameboy_line_timer_write_exec);
+    tcase_add_test(tc1, gameboy_dma_lockout_exec);
+
+    return s;
+}
+
+TEST_SUITE(gameboy_test_suite)
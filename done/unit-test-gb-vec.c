@@ -0,0 +1,337 @@
+/**
+ * @file unit-test-gb-vec.c
+ * @brief Unit test code for stepping many emulators at once
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+#include "gb_vec.h"
+#include "gbcore.h"
+#include "error.h"
+
+#define ROM "tests/data/blargg_roms/01-special.gb"
+
+#define NB_ENVS 5
+#define THREADS 3
+
+// after the boot, into the test
+#define BOOT_FRAMES 40
+
+#define SCREEN_WIDTH 160
+#define SCREEN_HEIGHT 144
+
+static const uint16_t ram[] = { 0xC000, 0xFF44, 0xFF80, 0x9800, 0xFE00 };
+#define RAM_SIZE (sizeof(ram) / sizeof(ram[0]))
+
+static const uint8_t grays[4] = { 255, 170, 85, 0 };
+
+#define INIT_ENVS(envs) \
+    gbcore_t* envs[NB_ENVS]; \
+    for(size_t i = 0; i < NB_ENVS; ++i) { \
+        ck_assert_int_eq(gbcore_create(&envs[i], ROM), ERR_NONE); \
+    }
+
+#define FREE_ENVS(envs) \
+    for(size_t i = 0; i < NB_ENVS; ++i) { \
+        gbcore_free(envs[i]); \
+    }
+
+#define INIT_VEC(vec, format, factor, nb_threads) \
+    gb_vec_t* vec = NULL; \
+    do { \
+        gb_vec_config_t config = { .screen = format, .scale = factor, \
+                                   .ram = ram, .ram_size = RAM_SIZE, .threads = nb_threads }; \
+        ck_assert_int_eq(gb_vec_create(&vec, &config), ERR_NONE); \
+        ck_assert_ptr_nonnull(vec); \
+    } while(0)
+
+/**
+ * @brief 2-bit gray level of a pixel of the screen of an emulator
+ */
+static uint8_t level_at(const gbcore_t* env, size_t x, size_t y)
+{
+    gbcore_framebuffer_t fb;
+    ck_assert_int_eq(gbcore_framebuffer(env, &fb), ERR_NONE);
+    const size_t word = y * fb.line_words + x / 32;
+    return (uint8_t) ((((fb.msb[word] >> (x % 32)) & 1) << 1) | ((fb.lsb[word] >> (x % 32)) & 1));
+}
+
+/**
+ * @brief checks the RAM bytes observed of an emulator
+ */
+static void check_ram(const gbcore_t* env, const uint8_t* observed)
+{
+    for(size_t i = 0; i < RAM_SIZE; ++i) {
+        int found = 0;
+        for(int r = 0; r < GBCORE_NB_REGIONS; ++r) {
+            gbcore_memory_t memory;
+            ck_assert_int_eq(gbcore_memory(env, (gbcore_region_t) r, &memory), ERR_NONE);
+            if(ram[i] >= memory.start && ram[i] < memory.start + memory.size) {
+                ck_assert_int_eq(observed[i], memory.data[ram[i] - memory.start]);
+                found = 1;
+            }
+        }
+        ck_assert(found);
+    }
+}
+
+START_TEST(gb_vec_create_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    gb_vec_t* vec = NULL;
+    gb_vec_config_t config = { .screen = GB_VEC_SCREEN_GRAY8, .scale = 2 };
+
+    ck_assert_bad_param(gb_vec_create(NULL, &config));
+    ck_assert_bad_param(gb_vec_create(&vec, NULL));
+
+    config.screen = GB_VEC_NB_SCREENS;
+    ck_assert_bad_param(gb_vec_create(&vec, &config));
+    config.screen = GB_VEC_SCREEN_2BPP;
+    const size_t bad_scales[] = { 0, 3, 5, 32 };
+    for(size_t i = 0; i < sizeof(bad_scales) / sizeof(bad_scales[0]); ++i) {
+        config.scale = bad_scales[i];
+        ck_assert_bad_param(gb_vec_create(&vec, &config));
+    }
+
+    config.scale = 1;
+    config.ram_size = 1;
+    ck_assert_bad_param(gb_vec_create(&vec, &config));
+    const uint16_t not_ram[] = { 0x0100, 0xE000, 0xFEA0, 0xFFFF };
+    for(size_t i = 0; i < sizeof(not_ram) / sizeof(not_ram[0]); ++i) {
+        config.ram = &not_ram[i];
+        ck_assert_bad_param(gb_vec_create(&vec, &config));
+    }
+    ck_assert_ptr_null(vec);
+
+    ck_assert_int_eq(gb_vec_obs_size(NULL), 0);
+    gb_vec_free(NULL);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gb_vec_obs_size_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    const struct {
+        gb_vec_screen_t screen;
+        size_t scale;
+        size_t size;
+    } sizes[] = {
+        { GB_VEC_SCREEN_NONE,  0, 0 },
+        { GB_VEC_SCREEN_GRAY8, 1, SCREEN_WIDTH * SCREEN_HEIGHT },
+        { GB_VEC_SCREEN_GRAY8, 4, 40 * 36 },
+        { GB_VEC_SCREEN_2BPP,  1, 40 * 144 },
+        { GB_VEC_SCREEN_2BPP,  2, 20 * 72 },
+        { GB_VEC_SCREEN_2BPP,  16, 3 * 9 } // 10 pixels: lines of 3 bytes
+    };
+    for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        INIT_VEC(vec, sizes[i].screen, sizes[i].scale, 0);
+        ck_assert_int_eq(gb_vec_obs_size(vec), sizes[i].size + RAM_SIZE);
+        gb_vec_free(vec);
+    }
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gb_vec_step_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT_ENVS(envs);
+    INIT_VEC(vec, GB_VEC_SCREEN_GRAY8, 2, THREADS);
+    uint8_t* tensor = calloc(NB_ENVS, gb_vec_obs_size(vec));
+    ck_assert_ptr_nonnull(tensor);
+
+    ck_assert_bad_param(gb_vec_step(NULL, envs, NULL, NB_ENVS, 1, tensor));
+    ck_assert_bad_param(gb_vec_step(vec, NULL, NULL, NB_ENVS, 1, tensor));
+    ck_assert_bad_param(gb_vec_step(vec, envs, NULL, NB_ENVS, 1, NULL));
+    ck_assert_int_eq(gb_vec_step(vec, NULL, NULL, 0, 1, NULL), ERR_NONE);
+
+    // the others are stepped all the same
+    gbcore_t* const missing = envs[2];
+    envs[2] = NULL;
+    ck_assert_bad_param(gb_vec_step(vec, envs, NULL, NB_ENVS, 1, tensor));
+    envs[2] = missing;
+    ck_assert_int_gt(gbcore_cycles(envs[NB_ENVS - 1]), 0);
+    ck_assert_int_eq(gbcore_cycles(envs[2]), 0);
+
+    free(tensor);
+    gb_vec_free(vec);
+    FREE_ENVS(envs);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gb_vec_step_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT_ENVS(envs);
+    INIT_ENVS(threaded_envs);
+    INIT_ENVS(reference);
+    INIT_VEC(vec, GB_VEC_SCREEN_GRAY8, 1, 0);
+    INIT_VEC(threaded, GB_VEC_SCREEN_GRAY8, 1, THREADS);
+    const size_t size = gb_vec_obs_size(vec);
+    uint8_t* tensor = calloc(NB_ENVS, size);
+    uint8_t* threaded_tensor = calloc(NB_ENVS, size);
+    ck_assert_ptr_nonnull(tensor);
+    ck_assert_ptr_nonnull(threaded_tensor);
+
+    // some of them fast booted, each with its own keys
+    for(size_t i = 0; i < NB_ENVS; i += 2) {
+        ck_assert_int_eq(gbcore_reset(envs[i], 1), ERR_NONE);
+        ck_assert_int_eq(gbcore_reset(threaded_envs[i], 1), ERR_NONE);
+        ck_assert_int_eq(gbcore_reset(reference[i], 1), ERR_NONE);
+    }
+    uint8_t actions[NB_ENVS];
+    for(size_t i = 0; i < NB_ENVS; ++i) {
+        actions[i] = (uint8_t) (1 << i);
+    }
+
+    for(int step = 0; step < BOOT_FRAMES / 4; ++step) {
+        ck_assert_int_eq(gb_vec_step(vec, envs, actions, NB_ENVS, 4, tensor), ERR_NONE);
+        ck_assert_int_eq(gb_vec_step(threaded, threaded_envs, actions, NB_ENVS, 4,
+                                     threaded_tensor), ERR_NONE);
+        for(size_t i = 0; i < NB_ENVS; ++i) {
+            ck_assert_int_eq(gbcore_set_input(reference[i], actions[i]), ERR_NONE);
+            for(int f = 0; f < 4; ++f) {
+                ck_assert_int_eq(gbcore_step_frame(reference[i]), ERR_NONE);
+            }
+        }
+
+        // the same emulation, wherever it runs
+        ck_assert_int_eq(memcmp(tensor, threaded_tensor, NB_ENVS * size), 0);
+        for(size_t i = 0; i < NB_ENVS; ++i) {
+            ck_assert_int_eq(gbcore_cycles(envs[i]), gbcore_cycles(reference[i]));
+            ck_assert_int_eq(gbcore_cycles(threaded_envs[i]), gbcore_cycles(reference[i]));
+        }
+    }
+
+    // what they show, at each row of the tensor
+    for(size_t i = 0; i < NB_ENVS; ++i) {
+        const uint8_t* const row = tensor + i * size;
+        for(size_t y = 0; y < SCREEN_HEIGHT; ++y) {
+            for(size_t x = 0; x < SCREEN_WIDTH; ++x) {
+                ck_assert_int_eq(row[y * SCREEN_WIDTH + x], grays[level_at(reference[i], x, y)]);
+            }
+        }
+        check_ram(reference[i], row + SCREEN_WIDTH * SCREEN_HEIGHT);
+    }
+
+    free(tensor);
+    free(threaded_tensor);
+    gb_vec_free(vec);
+    gb_vec_free(threaded);
+    FREE_ENVS(envs);
+    FREE_ENVS(threaded_envs);
+    FREE_ENVS(reference);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gb_vec_screens_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT_ENVS(envs);
+    INIT_VEC(boot, GB_VEC_SCREEN_NONE, 0, THREADS);
+    ck_assert_int_eq(gb_vec_obs_size(boot), RAM_SIZE);
+    uint8_t* ram_tensor = calloc(NB_ENVS, RAM_SIZE);
+    ck_assert_ptr_nonnull(ram_tensor);
+    ck_assert_int_eq(gb_vec_step(boot, envs, NULL, NB_ENVS, BOOT_FRAMES, ram_tensor), ERR_NONE);
+    for(size_t i = 0; i < NB_ENVS; ++i) {
+        check_ram(envs[i], ram_tensor + i * RAM_SIZE);
+    }
+
+    // observed only, in each format
+    for(size_t scale = 1; scale <= 16; scale *= 2) {
+        INIT_VEC(gray8, GB_VEC_SCREEN_GRAY8, scale, THREADS);
+        INIT_VEC(packed, GB_VEC_SCREEN_2BPP, scale, THREADS);
+        const size_t width = SCREEN_WIDTH / scale;
+        const size_t height = SCREEN_HEIGHT / scale;
+        const size_t line_bytes = (width + 3) / 4;
+        uint8_t* gray8_tensor = calloc(NB_ENVS, gb_vec_obs_size(gray8));
+        uint8_t* packed_tensor = calloc(NB_ENVS, gb_vec_obs_size(packed));
+        ck_assert_ptr_nonnull(gray8_tensor);
+        ck_assert_ptr_nonnull(packed_tensor);
+        memset(packed_tensor, 0xFF, NB_ENVS * gb_vec_obs_size(packed));
+
+        const uint64_t cycles = gbcore_cycles(envs[0]);
+        ck_assert_int_eq(gb_vec_step(gray8, envs, NULL, NB_ENVS, 0, gray8_tensor), ERR_NONE);
+        ck_assert_int_eq(gb_vec_step(packed, envs, NULL, NB_ENVS, 0, packed_tensor), ERR_NONE);
+        ck_assert_int_eq(gbcore_cycles(envs[0]), cycles);
+
+        for(size_t i = 0; i < NB_ENVS; ++i) {
+            const uint8_t* const gray8_row = gray8_tensor + i * gb_vec_obs_size(gray8);
+            const uint8_t* const packed_row = packed_tensor + i * gb_vec_obs_size(packed);
+            for(size_t y = 0; y < height; ++y) {
+                for(size_t x = 0; x < line_bytes * 4; ++x) {
+                    const uint8_t level = (packed_row[y * line_bytes + x / 4] >> (2 * (x % 4))) & 3;
+                    if(x >= width) { // padding
+                        ck_assert_int_eq(level, 0);
+                        continue;
+                    }
+                    ck_assert_int_eq(level, level_at(envs[i], x * scale, y * scale));
+                    ck_assert_int_eq(gray8_row[y * width + x], grays[level]);
+                }
+            }
+            check_ram(envs[i], packed_row + height * line_bytes);
+        }
+
+        free(gray8_tensor);
+        free(packed_tensor);
+        gb_vec_free(gray8);
+        gb_vec_free(packed);
+    }
+
+    free(ram_tensor);
+    gb_vec_free(boot);
+    FREE_ENVS(envs);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ================================================================================
+Suite* gb_vec_test_suite()
+{
+    Suite* s = suite_create("gb_vec.c tests");
+
+    Add_Case(s, tc1, "Vectorized step tests");
+    tcase_add_test(tc1, gb_vec_create_err);
+    tcase_add_test(tc1, gb_vec_obs_size_exec);
+    tcase_add_test(tc1, gb_vec_step_err);
+    tcase_add_test(tc1, gb_vec_step_exec);
+    tcase_add_test(tc1, gb_vec_screens_exec);
+
+    return s;
+}
+
+TEST_SUITE(gb_vec_test_suite)
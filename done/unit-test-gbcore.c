@@ -0,0 +1,330 @@
+/**
+ * @file unit-test-gbcore.c
+ * @brief Unit test code for the emulator core library, through its API only
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+#include "gbcore.h"
+#include "lcdc.h"
+#include "error.h"
+
+#define ROM "tests/data/blargg_roms/01-special.gb"
+
+// after the boot, into the test
+#define BOOT_FRAMES 40
+
+#define SCREEN_WIDTH 160
+#define SCREEN_HEIGHT 144
+
+#define REG_LY 0xFF44
+
+#define INIT(core) \
+    gbcore_t* core = NULL; \
+    ck_assert_int_eq(gbcore_create(&core, ROM), ERR_NONE); \
+    ck_assert_ptr_nonnull(core)
+
+/**
+ * @brief runs frames
+ */
+static void step_frames(gbcore_t* core, int frames)
+{
+    for(int f = 0; f < frames; ++f) {
+        ck_assert_int_eq(gbcore_step_frame(core), ERR_NONE);
+    }
+}
+
+/**
+ * @brief copies the screen (both planes)
+ */
+static uint32_t* screen_copy(const gbcore_t* core)
+{
+    gbcore_framebuffer_t fb;
+    ck_assert_int_eq(gbcore_framebuffer(core, &fb), ERR_NONE);
+    const size_t words = fb.height * fb.line_words;
+    uint32_t* copy = calloc(2 * words, sizeof(uint32_t));
+    ck_assert_ptr_nonnull(copy);
+    memcpy(copy, fb.msb, words * sizeof(uint32_t));
+    memcpy(copy + words, fb.lsb, words * sizeof(uint32_t));
+    return copy;
+}
+
+/**
+ * @brief whether the screen is the one copied
+ */
+static int screen_is(const gbcore_t* core, const uint32_t* copy)
+{
+    gbcore_framebuffer_t fb;
+    ck_assert_int_eq(gbcore_framebuffer(core, &fb), ERR_NONE);
+    const size_t words = fb.height * fb.line_words;
+    return memcmp(copy, fb.msb, words * sizeof(uint32_t)) == 0
+           && memcmp(copy + words, fb.lsb, words * sizeof(uint32_t)) == 0;
+}
+
+START_TEST(gbcore_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(core);
+    INIT(other);
+    gbcore_t* none = NULL;
+    gbcore_framebuffer_t fb;
+    gbcore_memory_t memory;
+    gbcore_state_t* state = NULL;
+
+    ck_assert_bad_param(gbcore_create(NULL, ROM));
+    ck_assert_bad_param(gbcore_create(&none, NULL));
+    ck_assert_int_ne(gbcore_create(&none, "no/such/rom.gb"), ERR_NONE);
+    ck_assert_ptr_null(none);
+
+    ck_assert_bad_param(gbcore_reset(NULL, 0));
+    ck_assert_bad_param(gbcore_step_frame(NULL));
+    ck_assert_bad_param(gbcore_set_input(NULL, GBCORE_A));
+    ck_assert_int_eq(gbcore_cycles(NULL), 0);
+    ck_assert_bad_param(gbcore_framebuffer(NULL, &fb));
+    ck_assert_bad_param(gbcore_framebuffer(core, NULL));
+    ck_assert_bad_param(gbcore_memory(NULL, GBCORE_WORK_RAM, &memory));
+    ck_assert_bad_param(gbcore_memory(core, GBCORE_WORK_RAM, NULL));
+    ck_assert_bad_param(gbcore_memory(core, GBCORE_NB_REGIONS, &memory));
+    ck_assert_bad_param(gbcore_region_of(0x0150, NULL, NULL)); // ROM
+    ck_assert_bad_param(gbcore_region_of(0xFEA0, NULL, NULL)); // unusable
+    ck_assert_bad_param(gbcore_region_of(0xFFFF, NULL, NULL)); // IE
+    ck_assert_bad_param(gbcore_save(NULL, &state));
+    ck_assert_bad_param(gbcore_save(core, NULL));
+    ck_assert_bad_param(gbcore_load(core, NULL));
+
+    // states go with their own core
+    ck_assert_int_eq(gbcore_save(core, &state), ERR_NONE);
+    ck_assert_bad_param(gbcore_load(NULL, state));
+    ck_assert_bad_param(gbcore_load(other, state));
+    ck_assert_bad_param(gbcore_save(other, &state));
+
+    gbcore_free(NULL);
+    gbcore_state_free(NULL);
+    gbcore_state_free(state);
+    gbcore_free(core);
+    gbcore_free(other);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gbcore_step_frame_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(core);
+    gbcore_memory_t io;
+    ck_assert_int_eq(gbcore_memory(core, GBCORE_IO, &io), ERR_NONE);
+
+    ck_assert_int_eq(gbcore_cycles(core), 0);
+    for(int f = 0; f < BOOT_FRAMES; ++f) {
+        const uint64_t cycles = gbcore_cycles(core);
+        ck_assert_int_eq(gbcore_step_frame(core), ERR_NONE);
+        ck_assert_int_gt(gbcore_cycles(core), cycles);
+        ck_assert_int_le(gbcore_cycles(core), cycles + FRAME_TOTAL_CYCLES);
+    }
+
+    // at the start of the vertical blank
+    ck_assert_int_eq(io.data[REG_LY - io.start], SCREEN_HEIGHT);
+
+    // a fast boot skips the boot ROM
+    ck_assert_int_eq(gbcore_reset(core, 0), ERR_NONE);
+    ck_assert_int_eq(gbcore_cycles(core), 0);
+    ck_assert_int_eq(gbcore_reset(core, 1), ERR_NONE);
+    step_frames(core, 1);
+    ck_assert_int_eq(io.data[REG_LY - io.start], SCREEN_HEIGHT);
+
+    gbcore_free(core);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gbcore_views_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(core);
+    gbcore_framebuffer_t fb;
+    gbcore_framebuffer_t again;
+    ck_assert_int_eq(gbcore_framebuffer(core, &fb), ERR_NONE);
+    ck_assert_int_eq(fb.width, SCREEN_WIDTH);
+    ck_assert_int_eq(fb.height, SCREEN_HEIGHT);
+    ck_assert_int_ge(fb.line_words * 32, fb.width);
+    ck_assert_ptr_nonnull(fb.msb);
+    ck_assert_ptr_nonnull(fb.lsb);
+
+    const struct {
+        gbcore_region_t region;
+        uint16_t start;
+        size_t size;
+    } regions[] = {
+        { GBCORE_VIDEO_RAM,  0x8000, 0x2000 },
+        { GBCORE_EXTERN_RAM, 0xA000, 0x2000 },
+        { GBCORE_WORK_RAM,   0xC000, 0x2000 },
+        { GBCORE_OAM,        0xFE00, 0x00A0 },
+        { GBCORE_IO,         0xFF00, 0x0080 },
+        { GBCORE_HIGH_RAM,   0xFF80, 0x007F }
+    };
+    gbcore_memory_t memory[GBCORE_NB_REGIONS];
+    for(size_t i = 0; i < sizeof(regions) / sizeof(regions[0]); ++i) {
+        ck_assert_int_eq(gbcore_memory(core, regions[i].region, &memory[i]), ERR_NONE);
+        ck_assert_ptr_nonnull(memory[i].data);
+        ck_assert_int_eq(memory[i].start, regions[i].start);
+        ck_assert_int_eq(memory[i].size, regions[i].size);
+
+        // first and last addresses of the region
+        gbcore_region_t region = GBCORE_NB_REGIONS;
+        size_t offset = 1;
+        ck_assert_int_eq(gbcore_region_of(regions[i].start, &region, &offset), ERR_NONE);
+        ck_assert_int_eq(region, regions[i].region);
+        ck_assert_int_eq(offset, 0);
+        const uint16_t last = (uint16_t) (regions[i].start + regions[i].size - 1);
+        ck_assert_int_eq(gbcore_region_of(last, &region, &offset), ERR_NONE);
+        ck_assert_int_eq(region, regions[i].region);
+        ck_assert_int_eq(offset, regions[i].size - 1);
+    }
+
+    // views into the emulator, no copy: the same ones, following it
+    uint32_t* boot_screen = screen_copy(core);
+    step_frames(core, BOOT_FRAMES);
+    ck_assert_int_eq(gbcore_framebuffer(core, &again), ERR_NONE);
+    ck_assert_ptr_eq(again.msb, fb.msb);
+    ck_assert_ptr_eq(again.lsb, fb.lsb);
+    ck_assert(!screen_is(core, boot_screen));
+    for(size_t i = 0; i < sizeof(regions) / sizeof(regions[0]); ++i) {
+        gbcore_memory_t view;
+        ck_assert_int_eq(gbcore_memory(core, regions[i].region, &view), ERR_NONE);
+        ck_assert_ptr_eq(view.data, memory[i].data);
+    }
+
+    free(boot_screen);
+    gbcore_free(core);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gbcore_save_load_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(core);
+    gbcore_state_t* state = NULL;
+    gbcore_memory_t wram;
+    ck_assert_int_eq(gbcore_memory(core, GBCORE_WORK_RAM, &wram), ERR_NONE);
+    uint8_t* saved_wram = malloc(wram.size);
+    ck_assert_ptr_nonnull(saved_wram);
+
+    // saved during the boot, then overwritten after it
+    step_frames(core, 2);
+    ck_assert_int_eq(gbcore_save(core, &state), ERR_NONE);
+    ck_assert_ptr_nonnull(state);
+    const gbcore_state_t* const first = state;
+    step_frames(core, BOOT_FRAMES);
+    ck_assert_int_eq(gbcore_save(core, &state), ERR_NONE);
+    ck_assert_ptr_eq(state, first);
+    const uint64_t cycles = gbcore_cycles(core);
+
+    // the same frames run again from the state
+    step_frames(core, 5);
+    const uint64_t end = gbcore_cycles(core);
+    uint32_t* screen = screen_copy(core);
+    memcpy(saved_wram, wram.data, wram.size);
+
+    step_frames(core, 3);
+    ck_assert_int_eq(gbcore_load(core, state), ERR_NONE);
+    ck_assert_int_eq(gbcore_cycles(core), cycles);
+    step_frames(core, 5);
+    ck_assert_int_eq(gbcore_cycles(core), end);
+    ck_assert(screen_is(core, screen));
+    ck_assert_int_eq(memcmp(saved_wram, wram.data, wram.size), 0);
+
+    // the state stays as saved
+    ck_assert_int_eq(gbcore_load(core, state), ERR_NONE);
+    ck_assert_int_eq(gbcore_cycles(core), cycles);
+
+    free(saved_wram);
+    free(screen);
+    gbcore_state_free(state);
+    gbcore_free(core);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(gbcore_set_input_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT(core1);
+    INIT(core2);
+    gbcore_state_t* state = NULL;
+
+    // the same keys, the same emulation
+    const uint8_t inputs[] = { 0, GBCORE_A, GBCORE_A | GBCORE_START, GBCORE_DOWN, 0xFF, 0 };
+    for(size_t i = 0; i < sizeof(inputs); ++i) {
+        ck_assert_int_eq(gbcore_set_input(core1, inputs[i]), ERR_NONE);
+        ck_assert_int_eq(gbcore_set_input(core2, inputs[i]), ERR_NONE);
+        step_frames(core1, 1);
+        step_frames(core2, 1);
+    }
+    ck_assert_int_eq(gbcore_cycles(core1), gbcore_cycles(core2));
+    uint32_t* screen = screen_copy(core1);
+    ck_assert(screen_is(core2, screen));
+
+    // the keys held are saved too
+    ck_assert_int_eq(gbcore_set_input(core1, GBCORE_B), ERR_NONE);
+    ck_assert_int_eq(gbcore_save(core1, &state), ERR_NONE);
+    ck_assert_int_eq(gbcore_set_input(core1, 0), ERR_NONE);
+    ck_assert_int_eq(gbcore_load(core1, state), ERR_NONE);
+    ck_assert_int_eq(gbcore_set_input(core1, 0), ERR_NONE);
+    ck_assert_int_eq(gbcore_set_input(core1, GBCORE_B), ERR_NONE);
+
+    free(screen);
+    gbcore_state_free(state);
+    gbcore_free(core1);
+    gbcore_free(core2);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ================================================================================
+Suite* gbcore_test_suite()
+{
+    Suite* s = suite_create("gbcore.c tests");
+
+    Add_Case(s, tc1, "Emulator core tests");
+    tcase_add_test(tc1, gbcore_err);
+    tcase_add_test(tc1, gbcore_step_frame_exec);
+    tcase_add_test(tc1, gbcore_views_exec);
+    tcase_add_test(tc1, gbcore_save_load_exec);
+    tcase_add_test(tc1, gbcore_set_input_exec);
+
+    return s;
+}
+
+TEST_SUITE(gbcore_test_suite)
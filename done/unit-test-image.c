@@ -0,0 +1,145 @@
+/**
+ * @file unit-test-image.c
+ * @brief Unit test code for the images
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "tests.h"
+#include "image.h"
+#include "error.h"
+
+#define WIDTH  160
+#define HEIGHT 144
+
+#define INIT \
+    image_t image; \
+    ck_assert_int_eq(image_create(&image, WIDTH, HEIGHT), ERR_NONE)
+
+#define FREE \
+    image_free(&image)
+
+START_TEST(image_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    image_t other;
+    ck_assert_int_eq(image_create(NULL, WIDTH, HEIGHT), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(image_create(&other, 0, HEIGHT), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(image_create(&other, WIDTH, 0), ERR_BAD_PARAMETER);
+
+    ck_assert_int_eq(image_copy(NULL, &image), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(image_copy(&image, NULL), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(image_create(&other, WIDTH, HEIGHT - 1), ERR_NONE);
+    ck_assert_int_eq(image_copy(&other, &image), ERR_BAD_PARAMETER);
+    image_free(&other);
+
+    image_line_t line;
+    ck_assert_int_eq(image_line_create(&line, WIDTH - 1), ERR_NONE);
+    ck_assert_int_eq(image_own_line_content(&image, 0, line), ERR_BAD_PARAMETER);
+    ck_assert_int_eq(image_own_line_content(&image, HEIGHT, line), ERR_BAD_PARAMETER);
+    image_line_free(&line);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(image_slab)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    ck_assert_int_eq((uintptr_t) image.slab % IMAGE_ALIGNMENT, 0);
+    ck_assert_int_eq(image.line_words, WIDTH / IMAGE_LINE_WORD_BITS);
+
+    // planes by lines
+    for(size_t y = 0; y < HEIGHT; ++y) {
+        ck_assert_ptr_eq(image.content[y].msb->content, image.slab + y * image.line_words);
+        ck_assert_ptr_eq(image.content[y].lsb->content, image.slab + (HEIGHT + y) * image.line_words);
+        ck_assert_ptr_eq(image.content[y].opacity->content, image.slab + (2 * HEIGHT + y) * image.line_words);
+        ck_assert_int_eq(image.content[y].msb->size, WIDTH);
+    }
+
+    // all black
+    uint8_t pixel = 1;
+    ck_assert_int_eq(image_get_pixel(&pixel, &image, WIDTH - 1, HEIGHT - 1), ERR_NONE);
+    ck_assert_int_eq(pixel, 0);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(image_lines)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    // given line copied into the slab
+    image_line_t line;
+    ck_assert_int_eq(image_line_create(&line, WIDTH), ERR_NONE);
+    ck_assert_int_eq(image_line_set_word(&line, 1, 0x1, 0x3), ERR_NONE);
+    ck_assert_int_eq(image_own_line_content(&image, 5, line), ERR_NONE);
+
+    uint8_t pixel = 0;
+    ck_assert_int_eq(image_get_pixel(&pixel, &image, 32, 5), ERR_NONE);
+    ck_assert_int_eq(pixel, 3);
+    ck_assert_int_eq(image_get_pixel(&pixel, &image, 33, 5), ERR_NONE);
+    ck_assert_int_eq(pixel, 1);
+    ck_assert_int_eq(image_get_pixel(&pixel, &image, 32, 4), ERR_NONE);
+    ck_assert_int_eq(pixel, 0);
+    ck_assert_int_eq(image.content[5].opacity->content[1], 0x3);
+
+    // whole copy
+    image_t copy;
+    ck_assert_int_eq(image_create(&copy, WIDTH, HEIGHT), ERR_NONE);
+    ck_assert_int_eq(image_copy(&copy, &image), ERR_NONE);
+    ck_assert_int_eq(image_get_pixel(&pixel, &copy, 32, 5), ERR_NONE);
+    ck_assert_int_eq(pixel, 3);
+
+    // copies are independent
+    ck_assert_int_eq(image_line_set_word(&image.content[5], 1, 0, 0), ERR_NONE);
+    ck_assert_int_eq(image_get_pixel(&pixel, &copy, 32, 5), ERR_NONE);
+    ck_assert_int_eq(pixel, 3);
+    image_free(&copy);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ================================================================================
+Suite* image_test_suite()
+{
+    Suite* s = suite_create("image.c tests");
+
+    Add_Case(s, tc1, "Image tests");
+    tcase_add_test(tc1, image_err);
+    tcase_add_test(tc1, image_slab);
+    tcase_add_test(tc1, image_lines);
+
+    return s;
+}
+
+TEST_SUITE(image_test_suite)
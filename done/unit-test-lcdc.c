@@ -0,0 +1,354 @@
+/**
+ * @file unit-test-lcdc.c
+ * @brief Unit test code for the LCD controller
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "tests.h"
+#include "gameboy.h"
+#include "lcdc.h"
+#include "error.h"
+#include "util.h"
+
+// placed here to prevent an include loop
+#include "cpu-storage.h"
+
+#define FIBONACCI_ROM "tests/data/fibonacci.gb"
+
+#define IDENTITY_PALETTE 0xE4
+
+// addresses the CPU is locked out of (in the work RAM) or not (in the high RAM) during a DMA
+#define DMA_WRAM 0xC000
+#define DMA_HRAM 0xFF80
+
+/**
+ * @brief a Game Boy with its screen on, showing the background only
+ *        (tile 0 everywhere, tiles from 0x8000)
+ */
+#define INIT \
+    gameboy_t* gb = calloc(1, sizeof(gameboy_t)); \
+    ck_assert_ptr_nonnull(gb); \
+    ck_assert_int_eq(gameboy_create(gb, FIBONACCI_ROM), ERR_NONE); \
+    *(gb->bus[REG_LCDC]) = LCDC_REG_LCD_STATUS_MASK | LCDC_REG_TILE_SOURCE_MASK | LCDC_REG_BG_MASK; \
+    *(gb->bus[REG_BGP]) = IDENTITY_PALETTE; \
+    uint8_t lines[LCDC_LINES_BITMAP_SIZE]; \
+    uint64_t frame = 0
+
+#define FREE \
+    do { \
+        gameboy_free(gb); \
+        free(gb); \
+    } while(0)
+
+/**
+ * @brief runs the LCD controller (only) for one frame
+ */
+#define run_frame() \
+    do { \
+        for(uint64_t c = frame * FRAME_TOTAL_CYCLES; c < (frame + 1) * FRAME_TOTAL_CYCLES; ++c) { \
+            ck_assert_int_eq(lcdc_cycle(&(gb->screen), c), ERR_NONE); \
+        } \
+        ck_assert_int_eq(lcdc_flush(&(gb->screen)), ERR_NONE); \
+        ++frame; \
+    } while(0)
+
+/**
+ * @brief number of lines in a lines bitmap
+ */
+static int count_lines(const uint8_t* lines)
+{
+    int n = 0;
+    for(int y = 0; y < LCD_HEIGHT; ++y) {
+        n += bit_get(lines[y / 8], y % 8);
+    }
+    return n;
+}
+
+START_TEST(lcdc_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    ck_assert_bad_param(lcdc_init(NULL));
+    ck_assert_bad_param(lcdc_plug(NULL, gb->bus));
+    ck_assert_bad_param(lcdc_cycle(NULL, 0));
+    ck_assert_bad_param(lcdc_bus_listener(NULL, REG_LCDC, 0));
+    ck_assert_bad_param(lcdc_flush(NULL));
+    ck_assert_bad_param(lcdc_run_until(NULL, 0, 1));
+    ck_assert_bad_param(lcdc_run_until(&(gb->screen), 1, 0));
+    ck_assert_bad_param(lcdc_take_dirty_lines(NULL, lines));
+    ck_assert_bad_param(lcdc_take_dirty_lines(&(gb->screen), NULL));
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(lcdc_background)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    // first row of tile 0: leftmost pixel of color 1
+    *(gb->bus[0x8000]) = 0x80;
+    ck_assert_int_eq(lcdc_bus_listener(&(gb->screen), 0x8000, 0), ERR_NONE);
+    run_frame();
+
+    uint8_t pixel = 0;
+    ck_assert_int_eq(image_get_pixel(&pixel, &(gb->screen.display), 0, 0), ERR_NONE);
+    ck_assert_int_eq(pixel, 1);
+    ck_assert_int_eq(image_get_pixel(&pixel, &(gb->screen.display), 8, 8), ERR_NONE);
+    ck_assert_int_eq(pixel, 1);
+    ck_assert_int_eq(image_get_pixel(&pixel, &(gb->screen.display), 1, 0), ERR_NONE);
+    ck_assert_int_eq(pixel, 0);
+    ck_assert_int_eq(image_get_pixel(&pixel, &(gb->screen.display), 0, 1), ERR_NONE);
+    ck_assert_int_eq(pixel, 0);
+
+    // scrolled by one pixel
+    *(gb->bus[REG_SCX]) = 1;
+    run_frame();
+    ck_assert_int_eq(image_get_pixel(&pixel, &(gb->screen.display), 0, 0), ERR_NONE);
+    ck_assert_int_eq(pixel, 0);
+    ck_assert_int_eq(image_get_pixel(&pixel, &(gb->screen.display), 7, 0), ERR_NONE);
+    ck_assert_int_eq(pixel, 1);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(lcdc_dirty_lines)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    ck_assert_int_eq(lcdc_take_dirty_lines(&(gb->screen), lines), ERR_NONE);
+    ck_assert_int_eq(count_lines(lines), 0);
+
+    run_frame();
+    ck_assert_int_eq(lcdc_take_dirty_lines(&(gb->screen), lines), ERR_NONE);
+    ck_assert_int_eq(count_lines(lines), LCD_HEIGHT);
+    ck_assert_int_eq(lcdc_take_dirty_lines(&(gb->screen), lines), ERR_NONE);
+    ck_assert_int_eq(count_lines(lines), 0);
+
+    // same frame again
+    run_frame();
+    ck_assert_int_eq(lcdc_take_dirty_lines(&(gb->screen), lines), ERR_NONE);
+#ifdef LINE_CACHE
+    ck_assert_int_eq(count_lines(lines), 0);
+#else
+    ck_assert_int_eq(count_lines(lines), LCD_HEIGHT);
+#endif
+
+    // only the lines showing the second row of the tiles change
+    *(gb->bus[0x8003]) = 0x01;
+    ck_assert_int_eq(lcdc_bus_listener(&(gb->screen), 0x8003, 0), ERR_NONE);
+    run_frame();
+    ck_assert_int_eq(lcdc_take_dirty_lines(&(gb->screen), lines), ERR_NONE);
+#ifdef LINE_CACHE
+    ck_assert_int_eq(count_lines(lines), LCD_HEIGHT / 8);
+    ck_assert_int_eq(bit_get(lines[0], 1), 1);
+    ck_assert_int_eq(bit_get(lines[0], 2), 0);
+#else
+    ck_assert_int_eq(count_lines(lines), LCD_HEIGHT);
+#endif
+
+    uint8_t pixel = 0;
+    ck_assert_int_eq(image_get_pixel(&pixel, &(gb->screen.display), 7, 1), ERR_NONE);
+    ck_assert_int_eq(pixel, 2);
+
+    // no line drawn while the background is off
+    *(gb->bus[REG_LCDC]) &= (data_t) ~LCDC_REG_BG_MASK;
+    run_frame();
+    ck_assert_int_eq(lcdc_take_dirty_lines(&(gb->screen), lines), ERR_NONE);
+    ck_assert_int_eq(count_lines(lines), 0);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(lcdc_by_line)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    // a second Game Boy, run a line at a time
+    gameboy_t* other = calloc(1, sizeof(gameboy_t));
+    ck_assert_ptr_nonnull(other);
+    ck_assert_int_eq(gameboy_create(other, FIBONACCI_ROM), ERR_NONE);
+    *(other->bus[REG_LCDC]) = *(gb->bus[REG_LCDC]);
+    *(other->bus[REG_BGP]) = IDENTITY_PALETTE;
+
+    for(addr_t a = 0x8000; a < 0x8010; ++a) {
+        *(gb->bus[a]) = *(other->bus[a]) = (data_t)(a * 37);
+        ck_assert_int_eq(lcdc_bus_listener(&(gb->screen), a, 0), ERR_NONE);
+        ck_assert_int_eq(lcdc_bus_listener(&(other->screen), a, 0), ERR_NONE);
+    }
+
+    run_frame();
+    for(uint64_t c = 0; c < FRAME_TOTAL_CYCLES; c += LINE_TOTAL_CYCLES) {
+        ck_assert_int_eq(lcdc_run_until(&(other->screen), c, c + LINE_TOTAL_CYCLES), ERR_NONE);
+    }
+    ck_assert_int_eq(lcdc_flush(&(other->screen)), ERR_NONE);
+
+    ck_assert_int_eq(other->screen.next_cycle, gb->screen.next_cycle);
+    ck_assert_int_eq(*(other->bus[REG_LY]), *(gb->bus[REG_LY]));
+    ck_assert_int_eq(other->cpu.IF, gb->cpu.IF);
+    for(size_t y = 0; y < LCD_HEIGHT; ++y) {
+        for(size_t x = 0; x < LCD_WIDTH; ++x) {
+            uint8_t p1 = 0;
+            uint8_t p2 = 0;
+            ck_assert_int_eq(image_get_pixel(&p1, &(gb->screen.display), x, y), ERR_NONE);
+            ck_assert_int_eq(image_get_pixel(&p2, &(other->screen.display), x, y), ERR_NONE);
+            ck_assert_int_eq(p1, p2);
+        }
+    }
+
+    gameboy_free(other);
+    free(other);
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(lcdc_dma)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    // from the work RAM and from the registers and high RAM
+    const addr_t pages[] = { 0xC100, 0xFF00 };
+    for(size_t p = 0; p < sizeof(pages) / sizeof(pages[0]); ++p) {
+        for(addr_t i = 0; i < DMA_CYCLES; ++i) {
+            if(pages[p] + i >= 0xFF80 || pages[p] < 0xFF00) {
+                *(gb->bus[pages[p] + i]) = (data_t)(i * 7 + p);
+            }
+        }
+        const uint64_t c = p;
+        *(gb->bus[REG_DMA]) = (data_t)(pages[p] >> 8);
+        ck_assert_int_eq(lcdc_bus_listener(&(gb->screen), REG_DMA, c), ERR_NONE);
+        ck_assert_int_eq(gb->screen.DMA_to, GRAPH_RAM_START);
+        ck_assert_int_eq(gb->screen.DMA_end, c + DMA_CYCLES);
+
+        // whole page copied at the next cycle
+        ck_assert_int_eq(lcdc_cycle(&(gb->screen), c), ERR_NONE);
+        ck_assert_int_eq(gb->screen.DMA_to, GRAPH_RAM_END + 1);
+        for(addr_t i = 0; i < DMA_CYCLES; ++i) {
+            ck_assert_int_eq(*(gb->bus[GRAPH_RAM_START + i]), cpu_peek_at_idx(&(gb->cpu), (addr_t)(pages[p] + i)));
+        }
+
+        // the CPU only reaching the registers and the high RAM until its end
+        for(uint64_t end = c + 1; end < c + DMA_CYCLES; ++end) {
+            ck_assert_int_eq(gb->cpu.dma_lockout, 1);
+            ck_assert_int_eq(lcdc_cycle(&(gb->screen), end - 1), ERR_NONE);
+        }
+        ck_assert_int_eq(cpu_read_at_idx(&(gb->cpu), DMA_WRAM), 0xFF);
+        ck_assert_int_eq(cpu_read16_at_idx(&(gb->cpu), DMA_WRAM), 0xFFFF);
+        ck_assert_int_eq(cpu_read_at_idx(&(gb->cpu), GRAPH_RAM_START), 0xFF);
+        ck_assert_int_eq(cpu_read_at_idx(&(gb->cpu), DMA_HRAM), *(gb->bus[DMA_HRAM]));
+        ck_assert_int_eq(cpu_write_at_idx(&(gb->cpu), DMA_WRAM, 0x42), ERR_NONE);
+        ck_assert_int_eq(cpu_write16_at_idx(&(gb->cpu), (addr_t)(DMA_WRAM + 1), 0x4243), ERR_NONE);
+        ck_assert_int_eq(cpu_write16_at_idx(&(gb->cpu), DMA_HRAM, 0x4243), ERR_NONE);
+        ck_assert_int_ne(*(gb->bus[DMA_WRAM]), 0x42);
+        ck_assert_int_ne(*(gb->bus[DMA_WRAM + 1]), 0x43);
+        ck_assert_int_ne(*(gb->bus[DMA_WRAM + 2]), 0x42);
+        ck_assert_int_eq(*(gb->bus[DMA_HRAM]), 0x43);
+        ck_assert_int_eq(*(gb->bus[DMA_HRAM + 1]), 0x42);
+        ck_assert_int_eq(lcdc_cycle(&(gb->screen), c + DMA_CYCLES - 1), ERR_NONE);
+        ck_assert_int_eq(gb->cpu.dma_lockout, 0);
+        ck_assert_int_eq(gb->screen.DMA_end, UINT64_MAX);
+        ck_assert_int_eq(cpu_read_at_idx(&(gb->cpu), DMA_WRAM), *(gb->bus[DMA_WRAM]));
+    }
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+#ifdef DEFERRED_RENDER
+START_TEST(lcdc_deferred)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    *(gb->bus[0x8000]) = 0x80;
+    ck_assert_int_eq(lcdc_bus_listener(&(gb->screen), 0x8000, 0), ERR_NONE);
+
+    // first lines only logged...
+    for(uint64_t c = 0; c < 20 * LINE_TOTAL_CYCLES; ++c) {
+        ck_assert_int_eq(lcdc_cycle(&(gb->screen), c), ERR_NONE);
+    }
+    uint8_t pixel = 0;
+    ck_assert_int_eq(image_get_pixel(&pixel, &(gb->screen.display), 0, 0), ERR_NONE);
+    ck_assert_int_eq(pixel, 0);
+    ck_assert(!gb->screen.started);
+
+    // ...until flushed, by threads started then
+    ck_assert_int_eq(lcdc_flush(&(gb->screen)), ERR_NONE);
+    ck_assert(gb->screen.started);
+    ck_assert_int_eq(image_get_pixel(&pixel, &(gb->screen.display), 0, 0), ERR_NONE);
+    ck_assert_int_eq(pixel, 1);
+    ck_assert_int_eq(lcdc_take_dirty_lines(&(gb->screen), lines), ERR_NONE);
+    ck_assert_int_eq(count_lines(lines), 20);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+#endif
+
+// ================================================================================
+Suite* lcdc_test_suite()
+{
+    Suite* s = suite_create("lcdc.c tests");
+
+    Add_Case(s, tc1, "LCD controller tests");
+    tcase_add_test(tc1, lcdc_err);
+    tcase_add_test(tc1, lcdc_background);
+    tcase_add_test(tc1, lcdc_dirty_lines);
+    tcase_add_test(tc1, lcdc_by_line);
+    tcase_add_test(tc1, lcdc_dma);
+#ifdef DEFERRED_RENDER
+    tcase_add_test(tc1, lcdc_deferred);
+#endif
+
+    return s;
+}
+
+TEST_SUITE(lcdc_test_suite)
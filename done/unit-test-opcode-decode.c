@@ -0,0 +1,97 @@
+/**
+ * @file unit-test-opcode-decode.c
+ * @brief Unit test code for the decoded instruction table
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+
+#include "tests.h"
+#include "opcode.h"
+#include "opcode-decode.h"
+#include "cpu-registers.h"
+#include "error.h"
+
+// ------------------------------------------------------------
+/**
+ * @brief checks every entry of one instruction table against the decoded table
+ */
+#define check_table(TAB, KIND) \
+    do { \
+        for (size_t i = 0; i < 256; ++i) { \
+            const instruction_t* lu = &TAB[i]; \
+            const decoded_instr_t* d = &instruction_decoded[decoded_index(KIND, i)]; \
+            const opcode_t op = (opcode_t) i; \
+            ck_assert_msg(d->family == lu->family, #TAB "[0x%02zX]: family %d != %d", i, d->family, lu->family); \
+            ck_assert_int_eq(d->bytes, lu->bytes); \
+            ck_assert_int_eq(d->cycles, lu->cycles); \
+            ck_assert_int_eq(d->xtra_cycles, lu->xtra_cycles); \
+            if (lu->family != UNKN) { \
+                ck_assert_int_eq(d->r_dst, extract_reg(op, 3)); \
+                ck_assert_int_eq(d->r_dst, extract_n3(op)); \
+                ck_assert_int_eq(d->r_src, extract_reg(op, 0)); \
+                ck_assert_int_eq(d->pair, extract_reg_pair(op)); \
+                ck_assert_int_eq(d->cc, extract_cc(op)); \
+            } \
+        } \
+    } while(0)
+
+START_TEST(decoded_table_matches_instructions)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    ck_assert_int_eq(opcode_check_integrity(), 1);
+    ck_assert_uint_eq(sizeof(decoded_instr_t), 8);
+
+    check_table(instruction_direct, DIRECT);
+    check_table(instruction_prefixed, PREFIXED);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(decoded_of_instruction)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    const instruction_t ld_b_c = OP_LD_B_C;
+    const instruction_t jr_nz = OP_JR_NZ_E8;
+    const instruction_t bit_3_e = OP_BIT_3_E;
+
+    ck_assert_ptr_eq(decoded_of(&ld_b_c), &instruction_decoded[0x41]);
+    ck_assert_int_eq(decoded_of(&ld_b_c)->r_dst, REG_B_CODE);
+    ck_assert_int_eq(decoded_of(&ld_b_c)->r_src, REG_C_CODE);
+
+    ck_assert_int_eq(decoded_of(&jr_nz)->family, JR_CC_E8);
+    ck_assert_int_eq(decoded_of(&jr_nz)->cc, 0);
+    ck_assert_int_eq(decoded_of(&jr_nz)->xtra_cycles, 1);
+
+    ck_assert_ptr_eq(decoded_of(&bit_3_e), &instruction_decoded[256 + 0x5B]);
+    ck_assert_int_eq(decoded_of(&bit_3_e)->r_dst, 3);
+    ck_assert_int_eq(decoded_of(&bit_3_e)->r_src, REG_E_CODE);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ================================================================================
+Suite* opcode_decode_test_suite()
+{
+    Suite* s = suite_create("opcode-decode.c tests");
+
+    Add_Case(s, tc1, "Decoded table tests");
+    tcase_add_test(tc1, decoded_table_matches_instructions);
+    tcase_add_test(tc1, decoded_of_instruction);
+
+    return s;
+}
+
+TEST_SUITE(opcode_decode_test_suite)
@@ -0,0 +1,246 @@
+/**
+ * @file unit-test-predecode.c
+ * @brief Unit test code for the predecoded instruction cache
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+
+#include "tests.h"
+#include "bus.h"
+#include "component.h"
+#include "predecode.h"
+#include "error.h"
+#include "util.h"
+
+#define ROM_SIZE  (PREDECODE_END + 1)
+#define BANK_SIZE 0x100
+#define RAM_START 0xC000
+#define RAM_SIZE  0x100
+
+#define INIT \
+    bus_t bus; \
+    zero_init_var(bus); \
+    component_t rom; \
+    zero_init_var(rom); \
+    component_t ram; \
+    zero_init_var(ram); \
+    predecode_t cache; \
+    ck_assert_int_eq(predecode_init(&cache), ERR_NONE); \
+    ck_assert_int_eq(component_create(&rom, ROM_SIZE), ERR_NONE); \
+    ck_assert_int_eq(component_create(&ram, RAM_SIZE), ERR_NONE); \
+    ck_assert_int_eq(bus_plug(bus, &rom, 0, PREDECODE_END), ERR_NONE); \
+    ck_assert_int_eq(bus_plug(bus, &ram, RAM_START, RAM_START + RAM_SIZE - 1), ERR_NONE)
+
+#define FREE \
+    do { \
+        component_free(&rom); \
+        component_free(&ram); \
+    } while(0)
+
+/**
+ * @brief writes an instruction of up to 3 bytes directly into a component
+ */
+#define poke3(c, addr, b0, b1, b2) \
+    do { \
+        (c).mem->memory[(addr)] = (b0); \
+        (c).mem->memory[(addr) + 1] = (b1); \
+        (c).mem->memory[(addr) + 2] = (b2); \
+    } while(0)
+
+START_TEST(predecode_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    ck_assert_int_eq(predecode_init(NULL), ERR_BAD_PARAMETER);
+    ck_assert_ptr_null(predecode_fetch(NULL, bus, 0x100));
+    ck_assert_ptr_null(predecode_fetch(&cache, NULL, 0x100));
+
+    // must not crash
+    predecode_invalidate(NULL);
+    predecode_invalidate_addr(NULL, 0x100);
+    predecode_invalidate_addr(&cache, 0);
+    predecode_invalidate_addr(&cache, 0xFFFF);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(predecode_fetch_rom)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    poke3(rom, 0x100, 0xC3, 0x50, 0x01); // JP 0x0150
+    poke3(rom, 0x103, 0xCB, 0x11, 0x00); // RL C
+    poke3(rom, 0x105, 0x3E, 0x42, 0x00); // LD A, 0x42
+
+    const predecode_entry_t* e = predecode_fetch(&cache, bus, 0x100);
+    ck_assert_ptr_nonnull(e);
+    ck_assert_ptr_eq(e->instr, &instruction_direct[0xC3]);
+    ck_assert_int_eq(e->pc, 0x100);
+    ck_assert_int_eq(e->imm8, 0x50);
+    addr_t imm16 = 0;
+    ck_assert_int_eq(bus_read16(bus, 0x101, &imm16), ERR_NONE);
+    ck_assert_int_eq(e->imm16, imm16);
+
+    e = predecode_fetch(&cache, bus, 0x103);
+    ck_assert_ptr_nonnull(e);
+    ck_assert_ptr_eq(e->instr, &instruction_prefixed[0x11]);
+
+    e = predecode_fetch(&cache, bus, 0x105);
+    ck_assert_ptr_nonnull(e);
+    ck_assert_ptr_eq(e->instr, &instruction_direct[0x3E]);
+    ck_assert_int_eq(e->imm8, 0x42);
+
+    // same direct-mapped entry, other address
+    poke3(rom, 0x105 + PREDECODE_SIZE, 0x00, 0x00, 0x00); // NOP
+    e = predecode_fetch(&cache, bus, 0x105 + PREDECODE_SIZE);
+    ck_assert_ptr_nonnull(e);
+    ck_assert_ptr_eq(e->instr, &instruction_direct[0x00]);
+    e = predecode_fetch(&cache, bus, 0x105);
+    ck_assert_ptr_eq(e->instr, &instruction_direct[0x3E]);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(predecode_not_cached)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    // RAM
+    poke3(ram, 0, 0x00, 0x00, 0x00);
+    ck_assert_ptr_null(predecode_fetch(&cache, bus, RAM_START));
+
+    // nothing plugged
+    ck_assert_ptr_null(predecode_fetch(&cache, bus, 0xFFFF));
+
+    // operands outside of ROM
+    rom.mem->memory[PREDECODE_END - 1] = 0xC3; // JP n16
+    ck_assert_ptr_null(predecode_fetch(&cache, bus, PREDECODE_END - 1));
+    rom.mem->memory[PREDECODE_END] = 0x00; // NOP
+    ck_assert_ptr_nonnull(predecode_fetch(&cache, bus, PREDECODE_END));
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(predecode_invalidation)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    poke3(rom, 0x200, 0x3E, 0x42, 0x00); // LD A, 0x42
+    const predecode_entry_t* e = predecode_fetch(&cache, bus, 0x200);
+    ck_assert_int_eq(e->imm8, 0x42);
+
+    // written without telling the cache: still the old instruction
+    ck_assert_int_eq(bus_write(bus, 0x201, 0x24), ERR_NONE);
+    e = predecode_fetch(&cache, bus, 0x200);
+    ck_assert_int_eq(e->imm8, 0x42);
+
+    // write to an operand
+    predecode_invalidate_addr(&cache, 0x201);
+    e = predecode_fetch(&cache, bus, 0x200);
+    ck_assert_int_eq(e->imm8, 0x24);
+
+    // write to the opcode
+    ck_assert_int_eq(bus_write(bus, 0x200, 0x06), ERR_NONE); // LD B, n8
+    predecode_invalidate_addr(&cache, 0x200);
+    e = predecode_fetch(&cache, bus, 0x200);
+    ck_assert_ptr_eq(e->instr, &instruction_direct[0x06]);
+
+    // whole cache
+    ck_assert_int_eq(bus_write(bus, 0x200, 0x0E), ERR_NONE); // LD C, n8
+    predecode_invalidate(&cache);
+    e = predecode_fetch(&cache, bus, 0x200);
+    ck_assert_ptr_eq(e->instr, &instruction_direct[0x0E]);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(predecode_bank_switch)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+    component_t bank;
+    zero_init_var(bank);
+    ck_assert_int_eq(component_create(&bank, BANK_SIZE), ERR_NONE);
+
+    poke3(rom, 0x10, 0x3E, 0x01, 0x00);  // LD A, 1
+    poke3(bank, 0x10, 0x06, 0x02, 0x00); // LD B, 2
+
+    const predecode_entry_t* e = predecode_fetch(&cache, bus, 0x10);
+    ck_assert_ptr_eq(e->instr, &instruction_direct[0x3E]);
+
+    // the bank is mapped over the ROM (as the boot ROM)
+    ck_assert_int_eq(bus_forced_plug(bus, &bank, 0, BANK_SIZE - 1, 0), ERR_NONE);
+    e = predecode_fetch(&cache, bus, 0x10);
+    ck_assert_ptr_eq(e->instr, &instruction_direct[0x06]);
+    ck_assert_int_eq(e->imm8, 0x02);
+
+    // and unmapped
+    ck_assert_int_eq(bus_unplug(bus, &bank), ERR_NONE);
+    ck_assert_ptr_null(predecode_fetch(&cache, bus, 0x10));
+    ck_assert_int_eq(bus_forced_plug(bus, &rom, 0, PREDECODE_END, 0), ERR_NONE);
+    e = predecode_fetch(&cache, bus, 0x10);
+    ck_assert_ptr_eq(e->instr, &instruction_direct[0x3E]);
+    ck_assert_int_eq(e->imm8, 0x01);
+
+    component_free(&bank);
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ================================================================================
+Suite* predecode_test_suite()
+{
+    Suite* s = suite_create("predecode.c tests");
+
+    Add_Case(s, tc1, "Predecode cache tests");
+    tcase_add_test(tc1, predecode_err);
+    tcase_add_test(tc1, predecode_fetch_rom);
+    tcase_add_test(tc1, predecode_not_cached);
+    tcase_add_test(tc1, predecode_invalidation);
+    tcase_add_test(tc1, predecode_bank_switch);
+
+    return s;
+}
+
+TEST_SUITE(predecode_test_suite)
@@ -0,0 +1,250 @@
+/**
+ * @file unit-test-serial.c
+ * @brief Unit test code for the serial port
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "util.h"
+#include "tests.h"
+#include "serial.h"
+#include "cpu.h"
+#include "bus.h"
+
+// placed here to prevent an include loop
+#include "cpu-storage.h"
+
+#define INIT \
+    serial_t serial; \
+    cpu_t cpu; \
+    zero_init_var(serial); \
+    zero_init_var(cpu)
+
+#define register(X) \
+    data_t reg_ ## X ## _var = 0; \
+    bus[REG_ ## X] = &reg_ ## X ## _var
+
+#define INIT_BUS \
+    bus_t bus; \
+    zero_init_var(bus); \
+    register(SB); \
+    register(SC); \
+    cpu.bus = &bus
+
+// SC values
+#define SC_INTERNAL 0x81
+#define SC_EXTERNAL 0x80
+
+#define START_CYCLE 100
+
+/**
+ * @brief sends a byte as the CPU does (SB, then SC)
+ */
+static void send(serial_t* serial, cpu_t* cpu, data_t byte, data_t sc, uint64_t cycle)
+{
+    ck_assert_err_none(cpu_write_at_idx(cpu, REG_SB, byte));
+    ck_assert_err_none(serial_bus_listener(serial, REG_SB, cycle));
+    ck_assert_err_none(cpu_write_at_idx(cpu, REG_SC, sc));
+    ck_assert_err_none(serial_bus_listener(serial, REG_SC, cycle));
+}
+
+/**
+ * @brief sink counting the bytes given and keeping the last one
+ */
+typedef struct {
+    size_t count;
+    data_t last;
+} sink_state_t;
+
+static void sink(void* opaque, data_t byte)
+{
+    sink_state_t* state = opaque;
+    ++(state->count);
+    state->last = byte;
+}
+
+START_TEST(serial_init_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+    ck_assert_bad_param(serial_init(NULL, NULL));
+    ck_assert_bad_param(serial_init(NULL, &cpu));
+    ck_assert_bad_param(serial_init(&serial, NULL));
+    ck_assert_bad_param(serial_reset(NULL));
+    ck_assert_bad_param(serial_set_sink(NULL, sink, NULL));
+    ck_assert_bad_param(serial_cycle(NULL, 0));
+    ck_assert_bad_param(serial_bus_listener(NULL, REG_SC, 0));
+    ck_assert_ptr_null(serial_output(NULL, NULL));
+
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(serial_init_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+    size_t length = 1;
+    ck_assert_err_none(serial_init(&serial, &cpu));
+    ck_assert_ptr_eq(serial.cpu, &cpu);
+    ck_assert_ptr_null(serial.sink);
+    ck_assert_int_eq(serial.end, UINT64_MAX);
+    ck_assert_str_eq(serial_output(&serial, &length), "");
+    ck_assert_int_eq(length, 0);
+
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(serial_transfer_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+    INIT_BUS;
+    sink_state_t state;
+    zero_init_var(state);
+    size_t length = 0;
+    ck_assert_err_none(serial_init(&serial, &cpu));
+    ck_assert_err_none(serial_set_sink(&serial, sink, &state));
+
+    send(&serial, &cpu, 'O', SC_INTERNAL, START_CYCLE);
+    ck_assert_int_eq(serial.end, START_CYCLE + SERIAL_TRANSFER_CYCLES);
+    ck_assert_int_eq(state.count, 1);
+    ck_assert_int_eq(state.last, 'O');
+
+    // not over before its end
+    ck_assert_err_none(serial_cycle(&serial, START_CYCLE + SERIAL_TRANSFER_CYCLES - 1));
+    ck_assert_int_eq(reg_SB_var, 'O');
+    ck_assert_int_eq(reg_SC_var, SC_INTERNAL);
+    ck_assert_int_eq(bit_get(cpu.IF, SERIAL), 0);
+
+    cpu.write_listener = 0;
+    ck_assert_err_none(serial_cycle(&serial, START_CYCLE + SERIAL_TRANSFER_CYCLES));
+    ck_assert_int_eq(reg_SB_var, 0xFF);
+    ck_assert_int_eq(reg_SC_var, SC_INTERNAL & ~(1 << SC_START_BIT));
+    ck_assert_int_eq(bit_get(cpu.IF, SERIAL), 1);
+    ck_assert_int_eq(serial.end, UINT64_MAX);
+    // written as from the hardware
+    ck_assert_int_eq(cpu.write_listener, 0);
+
+    send(&serial, &cpu, 'K', SC_INTERNAL, 2 * START_CYCLE);
+    ck_assert_str_eq(serial_output(&serial, &length), "OK");
+    ck_assert_int_eq(length, 2);
+    ck_assert_int_eq(state.count, 2);
+
+    // the sink is kept by a reset, not the bytes
+    ck_assert_err_none(serial_reset(&serial));
+    ck_assert_str_eq(serial_output(&serial, &length), "");
+    ck_assert_int_eq(serial.end, UINT64_MAX);
+    send(&serial, &cpu, '!', SC_INTERNAL, START_CYCLE);
+    ck_assert_int_eq(state.count, 3);
+
+    ck_assert_err_none(serial_set_sink(&serial, NULL, &state));
+    ck_assert_ptr_null(serial.opaque);
+
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(serial_external_clock_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+    INIT_BUS;
+    size_t length = 1;
+    ck_assert_err_none(serial_init(&serial, &cpu));
+
+    // waits for the other side, which never comes
+    send(&serial, &cpu, 'X', SC_EXTERNAL, START_CYCLE);
+    ck_assert_int_eq(serial.end, UINT64_MAX);
+    ck_assert_err_none(serial_cycle(&serial, UINT64_MAX - 1));
+    ck_assert_int_eq(reg_SB_var, 'X');
+    ck_assert_int_eq(reg_SC_var, SC_EXTERNAL);
+    ck_assert_int_eq(cpu.IF, 0);
+    ck_assert_str_eq(serial_output(&serial, &length), "");
+    ck_assert_int_eq(length, 0);
+
+    // stopped by the CPU
+    send(&serial, &cpu, 'Y', SC_INTERNAL, START_CYCLE);
+    ck_assert_err_none(cpu_write_at_idx(&cpu, REG_SC, 0));
+    ck_assert_err_none(serial_bus_listener(&serial, REG_SC, START_CYCLE + 1));
+    ck_assert_int_eq(serial.end, UINT64_MAX);
+
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(serial_output_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+    INIT_BUS;
+    sink_state_t state;
+    zero_init_var(state);
+    size_t length = 0;
+    ck_assert_err_none(serial_init(&serial, &cpu));
+    ck_assert_err_none(serial_set_sink(&serial, sink, &state));
+
+    // bounded, the sink still given everything
+    for(size_t i = 0; i < SERIAL_OUTPUT_SIZE + 10; ++i) {
+        send(&serial, &cpu, 'a', SC_INTERNAL, START_CYCLE);
+    }
+    const char* output = serial_output(&serial, &length);
+    ck_assert_int_eq(length, SERIAL_OUTPUT_SIZE);
+    ck_assert_int_eq(strlen(output), SERIAL_OUTPUT_SIZE);
+    ck_assert_int_eq(state.count, SERIAL_OUTPUT_SIZE + 10);
+
+    serial_output_clear(&serial);
+    ck_assert_str_eq(serial_output(&serial, &length), "");
+    ck_assert_int_eq(length, 0);
+    serial_output_clear(NULL);
+
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ======================================================================
+Suite* serial_test_suite()
+{
+    Suite* s = suite_create("serial.c Tests");
+
+    Add_Case(s, tc1, "Serial Tests");
+    tcase_add_test(tc1, serial_init_err);
+    tcase_add_test(tc1, serial_init_exec);
+    tcase_add_test(tc1, serial_transfer_exec);
+    tcase_add_test(tc1, serial_external_clock_exec);
+    tcase_add_test(tc1, serial_output_exec);
+
+    return s;
+}
+
+TEST_SUITE(serial_test_suite)
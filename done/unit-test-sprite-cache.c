@@ -0,0 +1,173 @@
+/**
+ * @file unit-test-sprite-cache.c
+ * @brief Unit test code for the per-line sprite selection cache
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "tests.h"
+#include "bus.h"
+#include "component.h"
+#include "sprite_cache.h"
+#include "error.h"
+#include "util.h"
+
+#define OAM_SIZE (SPRITE_CACHE_END - SPRITE_CACHE_START + 1)
+
+#define INIT \
+    bus_t bus; \
+    zero_init_var(bus); \
+    component_t oam; \
+    zero_init_var(oam); \
+    sprite_cache_t* cache = malloc(sizeof(sprite_cache_t)); \
+    ck_assert_ptr_nonnull(cache); \
+    ck_assert_int_eq(sprite_cache_init(cache), ERR_NONE); \
+    ck_assert_int_eq(component_create(&oam, OAM_SIZE), ERR_NONE); \
+    ck_assert_int_eq(bus_plug(bus, &oam, SPRITE_CACHE_START, SPRITE_CACHE_END), ERR_NONE)
+
+#define FREE \
+    do { \
+        component_free(&oam); \
+        free(cache); \
+    } while(0)
+
+/**
+ * @brief writes the coordinates of a sprite directly into OAM
+ *        (as shown on the screen)
+ */
+#define poke_sprite(i, x, y) \
+    do { \
+        oam.mem->memory[4 * (i)] = (data_t)((y) + 16); \
+        oam.mem->memory[4 * (i) + 1] = (data_t)((x) + 8); \
+    } while(0)
+
+START_TEST(sprite_cache_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    ck_assert_int_eq(sprite_cache_init(NULL), ERR_BAD_PARAMETER);
+
+    ck_assert_ptr_null(sprite_cache_line(NULL, bus, 0, 8));
+    ck_assert_ptr_null(sprite_cache_line(cache, NULL, 0, 8));
+    ck_assert_ptr_null(sprite_cache_line(cache, bus, SPRITE_CACHE_LINES, 8));
+
+    // must not crash
+    sprite_cache_invalidate(NULL);
+    sprite_cache_invalidate_addr(NULL, SPRITE_CACHE_START);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(sprite_cache_select)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    // all off screen (Y = 0) but:
+    poke_sprite(5, 30, 10);
+    poke_sprite(3, 20, 12);
+    poke_sprite(7, 20, 17);
+
+    const sprite_cache_line_t* line = sprite_cache_line(cache, bus, 9, 8);
+    ck_assert_ptr_nonnull(line);
+    ck_assert_int_eq(line->nb, 0);
+
+    // by X, then by OAM index
+    line = sprite_cache_line(cache, bus, 12, 8);
+    ck_assert_int_eq(line->nb, 2);
+    ck_assert_int_eq(line->index[0], 3);
+    ck_assert_int_eq(line->index[1], 5);
+
+    line = sprite_cache_line(cache, bus, 18, 8);
+    ck_assert_int_eq(line->nb, 2);
+    ck_assert_int_eq(line->index[0], 3);
+    ck_assert_int_eq(line->index[1], 7);
+
+    line = sprite_cache_line(cache, bus, 20, 8);
+    ck_assert_int_eq(line->nb, 1);
+    ck_assert_int_eq(line->index[0], 7);
+
+    // taller sprites
+    line = sprite_cache_line(cache, bus, 25, 16);
+    ck_assert_int_eq(line->nb, 3);
+    ck_assert_int_eq(line->index[0], 3);
+    ck_assert_int_eq(line->index[1], 7);
+    ck_assert_int_eq(line->index[2], 5);
+
+    // only the first SPRITE_CACHE_PER_LINE ones of OAM
+    for(int i = 10; i < SPRITE_CACHE_NB_SPRITES; ++i) {
+        poke_sprite(i, 0, 100);
+    }
+    sprite_cache_invalidate(cache);
+    line = sprite_cache_line(cache, bus, 100, 8);
+    ck_assert_int_eq(line->nb, SPRITE_CACHE_PER_LINE);
+    for(int k = 0; k < SPRITE_CACHE_PER_LINE; ++k) {
+        ck_assert_int_eq(line->index[k], 10 + k);
+    }
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(sprite_cache_invalidation)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    poke_sprite(0, 0, 40);
+    ck_assert_int_eq(sprite_cache_line(cache, bus, 40, 8)->nb, 1);
+
+    // not reported: still the old lines
+    poke_sprite(0, 0, 50);
+    ck_assert_int_eq(sprite_cache_line(cache, bus, 40, 8)->nb, 1);
+
+    // not in OAM
+    sprite_cache_invalidate_addr(cache, SPRITE_CACHE_END + 1);
+    ck_assert_int_eq(sprite_cache_line(cache, bus, 40, 8)->nb, 1);
+
+    sprite_cache_invalidate_addr(cache, SPRITE_CACHE_START);
+    ck_assert_int_eq(sprite_cache_line(cache, bus, 40, 8)->nb, 0);
+    ck_assert_int_eq(sprite_cache_line(cache, bus, 50, 8)->nb, 1);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ================================================================================
+Suite* sprite_cache_test_suite()
+{
+    Suite* s = suite_create("sprite_cache.c tests");
+
+    Add_Case(s, tc1, "Sprite cache tests");
+    tcase_add_test(tc1, sprite_cache_err);
+    tcase_add_test(tc1, sprite_cache_select);
+    tcase_add_test(tc1, sprite_cache_invalidation);
+
+    return s;
+}
+
+TEST_SUITE(sprite_cache_test_suite)
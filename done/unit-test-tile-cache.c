@@ -0,0 +1,168 @@
+/**
+ * @file unit-test-tile-cache.c
+ * @brief Unit test code for the decoded tile cache
+ *
+ * @date 2020
+ */
+
+#include <check.h>
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "tests.h"
+#include "bus.h"
+#include "component.h"
+#include "tile_cache.h"
+#include "error.h"
+#include "util.h"
+
+#define VRAM_SIZE (TILE_CACHE_END - TILE_CACHE_START + 1)
+
+/**
+ * @brief address of row y of a tile
+ */
+#define ROW(tile, y) ((addr_t)(TILE_CACHE_START + (tile) * 16 + (y) * 2))
+
+#define INIT \
+    bus_t bus; \
+    zero_init_var(bus); \
+    component_t vram; \
+    zero_init_var(vram); \
+    tile_cache_t* cache = malloc(sizeof(tile_cache_t)); \
+    ck_assert_ptr_nonnull(cache); \
+    ck_assert_int_eq(tile_cache_init(cache), ERR_NONE); \
+    ck_assert_int_eq(component_create(&vram, VRAM_SIZE), ERR_NONE); \
+    ck_assert_int_eq(bus_plug(bus, &vram, TILE_CACHE_START, TILE_CACHE_END), ERR_NONE)
+
+#define FREE \
+    do { \
+        component_free(&vram); \
+        free(cache); \
+    } while(0)
+
+/**
+ * @brief writes a row (lsb then msb bytes) directly into the video RAM
+ */
+#define poke_row(tile, y, lsb, msb) \
+    do { \
+        vram.mem->memory[ROW(tile, y) - TILE_CACHE_START] = (lsb); \
+        vram.mem->memory[ROW(tile, y) - TILE_CACHE_START + 1] = (msb); \
+    } while(0)
+
+START_TEST(tile_cache_err)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    ck_assert_int_eq(tile_cache_init(NULL), ERR_BAD_PARAMETER);
+
+    tile_row_t row = tile_cache_row(NULL, bus, ROW(0, 0), 0);
+    ck_assert_int_eq(row.msb | row.lsb, 0);
+    row = tile_cache_row(cache, NULL, ROW(0, 0), 0);
+    ck_assert_int_eq(row.msb | row.lsb, 0);
+    row = tile_cache_row(cache, bus, TILE_CACHE_END + 1, 0);
+    ck_assert_int_eq(row.msb | row.lsb, 0);
+    row = tile_row_decode(NULL, ROW(0, 0), 0);
+    ck_assert_int_eq(row.msb | row.lsb, 0);
+
+    // must not crash
+    tile_cache_invalidate(NULL);
+    tile_cache_invalidate_addr(NULL, TILE_CACHE_START);
+    tile_cache_invalidate_addr(cache, 0);
+    tile_cache_invalidate_addr(cache, 0xFFFF);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(tile_cache_decode)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    poke_row(0, 0, 0x80, 0x01);
+    poke_row(383, 7, 0xF0, 0x0C);
+
+    // leftmost pixel in bit 0
+    tile_row_t row = tile_cache_row(cache, bus, ROW(0, 0), 0);
+    ck_assert_int_eq(row.lsb, 0x01);
+    ck_assert_int_eq(row.msb, 0x80);
+    row = tile_cache_row(cache, bus, ROW(0, 0), 1);
+    ck_assert_int_eq(row.lsb, 0x80);
+    ck_assert_int_eq(row.msb, 0x01);
+
+    row = tile_cache_row(cache, bus, ROW(383, 7), 0);
+    ck_assert_int_eq(row.lsb, 0x0F);
+    ck_assert_int_eq(row.msb, 0x30);
+    row = tile_cache_row(cache, bus, ROW(383, 7), 1);
+    ck_assert_int_eq(row.lsb, 0xF0);
+    ck_assert_int_eq(row.msb, 0x0C);
+
+    // same as without cache
+    row = tile_row_decode(bus, ROW(383, 7), 0);
+    ck_assert_int_eq(row.lsb, 0x0F);
+    ck_assert_int_eq(row.msb, 0x30);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+START_TEST(tile_cache_invalidation)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+
+    poke_row(1, 3, 0x80, 0x00);
+    poke_row(2, 0, 0x80, 0x00);
+    ck_assert_int_eq(tile_cache_row(cache, bus, ROW(1, 3), 0).lsb, 0x01);
+    ck_assert_int_eq(tile_cache_row(cache, bus, ROW(2, 0), 0).lsb, 0x01);
+
+    // not reported: still the old rows
+    poke_row(1, 3, 0x40, 0x00);
+    poke_row(2, 0, 0x40, 0x00);
+    ck_assert_int_eq(tile_cache_row(cache, bus, ROW(1, 3), 0).lsb, 0x01);
+
+    // any byte of the tile makes it dirty, but not the other tiles
+    tile_cache_invalidate_addr(cache, ROW(1, 7) + 1);
+    ck_assert_int_eq(tile_cache_row(cache, bus, ROW(1, 3), 0).lsb, 0x02);
+    ck_assert_int_eq(tile_cache_row(cache, bus, ROW(2, 0), 0).lsb, 0x01);
+
+    tile_cache_invalidate(cache);
+    ck_assert_int_eq(tile_cache_row(cache, bus, ROW(2, 0), 0).lsb, 0x02);
+
+    FREE;
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+}
+END_TEST
+
+// ================================================================================
+Suite* tile_cache_test_suite()
+{
+    Suite* s = suite_create("tile_cache.c tests");
+
+    Add_Case(s, tc1, "Tile cache tests");
+    tcase_add_test(tc1, tile_cache_err);
+    tcase_add_test(tc1, tile_cache_decode);
+    tcase_add_test(tc1, tile_cache_invalidation);
+
+    return s;
+}
+
+TEST_SUITE(tile_cache_test_suite)
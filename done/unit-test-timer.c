@@ -22,6 +22,9 @@
 #include "cpu.h"
 #include "bus.h"
 
+// placed here to prevent an include loop
+#include "cpu-storage.h"
+
 #define INIT \
     gbtimer_t timer; \
     cpu_t cpu; \
@@ -133,6 +136,41 @@ START_TEST(timer_cycle_exec)
 }
 END_TEST
 
+START_TEST(timer_div_read_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+    INIT_BUS;
+    bus_io_t io;
+    zero_init_var(io);
+    cpu.io = &io;
+    ck_assert_err_none(timer_init(&timer, &cpu));
+    ck_assert_ptr_eq(io[REG_DIV - BUS_IO_START].owner, &timer);
+
+    for (size_t i = 0; i < CYCLE_COUNT_3FFF; ++i) {
+        timer_cycle(&timer);
+    }
+
+    // computed when read, not written into the bus
+    ck_assert_int_eq(cpu_read_at_idx(&cpu, REG_DIV), CYCLE_DIV_VALUE);
+    ck_assert_int_eq(*bus[REG_DIV], 0);
+    ck_assert_int_eq(cpu.write_listener, 0);
+
+    ck_assert_err_none(cpu_write_at_idx(&cpu, REG_DIV, 0x12));
+    ck_assert_err_none(timer_bus_listener(&timer, REG_DIV));
+    ck_assert_int_eq(cpu_read_at_idx(&cpu, REG_DIV), 0);
+    ck_assert_err_none(timer_catch_up(&timer, 0x200));
+    ck_assert_int_eq(cpu_read_at_idx(&cpu, REG_DIV), 0x08);
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+
+}
+END_TEST
+
 START_TEST(timer_listener_err)
 {
 // ------------------------------------------------------------
@@ -174,6 +212,117 @@ START_TEST(timer_listener_exec)
 }
 END_TEST
 
+#define QUIET_MAX 0x1000
+
+START_TEST(timer_quiet_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+    ck_assert_err_none(timer_init(&timer, &cpu));
+
+    INIT_BUS;
+
+    ck_assert_int_eq(timer_quiet_cycles(NULL, 0, QUIET_MAX), 0);
+    ck_assert_bad_param(timer_fast_forward(NULL, 1));
+
+    // TIMA stopped, DIV not looked at: always quiet
+    *bus[REG_TAC] = 0;
+    ck_assert_int_eq(timer_quiet_cycles(&timer, 0, QUIET_MAX), QUIET_MAX);
+
+    for (data_t tac = 0; tac < 8; ++tac) {
+        for (bit_t with_div = 0; with_div <= 1; ++with_div) {
+            for (uint16_t start = 0; start < 0x400; start += 0x34) {
+                *bus[REG_TAC] = (data_t)(tac | 0x4);
+                *bus[REG_TIMA] = 0;
+                *bus[REG_DIV] = msb8(start);
+                cpu.IF = 0;
+                timer.counter = start;
+
+                const uint64_t n = timer_quiet_cycles(&timer, with_div, QUIET_MAX);
+                ck_assert_uint_lt(n, QUIET_MAX);
+
+                // quiet: the same as n cycles, and nothing visible changed
+                gbtimer_t ffwd = timer;
+                ck_assert_err_none(timer_fast_forward(&ffwd, n));
+                const data_t div = *bus[REG_DIV];
+                for (uint64_t i = 0; i < n; ++i) {
+                    timer_cycle(&timer);
+                }
+                ck_assert_int_eq(timer.counter, ffwd.counter);
+                ck_assert_int_eq(*bus[REG_TIMA], 0);
+                ck_assert_int_eq(cpu.IF, 0);
+                if (with_div) {
+                    ck_assert_int_eq(*bus[REG_DIV], div);
+                }
+
+                // but not one cycle more
+                timer_cycle(&timer);
+                ck_assert(*bus[REG_TIMA] != 0 || (with_div && *bus[REG_DIV] != div));
+            }
+        }
+    }
+
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+
+}
+END_TEST
+
+
+START_TEST(timer_catch_up_exec)
+{
+// ------------------------------------------------------------
+#ifdef WITH_PRINT
+    printf("=== %s:\n", __func__);
+#endif
+    INIT;
+    ck_assert_err_none(timer_init(&timer, &cpu));
+
+    INIT_BUS;
+
+    ck_assert_bad_param(timer_catch_up(NULL, 1));
+
+    // same TIMA, IF and DIV as cycle after cycle, at the end
+    for (data_t tac = 0; tac < 8; ++tac) {
+        for (uint16_t start = 0; start < 0x800; start += 0x74) {
+            for (uint64_t cycles = 0; cycles < 600; cycles += 113) {
+                *bus[REG_TAC] = tac;
+                *bus[REG_TMA] = 0xF0;
+                *bus[REG_TIMA] = 0xFE;
+                *bus[REG_DIV] = msb8(start);
+                cpu.IF = 0;
+                timer.counter = start;
+
+                gbtimer_t other = timer;
+                for (uint64_t i = 0; i < cycles; ++i) {
+                    timer_cycle(&timer);
+                }
+                const data_t tima = *bus[REG_TIMA];
+                const data_t div = *bus[REG_DIV];
+                const data_t IF = cpu.IF;
+
+                *bus[REG_TIMA] = 0xFE;
+                cpu.IF = 0;
+                ck_assert_err_none(timer_catch_up(&other, cycles));
+                ck_assert_int_eq(other.counter, timer.counter);
+                ck_assert_int_eq(*bus[REG_TIMA], tima);
+                ck_assert_int_eq(*bus[REG_DIV], div);
+                ck_assert_int_eq(cpu.IF, IF);
+            }
+        }
+    }
+
+#ifdef WITH_PRINT
+    printf("=== END of %s\n", __func__);
+#endif
+
+}
+END_TEST
+
 
 // ======================================================================
 Suite* timer_test_suite()
@@ -193,8 +342,11 @@ Suite* timer_test_suite()
 
     tcase_add_test(tc1, timer_cycle_err);
     tcase_add_test(tc1, timer_cycle_exec);
+    tcase_add_test(tc1, timer_div_read_exec);
     tcase_add_test(tc1, timer_listener_err);
     tcase_add_test(tc1, timer_listener_exec);
+    tcase_add_test(tc1, timer_quiet_exec);
+    tcase_add_test(tc1, timer_catch_up_exec);
 
     return s;
 }